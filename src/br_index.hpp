@@ -1,6 +1,13 @@
 /*
  * bi-directional r-index 
  *  the simpler implementation
+ *
+ *  Every query (count, locate, search_with_mismatch, seed_and_extend, the batch
+ *  API, LF, Phi, ...) is a const member function without hidden state, so after
+ *  construction or load() one index can be shared as a const reference by any
+ *  number of threads. Construction, load(), assignment and set_cache() must
+ *  not overlap with queries. The only state changed by queries is the optional
+ *  sample cache (set_cache), which locks itself.
  */
 
 #ifndef INCLUDED_BR_INDEX_HPP
@@ -10,6 +17,16 @@
 #include "rle_string.hpp"
 #include "sparse_sd_vector.hpp"
 #include "permuted_lcp.hpp"
+#include "bwt_runs.hpp"
+#include "prefix_free_parse.hpp"
+#include "mapped_text.hpp"
+#include "remapped_view.hpp"
+#include "external_bwt.hpp"
+#include "build_config.hpp"
+#include "qgram_table.hpp"
+#include "sample_cache.hpp"
+#include "parallel_sa.hpp"
+#include "radix_sort.hpp"
 #include "utils.hpp"
 
 namespace bri {
@@ -55,13 +72,13 @@ struct br_sample {
     }
 
     // the pattern does not exist
-    bool is_invalid()
+    bool is_invalid() const
     {
         return (range.first > range.second) || (rangeR.first > rangeR.second);
     }
 
     // range size
-    ulint size()
+    ulint size() const
     {
         return range.second + 1 - range.first;
     }
@@ -69,7 +86,7 @@ struct br_sample {
 
 template<
     class sparse_bitvector_t = sparse_sd_vector,
-    class rle_string_t = rle_string_sd 
+    class rle_string_t = rle_string_default
 >
 class br_index {
 
@@ -84,11 +101,46 @@ public:
      * \param input: string on which br-index is built
      * \param sais: flag determining if we use SAIS for suffix sort. 
      *              otherwise we use divsufsort
+     * \param derive_rev: derive BWT^R from BWT instead of suffix sorting textR
+     * \param bc: directory of the cache files & RAM budget. over the budget,
+     *            textR is sorted after text and then SAIS replaces divsufsort.
+     *            if bc.in_memory, SA is built by divsufsort in RAM without cache files.
+     *            if bc.threads > 1, SA is built in RAM by the parallel sorter and
+     *            text and textR are sorted one after the other, each by all threads
      */
-    br_index(std::string const& input, bool sais = true)
+    br_index(std::string const& input, bool sais = true, bool derive_rev = false,
+             build_config const& bc = build_config())
+    {
+        this->sais = sais;
+        build_from_text(input, derive_rev, bc);
+    }
+
+    /*
+     * constructor on a memory-mapped text file: the text is neither read into
+     * RAM nor copied, the remapped text and textR are views of the mapping.
+     * parameters as above
+     */
+    br_index(mapped_text const& input, bool sais = true, bool derive_rev = false,
+             build_config const& bc = build_config())
     {
-        
         this->sais = sais;
+        build_from_text(input, derive_rev, bc);
+    }
+
+    /*
+     * constructor using prefix-free parsing.
+     * neither SA nor ISA is built; the BWTs, their SA samples and PLCP
+     * are computed from the dictionary and the parse.
+     * \param input_file: text file on which br-index is built (memory-mapped)
+     * \param cfg: window size and modulus of the trigger strings
+     * \param derive_rev: derive BWT^R from BWT instead of parsing the reversed text
+     * \param bc: directory of the cache files. if bc.in_memory, the parse is sorted in RAM
+     */
+    br_index(std::string const& input_file, pfp_config const& cfg, bool derive_rev = false,
+             build_config const& bc = build_config())
+    {
+
+        mapped_text input(input_file);
 
         if (input.size() < 1)
         {
@@ -101,246 +153,270 @@ public:
         std::cout << "Text length = " << input.size() << std::endl << std::endl;
 
         std::cout << "(1/4) Remapping alphabet ... " << std::flush;
-        
-        // build RLBWT
-
-        // configure & build indexes for sufsort & plcp
-        sdsl::cache_config cc;
 
-        // remap alphabet
-        remap = std::vector<uchar>(256,0);
-        remap_inv = std::vector<uchar>(256,0);
         {
-            sigma = 1;
-            std::vector<ulint> freqs(256,0);
-            for (size_t i = 0; i < input.size(); ++i)
-            {
-                if (freqs[(uchar)input[i]]++ == 0) sigma++;
-                if (sigma >= 255)
-                {
-                    std::cout << "Error: alphabet cannot be remapped (overflow)" << std::endl;
-                    exit(1);
-                }
-            }
-            uchar new_c = 2; // avoid reserved chars
-            for (ulint c = 2; c < 256; ++c)
-            {
-                if (freqs[(uchar)c] != 0)
-                {
-                    remap[(uchar)c] = new_c;
-                    remap_inv[new_c++] = (uchar)c;
-                }
-            }
+            build_profile::phase ph(bc.profile, "remap");
+            remap_alphabet(input);
         }
 
         std::cout << "done." << std::endl;
-        std::cout << "(2/4) Building BWT, BWT^R, PLCP and computing SA samples";
-        if (sais) std::cout << " (SA-SAIS) ... " << std::flush;
-        else std::cout << " (DIVSUFSORT) ... " << std::flush;
+        std::cout << "(2/4) Building BWT, BWT^R and computing SA samples (PFP, w = "
+                  << cfg.w << ", p = " << cfg.p << ") ... " << std::flush;
 
-        // remap input text
-        sdsl::int_vector<8> text(input.size());
-        for (size_t i = 0; i < input.size(); ++i)
-            text[i] = remap[(uchar)input[i]];
+        bwt_runs runs(input.size()+1);
+        bwt_runs runsR(input.size()+1);
+        {
+            std::thread reverse_thread;
+            if (!derive_rev) reverse_thread = std::thread([&]()
+            {
+                build_profile::phase ph(bc.profile, "reverse PFP");
+                prefix_free_parse pfpR(input, remap, true, cfg);
+                pfpR.bwt(runsR, make_cache_config("rev", bc.tmp_dir), bc.in_memory);
+            });
 
-        sdsl::append_zero_symbol(text);
+            {
+                build_profile::phase ph(bc.profile, "forward PFP");
+                prefix_free_parse pfp(input, remap, false, cfg);
+                pfp.bwt(runs, make_cache_config("fwd", bc.tmp_dir), bc.in_memory);
+            }
 
-        // cache text
-        sdsl::store_to_cache(text, sdsl::conf::KEY_TEXT, cc);
-        sdsl::construct_config::byte_algo_sa = sais ? sdsl::SE_SAIS : sdsl::LIBDIVSUFSORT;
-        
-        // cache SA
-        sdsl::construct_sa<8>(cc);
-        // cache ISA 
-        sdsl::construct_isa(cc);
+            if (derive_rev)
+            {
+                build_profile::phase ph(bc.profile, "derive BWT^R");
+                derive_from_forward(runs, runsR);
+            }
+            else reverse_thread.join();
+        }
 
-        
-        sdsl::int_vector_buffer<> sa(sdsl::cache_file_name(sdsl::conf::KEY_SA, cc));
-        last_SA_val = sa[sa.size()-1];
-        auto bwt_and_samples = sufsort(text,sa);
+        last_SA_val = runs.last_SA;
 
-        plcp = permuted_lcp<>(cc);
+        build_from_runs(runs, runsR, bc);
 
-        // remove cache of text and SA
-        sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_TEXT, cc));
-        sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_SA, cc));
-        sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_ISA, cc));
+        std::cout << "Computing PLCP at irreducible positions ... " << std::flush;
 
+        {
+            build_profile::phase ph(bc.profile, "PLCP");
+            plcp = permuted_lcp<>(input, samples_first, samples_last, bc.threads);
+        }
 
+        std::cout << "done. " << std::endl << std::endl;
 
+    }
 
-        // configure & build reversed indexes for sufsort
-        sdsl::cache_config ccR;
+    /*
+     * constructor from a BWT and its SA samples at run boundaries computed
+     * by another tool (see external_bwt.hpp). no suffix is sorted:
+     * BWT^R is read as well or, if in has none, derived from BWT (experimental, see
+     * derive_reversed), and PLCP is computed
+     * on the text recovered from BWT by LF.
+     * \param in: files of BWT (and BWT^R)
+     * \param bc: profile & threads computing PLCP
+     */
+    br_index(external_bwt const& in, build_config const& bc = build_config())
+    {
 
-        sdsl::int_vector<8> textR(input.size());
-        for (ulint i = 0; i < input.size(); ++i)
-            textR[i] = remap[(uchar)input[input.size()-1-i]];
+        mapped_text bwt_text(in.bwt_file());
 
-        sdsl::append_zero_symbol(textR);
+        if (bwt_text.size() < 2)
+        {
 
-        // cache textR
-        sdsl::store_to_cache(textR, sdsl::conf::KEY_TEXT, ccR);
-        sdsl::construct_config::byte_algo_sa = sais ? sdsl::SE_SAIS : sdsl::LIBDIVSUFSORT;
-        
-        // cache SAR
-        sdsl::construct_sa<8>(ccR);
-        // cache ISAR
-        //sdsl::construct_isa(ccR);
+            std::cout << "Error: input string is empty" << std::endl;
+            exit(1);
 
-        sdsl::int_vector_buffer<> saR(sdsl::cache_file_name(sdsl::conf::KEY_SA, ccR));
-        auto bwt_and_samplesR = sufsort(textR,saR);
+        }
 
-        // plcp is not needed in the reversed case
+        ulint n = bwt_text.size();
 
-        // remove cache of textR and SAR
-        sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_TEXT, ccR));
-        sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_SA, ccR));
+        std::cout << "Text length = " << n - 1 << std::endl << std::endl;
 
+        std::cout << "(1/4) Remapping alphabet ... " << std::flush;
 
+        {
+            build_profile::phase ph(bc.profile, "remap");
+            remap_alphabet(bwt_text);
+            // the byte 0 of BWT is the terminator, not a character of the text
+            sigma--;
+        }
 
+        std::cout << "done." << std::endl;
+        std::cout << "(2/4) Reading BWT, BWT^R and their SA samples ... " << std::flush;
 
+        bwt_runs runs(n);
+        bwt_runs runsR(n);
+        {
+            build_profile::phase ph(bc.profile, "read BWT");
+            in.read_runs(bwt_text, remap, TERMINATOR, false, runs);
+        }
 
-        std::string& bwt_s = std::get<0>(bwt_and_samples);
-        std::vector<range_t>& samples_first_vec = std::get<1>(bwt_and_samples);
-        std::vector<range_t>& samples_last_vec = std::get<2>(bwt_and_samples);
+        if (in.has_reversed())
+        {
+            build_profile::phase ph(bc.profile, "read BWT^R");
 
-        std::string& bwt_sR = std::get<0>(bwt_and_samplesR);
-        std::vector<range_t>& samples_first_vecR = std::get<1>(bwt_and_samplesR);
-        std::vector<range_t>& samples_last_vecR = std::get<2>(bwt_and_samplesR);
+            mapped_text bwtR_text(in.bwt_file(true));
+            if (bwtR_text.size() != n)
+            {
+                std::cout << "Error: BWT and BWT^R differ in length" << std::endl;
+                exit(1);
+            }
+            in.read_runs(bwtR_text, remap, TERMINATOR, true, runsR);
+        }
+        else
+        {
+            build_profile::phase ph(bc.profile, "derive BWT^R");
+            derive_from_forward(runs, runsR);
+        }
 
-        std::cout << "done.\n(3/4) Run-length encoding BWT ... " << std::flush;
+        last_SA_val = runs.last_SA;
 
+        build_from_runs(runs, runsR, bc);
 
-        // run length compression on BWT and BWTR
-        bwt = rle_string_t(bwt_s);
-        bwtR = rle_string_t(bwt_sR);
+        std::cout << "Computing PLCP at irreducible positions ... " << std::flush;
 
-        // build F column (common between text and textR)
-        F = std::vector<ulint>(256,0);
+        {
+            build_profile::phase ph(bc.profile, "PLCP");
+            plcp = permuted_lcp<>(remapped_text(), samples_first, samples_last, bc.threads);
+        }
 
-        for (uchar c : bwt_s) 
-            F[c]++;
+        std::cout << "done. " << std::endl << std::endl;
 
-        for (ulint i = 255; i > 0; --i) 
-            F[i] = F[i-1];
+    }
 
-        F[0] = 0;
+    /*
+     * constructor merging two indexes into the index of T1 sep T2,
+     * T1 and T2 being the texts of idx1 and idx2.
+     * sep becomes the smallest character, so the rows of idx1 keep their order
+     * in both BWT and BWT^R and the rows of idx2 are inserted among them by
+     * backward search of T2 (resp. T2^R) on idx1. the SA samples follow from
+     * the toehold lemma and PLCP of idx1 & idx2 is reused except between rows
+     * coming from different indexes. no suffix is sorted again: the time is
+     * O((|T2| + r) log) with r the number of runs of the merged index.
+     * \param sep: character occurring in neither text (see merge_separator)
+     */
+    br_index(br_index const& idx1, br_index const& idx2, uchar sep)
+    {
 
-        for(ulint i = 1; i < 256; ++i) 
-            F[i] += F[i-1];
+        ulint n1 = idx1.bwt.size();
+        ulint n2 = idx2.bwt.size();
 
+        std::cout << "Text length = " << n1 + n2 - 1 << std::endl << std::endl;
 
-        // remember BWT position of terminator
-		for(ulint i = 0; i < bwt_s.size(); ++i)
-			if(bwt_s[i]==TERMINATOR)
-				terminator_position = i;
-        
-        for(ulint i = 0; i < bwt_sR.size(); ++i)
-			if(bwt_sR[i]==TERMINATOR)
-				terminator_positionR = i;
+        std::cout << "(1/4) Merging alphabets ... " << std::flush;
 
-        assert(input.size() + 1 == bwt.size());
+        merge_alphabet(idx1, idx2, sep);
 
-        std::cout << "done." << std::endl << std::endl;
+        std::cout << "done." << std::endl;
+        std::cout << "(2/4) Merging BWT, BWT^R and their SA samples ... " << std::flush;
 
+        bwt_runs runs(n1 + n2);
+        bwt_runs runsR(n1 + n2);
 
-        r = bwt.number_of_runs();
-        rR = bwtR.number_of_runs();
+        // <text position, PLCP value> at the beginnings of runs
+        std::vector<range_t> irreducible;
+        {
+            std::thread reverse_thread([&]() { merge_runs(idx1, idx2, true, runsR, nullptr); });
+            merge_runs(idx1, idx2, false, runs, &irreducible);
+            reverse_thread.join();
+        }
 
-        assert(samples_first_vec.size() == r);
-        assert(samples_last_vec.size() == r);
+        last_SA_val = runs.last_SA;
 
-        assert(samples_first_vecR.size() == rR);
-        assert(samples_last_vecR.size() == rR);
+        build_config bc;
+        bc.qgram = std::max(idx1.qgram_length(), idx2.qgram_length());
+        build_from_runs(runs, runsR, bc);
 
-        int log_r = bitsize(r);
-        int log_rR = bitsize(rR);
-        int log_n = bitsize(bwt.size());
+        std::cout << "Merging PLCP ... " << std::flush;
 
-        std::cout << "Number of BWT equal-letter runs: r = " << r << std::endl;
-		std::cout << "Rate n/r = " << double(bwt.size())/r << std::endl;
-		std::cout << "log2(r) = " << std::log2(double(r)) << std::endl;
-		std::cout << "log2(n/r) = " << std::log2(double(bwt.size())/r) << std::endl;
+        std::sort(irreducible.begin(), irreducible.end());
+        plcp = permuted_lcp<>(n1 + n2, irreducible);
 
-        std::cout << "Number of BWT^R equal-letter runs: rR = " << rR << std::endl << std::endl;
+        std::cout << "done. " << std::endl << std::endl;
 
-        // Phi, Phi inverse is needed only in forward case
-        std::cout << "(4/4) Building predecessor for toehold lemma & Phi/Phi^{-1} function ..." << std::flush;
+    }
 
-        
-        samples_last = sdsl::int_vector<>(r,0,log_n);
-        samples_first = sdsl::int_vector<>(r,0,log_n);
-        
-        samples_firstR = sdsl::int_vector<>(rR,0,log_n);
-        samples_lastR = sdsl::int_vector<>(rR,0,log_n);
+    /*
+     * smallest character that can separate the texts of idx1 & idx2 in a merge,
+     * i.e. occurring in neither of them.
+     *
+     * a separator cannot be reused within one text: the merge needs it smaller
+     * than every character of both texts, and distinct from the separators of
+     * previous merges, which stay ordinary characters. so each level of merges
+     * takes one more byte and the separators are the document boundaries (see
+     * documents.hpp). merging indexes of the same level reuses their level's
+     * byte: k texts merged pairwise take ceil(log2 k) bytes, merged one by one
+     * k - 1, at most 254 minus the size of their alphabet
+     */
+    static uchar merge_separator(br_index const& idx1, br_index const& idx2)
+    {
+        for (ulint c = 2; c < 256; ++c)
+            if (idx1.remap[c] == 0 && idx2.remap[c] == 0) return (uchar)c;
 
-        for (ulint i = 0; i < r; ++i)
-        {
-            samples_last[i] = samples_last_vec[i].first;
-            samples_first[i] = samples_first_vec[i].first;
-        }
-        for (ulint i = 0; i < rR; ++i)
-        {
-            samples_lastR[i] = samples_last_vecR[i].first;
-            samples_firstR[i] = samples_first_vecR[i].first;
-        }
+        std::cout << "Error: no character is left for the separator (merge the indexes pairwise to use fewer)" << std::endl;
+        exit(1);
+    }
 
-        // sort samples of first positions in runs according to text position
-        std::sort(samples_first_vec.begin(), samples_first_vec.end());
-        // sort samples of last positions in runs according to text position
-        std::sort(samples_last_vec.begin(), samples_last_vec.end());
+    /*
+     * builds the table of the samples of all the q-grams of the text (see
+     * qgram_table.hpp). backward searches of patterns, or of parts of them
+     * in search_with_mismatch & seed_and_extend, of length at least q then
+     * start with their last q characters matched
+     */
+    void build_qgram_table(ulint q)
+    {
+        std::vector<uchar> alphabet;
+        for (ulint c = 0; c < 256; ++c)
+            if (remap[c] != 0) alphabet.push_back((uchar)c);
 
-        // build Elias-Fano predecessor
-        {
-            std::vector<bool> first_bv(bwt_s.size(),false);
-            for (auto p: samples_first_vec)
-            {
-                assert(p.first < first_bv.size());
-                first_bv[p.first] = true;
-            }
-            first = sparse_bitvector_t(first_bv);
-        }
+        // j - d of left_extension is an occurrence of cP, but the table keeps
+        // SA at the end of the range for left_only
+        auto extend = [this](uchar c, br_sample const& prev_sample) -> br_sample
         {
-            std::vector<bool> last_bv(bwt_s.size(),false);
-            for (auto p: samples_last_vec)
-            {
-                assert(p.first < last_bv.size());
-                last_bv[p.first] = true;
-            }
-            last = sparse_bitvector_t(last_bv);
-        }
-
-        assert(first.rank(first.size()) == r);
-        assert(last.rank(last.size()) == r);
-
-        first_to_run = sdsl::int_vector<>(r,0,log_r);
+            br_sample sample(left_extension(c, prev_sample));
+            if (sample.is_invalid()) return sample;
 
-        last_to_run = sdsl::int_vector<>(r,0,log_r);
+            br_sample backward(left_only(c, prev_sample));
+            sample.j = backward.j - backward.d;
+            sample.d = 0;
+            return sample;
+        };
 
-        // construct first_to_run
-        for (ulint i = 0; i < samples_first_vec.size(); ++i)
-        {
-            first_to_run[i] = samples_first_vec[i].second;
-        }
+        qgrams = qgram_table<sparse_bitvector_t>(q, alphabet, get_initial_sample(false), extend);
 
-        // construct last_to_run
-        for (ulint i = 0; i < samples_last_vec.size(); ++i)
-        {
-            last_to_run[i] = samples_last_vec[i].second;
-        }
+        // the cached samples of long parts were computed without the table
+        if (cache) cache->clear();
+    }
 
-        // release ISA cache
-        //sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_ISA, cc));
-        //sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_ISA, ccR));
+    /*
+     * length of the q-grams of the table, 0 if it is not built
+     */
+    ulint qgram_length() const
+    {
+        return qgrams.qgram_length();
+    }
 
-        std::cout << " done. " << std::endl << std::endl;
+    /*
+     * caches the samples of hot pattern substrings in up to max_bytes (see
+     * sample_cache.hpp). backward_search & forward_search from the initial
+     * sample, and the exact parts of search_with_mismatch & seed_and_extend,
+     * then resume from the longest cached suffix (prefix) of the pattern.
+     * 0 removes the cache
+     */
+    void set_cache(ulint max_bytes)
+    {
+        cache.reset(max_bytes);
+    }
 
+    /*
+     * the cache, with its hit counters. null if there is none
+     */
+    sample_cache<br_sample> const* get_cache() const
+    {
+        return cache.get();
     }
 
     /*
      * get full BWT range
      */
-    range_t full_range()
+    range_t full_range() const
     {
         return {0,bwt_size()-1};
     }
@@ -350,14 +426,17 @@ public:
      * c:  remapped character
      * returns: BWT range of cP
      */
-    range_t LF(range_t rn, uchar c)
+    range_t LF(range_t rn, uchar c) const
     {
 
         if ((c == 255 && F[c] == bwt.size()) || F[c] >= F[c+1]) return {1,0};
 
-        ulint c_before = bwt.rank(rn.first, c);
+        // ranks at both ends share the run lookup on narrow ranges
+        auto rk = bwt.rank_pair(rn.first, rn.second+1, c);
 
-        ulint c_inside = bwt.rank(rn.second+1,c) - c_before;
+        ulint c_before = rk.first;
+
+        ulint c_inside = rk.second - c_before;
 
         if (c_inside == 0) return {1,0};
 
@@ -372,14 +451,17 @@ public:
      * c:  remapped character
      * returns: BWT^R range of cP
      */
-    range_t LFR(range_t rn, uchar c)
+    range_t LFR(range_t rn, uchar c) const
     {
 
         if ((c == 255 && F[c] == bwt.size()) || F[c] >= F[c+1]) return {1,0};
 
-        ulint c_before = bwtR.rank(rn.first, c);
+        // ranks at both ends share the run lookup on narrow ranges
+        auto rk = bwtR.rank_pair(rn.first, rn.second+1, c);
+
+        ulint c_before = rk.first;
 
-        ulint c_inside = bwtR.rank(rn.second+1,c) - c_before;
+        ulint c_inside = rk.second - c_before;
 
         if (c_inside == 0) return {1,0};
 
@@ -393,7 +475,7 @@ public:
      * Phi function
      * get SA[i] from SA[i+1]
      */
-    ulint Phi(ulint i)
+    ulint Phi(ulint i) const
     {
         assert(i != bwt.size() - 1);
 
@@ -419,7 +501,7 @@ public:
      * Phi inverse
      * get SA[i] from SA[i-1]
      */
-    ulint PhiI(ulint i)
+    ulint PhiI(ulint i) const
     {
         assert(i != last_SA_val);
 
@@ -442,13 +524,13 @@ public:
         return (prev_sample + delta) % bwt.size();
     }
 
-    ulint LF(ulint i)
+    ulint LF(ulint i) const
     {
         auto c = bwt[i];
         return F[c] + bwt.rank(i,c);
     }
 
-    ulint LFR(ulint i)
+    ulint LFR(ulint i) const
     {
         auto c = bwtR[i];
         return F[c] + bwtR.rank(i,c);
@@ -457,7 +539,7 @@ public:
     /*
      * inverse of LF (known as Psi)
      */
-    ulint FL(ulint i)
+    ulint FL(ulint i) const
     {
 
         // i-th character in first BWT column F
@@ -470,7 +552,7 @@ public:
 
     }
 
-    ulint FLR(ulint i)
+    ulint FLR(ulint i) const
     {
 
         // i-th character in first BWT column F
@@ -486,7 +568,7 @@ public:
     /*
      * character of position i in column F
      */
-    uchar F_at(ulint i)
+    uchar F_at(ulint i) const
     {
 
         ulint c = (std::upper_bound(F.begin(),F.end(),i) - F.begin()) - 1;
@@ -500,7 +582,7 @@ public:
     /*
      * return BWT range of original char c (not remapped)
      */
-    range_t get_char_range(uchar c)
+    range_t get_char_range(uchar c) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -519,7 +601,7 @@ public:
     /*
      * get a sample corresponding to an empty string
      */
-    br_sample get_initial_sample(bool right=true)
+    br_sample get_initial_sample(bool right=true) const
     {
         if (!right) {
             return br_sample(full_range(), // entire SA range
@@ -546,7 +628,7 @@ public:
      * 
      * assumes c is original char (not remapped)
      */
-    br_sample left_extension(uchar c, br_sample const& prev_sample)
+    br_sample left_extension(uchar c, br_sample const& prev_sample) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -564,32 +646,20 @@ public:
             sample.range.second      - sample.range.first)
         {
             
-            // accumulated occ of aP (for any a s.t. a < c)
-            ulint acc = 0;
-            for (ulint a = 1; a < c; ++a)
-            {
-                range_t smaller_range = LF(prev_sample.range,(uchar)a);
-                acc += (smaller_range.second+1) - smaller_range.first;
-            }
+            // occ of aP for any a s.t. a < c, by ranks of smaller characters
+            ulint acc = bwt.rank_less_than(prev_sample.range.second+1,c) - bwt.rank_less_than(prev_sample.range.first,c);
             // get SAR range of (cP)^R
             sample.rangeR.second = sample.rangeR.first + acc + sample.range.second - sample.range.first;
             sample.rangeR.first = sample.rangeR.first + acc;
 
 
-            // fint last c in range and get its sample
-            // there must be at least one c due to the previous if clause
-            ulint rnk = bwt.rank(prev_sample.range.second+1,c);
-            assert(rnk > 0);
-
-            // update p by corresponding BWT position
-            ulint p = bwt.select(rnk-1,c);
-            assert(p >= prev_sample.range.first && p <= prev_sample.range.second);
-
-            // run number of position p
-            ulint run_of_p = bwt.run_of_position(p);
+            // find the run of the last c in range and whether it ends the range
+            // in one traversal. there must be at least one c due to the previous if clause
+            auto last = bwt.last_run_of(prev_sample.range.second,c);
+            ulint run_of_p = last.first;
 
             // update j by SA[p]
-            if (bwt[prev_sample.range.second] == c)
+            if (last.second)
                 sample.j = samples_first[run_of_p];
             else
                 sample.j = samples_last[run_of_p];
@@ -615,7 +685,7 @@ public:
      * 
      * assumes c is original char (not remapped)
      */
-    br_sample right_extension(uchar c, br_sample const& prev_sample)
+    br_sample right_extension(uchar c, br_sample const& prev_sample) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -633,32 +703,20 @@ public:
             sample.rangeR.second      - sample.rangeR.first)
         {
 
-            // accumulated occ of Pa (for any a s.t. a < c)
-            ulint acc = 0;
-            for (ulint a = 1; a < c; ++a)
-            {
-                range_t smaller_rangeR = LFR(prev_sample.rangeR,(uchar)a);
-                acc += (smaller_rangeR.second+1) - smaller_rangeR.first;
-            }
+            // occ of Pa for any a s.t. a < c, by ranks of smaller characters
+            ulint acc = bwtR.rank_less_than(prev_sample.rangeR.second+1,c) - bwtR.rank_less_than(prev_sample.rangeR.first,c);
             // get SA range of Pc
             sample.range.second = sample.range.first + acc + sample.rangeR.second - sample.rangeR.first; 
             sample.range.first = sample.range.first + acc;
 
 
-            // fint last c in range and get its sample
-            // there must be at least one c due to the previous if clause
-            ulint rnk = bwtR.rank(prev_sample.rangeR.second+1,c);
-            assert(rnk > 0);
-
-            // update pR by corresponding BWTR position
-            ulint pR = bwtR.select(rnk-1,c);
-            assert(pR >= prev_sample.rangeR.first && pR <= prev_sample.rangeR.second);
-
-            // run number of position pR
-            ulint run_of_pR = bwtR.run_of_position(pR);
+            // find the run of the last c in range and whether it ends the range
+            // in one traversal. there must be at least one c due to the previous if clause
+            auto last = bwtR.last_run_of(prev_sample.rangeR.second,c);
+            ulint run_of_pR = last.first;
 
             // j = SA[p]
-            if (bwtR[prev_sample.rangeR.second] == c)
+            if (last.second)
                 sample.j = bwt.size()-2-samples_firstR[run_of_pR];
             else
                 sample.j = bwt.size()-2-samples_lastR[run_of_pR];
@@ -677,9 +735,13 @@ public:
 
     /*
      * backward search P[left...right]
+     * from the initial sample, goes through the cache if any
      */
-    br_sample backward_search(std::string const& pattern, ulint left, ulint right, br_sample const& sample)
+    br_sample backward_search(std::string const& pattern, ulint left, ulint right, br_sample const& sample) const
     {
+        if (cache && is_initial_sample(sample))
+            return backward_search_cached(CACHE_BACKWARD, pattern, left, right, sample, 0);
+
         br_sample res(sample);
         for (ulint i = right + 1; i-- > left; )
         {
@@ -691,9 +753,13 @@ public:
 
     /*
      * forward search P[left...right]
+     * from the initial sample, goes through the cache if any
      */
-    br_sample forward_search(std::string const& pattern, ulint left, ulint right, br_sample const& sample)
+    br_sample forward_search(std::string const& pattern, ulint left, ulint right, br_sample const& sample) const
     {
+        if (cache && is_initial_sample(sample))
+            return forward_search_cached(pattern, left, right, sample);
+
         br_sample res(sample);
         for (ulint i = left; i <= right; ++i)
         {
@@ -706,12 +772,12 @@ public:
     /*
      * count occurrences of current pattern P
      */
-    ulint count_sample(br_sample const& sample)
+    ulint count_sample(br_sample const& sample) const
     {
         return (sample.range.second + 1) - sample.range.first;
     }
 
-    ulint count_samples(std::unordered_map<range_t,br_sample,range_hash> const& samples)
+    ulint count_samples(std::unordered_map<range_t,br_sample,range_hash> const& samples) const
     {
         ulint res = 0;
 		for (auto it = samples.begin(); it != samples.end(); ++it)
@@ -726,7 +792,7 @@ public:
      * return them as std::vector
      * (space consuming if result is big)
      */
-    std::vector<ulint> locate_sample(br_sample const& sample)
+    std::vector<ulint> locate_sample(br_sample const& sample) const
     {
         assert(sample.j >= sample.d);
 
@@ -755,7 +821,7 @@ public:
         return res;
     }
 
-    std::vector<ulint> locate_samples(std::vector<br_sample> const& samples)
+    std::vector<ulint> locate_samples(std::vector<br_sample> const& samples) const
     {
         std::vector<ulint> res;
 		for (auto s: samples)
@@ -766,7 +832,7 @@ public:
 		return res;
     }
 
-    std::vector<ulint> locate_samples(std::unordered_map<range_t,br_sample,range_hash> const& samples)
+    std::vector<ulint> locate_samples(std::unordered_map<range_t,br_sample,range_hash> const& samples) const
     {
         std::vector<ulint> res;
 		for (auto it = samples.begin(); it != samples.end(); ++it)
@@ -780,7 +846,7 @@ public:
     /*
      * count the number of a given pattern
      */
-    ulint count(std::string const& pattern, bool right=false)
+    ulint count(std::string const& pattern, bool right=false) const
     {
         if (right) 
         {
@@ -795,7 +861,9 @@ public:
         else 
         {
             br_sample sample(get_initial_sample());
-            for (size_t i = 0; i < pattern.size(); ++i)
+            size_t i = start_from_qgram(pattern, 0, pattern.size(), sample);
+            if (sample.is_invalid()) return {};
+            for (; i < pattern.size(); ++i)
             {
                 sample = left_only(pattern[pattern.size()-1-i],sample);
                 if (sample.is_invalid()) return {};
@@ -807,7 +875,7 @@ public:
     /*
      * locate occurrences of a given pattern
      */
-    std::vector<ulint> locate(std::string const& pattern, bool right=false)
+    std::vector<ulint> locate(std::string const& pattern, bool right=false) const
     {
         if (right) 
         {
@@ -821,8 +889,10 @@ public:
         }
         else 
         {
-            br_sample sample(get_initial_sample());
-            for (size_t i = 0; i < pattern.size(); ++i)
+            br_sample sample(get_initial_sample(false));
+            size_t i = start_from_qgram(pattern, 0, pattern.size(), sample);
+            if (sample.is_invalid()) return {};
+            for (; i < pattern.size(); ++i)
             {
                 sample = left_only(pattern[pattern.size()-1-i],sample);
                 if (sample.is_invalid()) return {};
@@ -831,7 +901,97 @@ public:
         }
     }
 
-    ulint count_with_mismatch(std::string const& pattern, ulint allowed_mis=0)
+    /*
+     * backward search of each pattern. the patterns advance in lockstep, one
+     * character each per step, so the LF steps of different patterns do not
+     * depend on each other. no prefetch is issued: the cache lines of a step
+     * follow from its first lookups. an invalid sample means no occurrence
+     */
+    std::vector<br_sample> search_batch(std::vector<std::string> const& patterns) const
+    {
+        std::vector<br_sample> samples(patterns.size(), get_initial_sample(false));
+
+        // characters of each pattern matched so far, and the patterns with
+        // characters left to search
+        std::vector<ulint> matched(patterns.size());
+        std::vector<ulint> active;
+        for (ulint k = 0; k < patterns.size(); ++k)
+        {
+            matched[k] = start_from_qgram(patterns[k], 0, patterns[k].size(), samples[k]);
+            if (!samples[k].is_invalid() && matched[k] < patterns[k].size()) active.push_back(k);
+        }
+
+        while (!active.empty())
+        {
+            ulint kept = 0;
+            for (auto k: active)
+            {
+                std::string const& p = patterns[k];
+                samples[k] = left_only(p[p.size()-1-matched[k]],samples[k]);
+                if (!samples[k].is_invalid() && ++matched[k] < p.size()) active[kept++] = k;
+            }
+            active.resize(kept);
+        }
+
+        return samples;
+    }
+
+    /*
+     * count the occurrences of each pattern by search_batch
+     */
+    std::vector<ulint> count_batch(std::vector<std::string> const& patterns) const
+    {
+        std::vector<br_sample> samples = search_batch(patterns);
+
+        std::vector<ulint> res(patterns.size(), 0);
+        for (ulint k = 0; k < patterns.size(); ++k)
+            if (!samples[k].is_invalid()) res[k] = count_sample(samples[k]);
+
+        return res;
+    }
+
+    /*
+     * locate the occurrences of each pattern by search_batch
+     */
+    std::vector<std::vector<ulint> > locate_batch(std::vector<std::string> const& patterns) const
+    {
+        return locate_batch(search_batch(patterns));
+    }
+
+    /*
+     * locate the occurrences of each sample given by search_batch. the Phi
+     * steps of the samples are interleaved in the same way
+     */
+    std::vector<std::vector<ulint> > locate_batch(std::vector<br_sample> const& samples) const
+    {
+        std::vector<std::vector<ulint> > res(samples.size());
+
+        // patterns with occurrences left to locate
+        std::vector<ulint> active;
+        for (ulint k = 0; k < samples.size(); ++k)
+        {
+            if (samples[k].is_invalid()) continue;
+
+            res[k].reserve(count_sample(samples[k]));
+            res[k].push_back(samples[k].j - samples[k].d);
+            if (count_sample(samples[k]) > 1) active.push_back(k);
+        }
+
+        while (!active.empty())
+        {
+            ulint kept = 0;
+            for (auto k: active)
+            {
+                res[k].push_back(Phi(res[k].back()));
+                if (res[k].size() < count_sample(samples[k])) active[kept++] = k;
+            }
+            active.resize(kept);
+        }
+
+        return res;
+    }
+
+    ulint count_with_mismatch(std::string const& pattern, ulint allowed_mis=0) const
     {
         auto samples = search_with_mismatch(pattern,allowed_mis);
         ulint res = 0;
@@ -842,21 +1002,20 @@ public:
         return res;
     }
 
-    std::vector<ulint> locate_with_mismatch(std::string const& pattern, ulint allowed_mis=0)
+    std::vector<ulint> locate_with_mismatch(std::string const& pattern, ulint allowed_mis=0) const
     {
         auto samples = search_with_mismatch(pattern,allowed_mis);
         return locate_samples(samples);
     }
 
-    std::unordered_map<range_t,br_sample,range_hash> search_with_mismatch(std::string const& pattern, ulint allowed_mis=0)
+    std::unordered_map<range_t,br_sample,range_hash> search_with_mismatch(std::string const& pattern, ulint allowed_mis=0) const
     {
         std::unordered_map<range_t,br_sample,range_hash> res;
         ulint m = pattern.size();
-        br_sample init_sample(get_initial_sample());
 
         if (allowed_mis == 0)
         {
-            br_sample sample(backward_search(pattern,0,m-1,init_sample));
+            br_sample sample(search_part(pattern,0,m-1));
             if (sample.is_invalid()) return res;
             res[sample.range] = sample;
             return res;
@@ -866,7 +1025,7 @@ public:
         // divide pattern into div parts and search each part in advance
         for (ulint part = 0; part < div; ++part)
         {
-            br_sample sample(backward_search(pattern,(part*m)/div,((part+1)*m)/div-1,init_sample));
+            br_sample sample(search_part(pattern,(part*m)/div,((part+1)*m)/div-1));
             if (sample.is_invalid()) continue;
             if (part==div-1) 
             {
@@ -881,14 +1040,13 @@ public:
         return res;
     }
 
-    std::unordered_map<range_t,br_sample,range_hash> seed_and_extend(std::string const& pattern, ulint m1, ulint m2, ulint allowed_mis=0)
+    std::unordered_map<range_t,br_sample,range_hash> seed_and_extend(std::string const& pattern, ulint m1, ulint m2, ulint allowed_mis=0) const
     {
         // P[0,m1-1], P[m1,m2-1], P[m2,m-1]
         std::unordered_map<range_t,br_sample,range_hash> res;
         ulint m = pattern.size();
-        br_sample init_sample(get_initial_sample());
 
-        br_sample sample(backward_search(pattern,m1,m2-1,init_sample));
+        br_sample sample(search_part(pattern,m1,m2-1));
         if (sample.is_invalid()) return res;
 
         forward_dfs(res,pattern,m,allowed_mis,m1,m2,0,sample);
@@ -897,9 +1055,9 @@ public:
     }
 
     void backward_dfs(std::unordered_map<range_t,br_sample,range_hash>& res, std::string const& pattern,
-                    ulint m, ulint allowed_mis, ulint left_pos, ulint right_pos, ulint mis, br_sample prev_sample)
+                    ulint m, ulint allowed_mis, ulint left_pos, ulint right_pos, ulint mis, br_sample prev_sample) const
     {
-        uchar c = remap[pattern[left_pos]];
+        uchar c = remap[(uchar)pattern[left_pos]];
 
         //std::cout << mis << " " << allowed_mis << "  ";
 
@@ -919,18 +1077,13 @@ public:
             } 
             else 
             {
-                for (ulint a = 1; a < c; ++a)
-                {
-                    range_t smaller_range = LF(prev_sample.range,(uchar)a);
-                    acc += smaller_range.second + 1 - smaller_range.first;
-                }
+                acc = bwt.rank_less_than(prev_sample.range.second+1,c) - bwt.rank_less_than(prev_sample.range.first,c);
 
                 sample.rangeR.first = sample.rangeR.first + acc;
                 sample.rangeR.second = sample.rangeR.first + sample.range.second - sample.range.first;
-                ulint rnk = bwt.rank(prev_sample.range.second+1,c);
-                ulint p = bwt.select(rnk-1,c);
-                ulint run_of_p = bwt.run_of_position(p);
-                if (bwt[prev_sample.range.second] == c)
+                auto last = bwt.last_run_of(prev_sample.range.second,c);
+                ulint run_of_p = last.first;
+                if (last.second)
                     sample.j = samples_first[run_of_p];
                 else
                     sample.j = samples_last[run_of_p];
@@ -974,10 +1127,9 @@ public:
                 {
                     sample.rangeR.first = sample.rangeR.first + acc;
                     sample.rangeR.second = sample.rangeR.first + sample.range.second - sample.range.first;
-                    ulint rnk = bwt.rank(prev_sample.range.second+1,a);
-                    ulint p = bwt.select(rnk-1,a);
-                    ulint run_of_p = bwt.run_of_position(p);
-                    if (bwt[prev_sample.range.second] == a)
+                    auto last = bwt.last_run_of(prev_sample.range.second,a);
+                    ulint run_of_p = last.first;
+                    if (last.second)
                         sample.j = samples_first[run_of_p];
                     else
                         sample.j = samples_last[run_of_p];
@@ -1013,9 +1165,9 @@ public:
     }
 
     void forward_dfs(std::unordered_map<range_t,br_sample,range_hash>& res, std::string const& pattern,
-                    ulint m, ulint allowed_mis, ulint left_pos, ulint right_pos, ulint mis, br_sample prev_sample)
+                    ulint m, ulint allowed_mis, ulint left_pos, ulint right_pos, ulint mis, br_sample prev_sample) const
     {
-        uchar c = remap[pattern[right_pos]];
+        uchar c = remap[(uchar)pattern[right_pos]];
 
         if (mis == allowed_mis)
         {
@@ -1030,18 +1182,13 @@ public:
             if (sample.rangeR.second - sample.rangeR.first != 
                 prev_sample.rangeR.second - prev_sample.rangeR.first)
             {
-                for (ulint a = 1; a < c; ++a)
-                {
-                    range_t smaller_rangeR = LFR(prev_sample.rangeR,(uchar)a);
-                    acc += (smaller_rangeR.second + 1) - smaller_rangeR.first;
-                }
+                acc = bwtR.rank_less_than(prev_sample.rangeR.second+1,c) - bwtR.rank_less_than(prev_sample.rangeR.first,c);
 
                 sample.range.first = sample.range.first + acc;
                 sample.range.second = sample.range.first + sample.rangeR.second - sample.rangeR.first;
-                ulint rnk = bwtR.rank(prev_sample.rangeR.second+1,c);
-                ulint p = bwtR.select(rnk-1,c);
-                ulint run_of_p = bwtR.run_of_position(p);
-                if (bwtR[prev_sample.rangeR.second] == c)
+                auto last = bwtR.last_run_of(prev_sample.rangeR.second,c);
+                ulint run_of_p = last.first;
+                if (last.second)
                     sample.j = bwt.size()-2-samples_firstR[run_of_p];
                 else
                     sample.j = bwt.size()-2-samples_lastR[run_of_p];
@@ -1084,10 +1231,9 @@ public:
                 {
                     sample.range.first = sample.range.first + acc;
                     sample.range.second = sample.range.first + sample.rangeR.second - sample.rangeR.first;
-                    ulint rnk = bwtR.rank(prev_sample.rangeR.second+1,a);
-                    ulint p = bwtR.select(rnk-1,a);
-                    ulint run_of_p = bwtR.run_of_position(p);
-                    if (bwtR[prev_sample.rangeR.second] == a)
+                    auto last = bwtR.last_run_of(prev_sample.rangeR.second,a);
+                    ulint run_of_p = last.first;
+                    if (last.second)
                         sample.j = bwt.size()-2-samples_firstR[run_of_p];
                     else
                         sample.j = bwt.size()-2-samples_lastR[run_of_p];
@@ -1133,7 +1279,7 @@ public:
     /*
      * get BWT[i] or BWT^R[i]
      */
-    uchar bwt_at(ulint i, bool reversed = false)
+    uchar bwt_at(ulint i, bool reversed = false) const
     {
         if (!reversed) return remap_inv[bwt[i]];
         return remap_inv[bwtR[i]];
@@ -1142,7 +1288,7 @@ public:
     /*
      * get number of runs in BWT
      */
-    ulint number_of_runs(bool reversed = false)
+    ulint number_of_runs(bool reversed = false) const
     {
         if (!reversed) return bwt.number_of_runs();
         return bwtR.number_of_runs();
@@ -1151,7 +1297,7 @@ public:
     /*
      * get position of terminator symbol in BWT
      */
-    ulint get_terminator_position(bool reversed = false)
+    ulint get_terminator_position(bool reversed = false) const
     {
         if (!reversed) return terminator_position;
         return terminator_positionR;
@@ -1160,7 +1306,7 @@ public:
     /*
      * get string representation of BWT
      */
-    std::string get_bwt(bool reversed = false)
+    std::string get_bwt(bool reversed = false) const
     {
         if (!reversed)
         {
@@ -1176,10 +1322,19 @@ public:
         }
     }
 
-    uint serialize(std::ostream& out)
+    uint serialize(std::ostream& out) const
     {
         ulint w_bytes = 0;
 
+        // an index without q-gram table keeps the original format
+        bool has_qgrams = qgrams.qgram_length() > 0;
+        if (has_qgrams)
+        {
+            ulint tag = FORMAT_QGRAMS;
+            out.write((char*)&tag,sizeof(tag));
+            w_bytes += sizeof(tag);
+        }
+
         out.write((char*)&sigma,sizeof(sigma));
 
         out.write((char*)remap.data(),256*sizeof(uchar));
@@ -1215,6 +1370,8 @@ public:
 
         w_bytes += plcp.serialize(out);
 
+        if (has_qgrams) w_bytes += qgrams.serialize(out);
+
         return w_bytes;
     
     }
@@ -1222,7 +1379,10 @@ public:
     void load(std::istream& in)
     {
 
+        // sigma, or the tag of the format with q-gram table
         in.read((char*)&sigma,sizeof(sigma));
+        bool has_qgrams = sigma == FORMAT_QGRAMS;
+        if (has_qgrams) in.read((char*)&sigma,sizeof(sigma));
 
         remap = std::vector<uchar>(256);
         in.read((char*)remap.data(),256*sizeof(uchar));
@@ -1255,12 +1415,17 @@ public:
 
         plcp.load(in);
 
+        qgrams = qgram_table<sparse_bitvector_t>();
+        if (has_qgrams) qgrams.load(in);
+
+        if (cache) cache->clear();
+
     }
 
     /*
      * save index to "{path_prefix}.bri" file
      */
-    void save_to_file(std::string const& path_prefix)
+    void save_to_file(std::string const& path_prefix) const
     {
 
         std::string path = path_prefix + ".bri";
@@ -1283,18 +1448,18 @@ public:
 
     }
 
-    ulint text_size() { return bwt.size() - 1; }
+    ulint text_size() const { return bwt.size() - 1; }
 
-    ulint bwt_size(bool reversed=false) { return bwt.size(); }
+    ulint bwt_size(bool reversed=false) const { return bwt.size(); }
 
-    uchar get_terminator() {
+    uchar get_terminator() const {
         return TERMINATOR;
     }
 
     /*
      * get statistics
      */
-    ulint print_space() 
+    ulint print_space() const
     {
 
         std::cout << "text length           : " << bwt.size() << std::endl;
@@ -1356,6 +1521,13 @@ public:
         tot_bytes += bytes;
         std::cout << "samples_lastR: " << bytes << " bytes" << std::endl;
 
+        if (qgrams.qgram_length() > 0)
+        {
+            bytes = qgrams.get_space();
+            tot_bytes += bytes;
+            std::cout << qgrams.qgram_length() << "-gram table: " << bytes << " bytes" << std::endl;
+        }
+
         std::cout << "<total space of br-index>: " << tot_bytes << " bytes" << std::endl << std::endl;
         std::cout << "<bits/symbol>            : " << (double) tot_bytes * 8 / (double) bwt.size() << std::endl;
 
@@ -1366,7 +1538,7 @@ public:
     /*
      * get space complexity
      */
-    ulint get_space()
+    ulint get_space() const
     {
 
         ulint tot_bytes = sizeof(sigma)
@@ -1396,10 +1568,52 @@ public:
         tot_bytes += samples_firstR.serialize(out);
         tot_bytes += samples_lastR.serialize(out);
 
+        if (qgrams.qgram_length() > 0) tot_bytes += qgrams.get_space();
+
         return tot_bytes;
 
     }
 
+    /*
+     * space in bytes of each component, as in get_space
+     */
+    std::vector<std::pair<std::string, ulint> > space_breakdown() const
+    {
+        std::vector<std::pair<std::string, ulint> > res;
+
+        res.push_back({"header", sizeof(sigma)
+                                 + 256*sizeof(uchar)
+                                 + 256*sizeof(uchar)
+                                 + sizeof(terminator_position)
+                                 + sizeof(terminator_positionR)
+                                 + sizeof(last_SA_val)
+                                 + 256*sizeof(ulint)});
+
+        res.push_back({"bwt", bwt.get_space()});
+        res.push_back({"bwtR", bwtR.get_space()});
+
+        res.push_back({"plcp", plcp.get_space()});
+
+        std::ofstream out("/dev/null");
+
+        res.push_back({"samples_first", samples_first.serialize(out)});
+        res.push_back({"samples_last", samples_last.serialize(out)});
+
+        res.push_back({"first", first.serialize(out)});
+        res.push_back({"first_to_run", first_to_run.serialize(out)});
+
+        res.push_back({"last", last.serialize(out)});
+        res.push_back({"last_to_run", last_to_run.serialize(out)});
+
+        res.push_back({"samples_firstR", samples_firstR.serialize(out)});
+        res.push_back({"samples_lastR", samples_lastR.serialize(out)});
+
+        if (qgrams.qgram_length() > 0) res.push_back({"qgrams", qgrams.get_space()});
+
+        return res;
+
+    }
+
 private:
 
     /*
@@ -1409,7 +1623,7 @@ private:
      * assumes sample is SA[r] if range is [l,r]
      * assumes c is original char (not remapped)
      */
-    br_sample left_only(uchar c, br_sample const& prev_sample)
+    br_sample left_only(uchar c, br_sample const& prev_sample) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -1422,17 +1636,17 @@ private:
         // pattern cP was not found
         if (sample.is_invalid()) return sample;
 
-        if (bwt[prev_sample.range.second] == c)
+        // the last c in range ends it, or ends a run. the empty pattern ends
+        // the last run, and its j may be a sample of the other direction
+        auto last = bwt.last_run_of(prev_sample.range.second,c);
+
+        if (last.second && prev_sample.len > 0)
         {
             sample.d++;
         } 
         else 
         {
-            ulint rnk = bwt.rank(prev_sample.range.second,c);
-            rnk--;
-            ulint k = bwt.select(rnk,c);
-            ulint run_of_k = bwt.run_of_position(k);
-            sample.j = samples_last[run_of_k];
+            sample.j = samples_last[last.first];
             sample.d = 0;
         }
         sample.len++;
@@ -1447,7 +1661,7 @@ private:
      * assumes sample is SAR[e] if range is [s,e]
      * assumes c is original char (not remapped)
      */
-    br_sample right_only(uchar c, br_sample const& prev_sample)
+    br_sample right_only(uchar c, br_sample const& prev_sample) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -1460,13 +1674,13 @@ private:
         // pattern Pc was not found
         if (sample.is_invalid()) return sample;
 
-        if (bwtR[prev_sample.rangeR.second] != c)
+        // the last c in rangeR ends it, or ends a run. the empty pattern ends
+        // the last run, and its j may be a sample of the other direction
+        auto last = bwtR.last_run_of(prev_sample.rangeR.second,c);
+
+        if (!last.second || prev_sample.len == 0)
         {
-            ulint rnk = bwtR.rank(prev_sample.rangeR.second,c);
-            rnk--;
-            ulint k = bwtR.select(rnk,c);
-            ulint run_of_k = bwtR.run_of_position(k);
-            sample.j = bwt.size()-2-samples_lastR[run_of_k];
+            sample.j = bwt.size()-2-samples_lastR[last.first];
             sample.d = sample.len;
         }
         sample.len++;
@@ -1477,7 +1691,7 @@ private:
      * backward search P[left...right]
      * range for SAR is not updated
      */
-    br_sample backward_only(std::string const& pattern, ulint left, ulint right, br_sample const& sample)
+    br_sample backward_only(std::string const& pattern, ulint left, ulint right, br_sample const& sample) const
     {
         br_sample res(sample);
         for (ulint i = right + 1; i-- > left; )
@@ -1489,28 +1703,167 @@ private:
     }
 
     /*
-     * forward search P[left...right]
-     * range for SA is not updated
+     * starts the backward search of pattern[left...right-1] from the q-gram
+     * table: sample becomes that of its last q characters (invalid if they do
+     * not occur) and q is returned. without a table, or if the part is shorter
+     * than q, sample is left as is and 0 is returned
      */
-    br_sample forward_only(std::string const& pattern, ulint left, ulint right, br_sample const& sample)
+    ulint start_from_qgram(std::string const& pattern, ulint left, ulint right, br_sample& sample) const
     {
-        br_sample res(sample);
-        for (ulint i = left; i <= right; ++i)
-        {
-            res = right_only(pattern[i],res);
-            if (res.is_invalid()) return res;
-        }
-        return res;
+        ulint q = qgrams.qgram_length();
+        if (q == 0 || right - left < q) return 0;
+
+        sample = qgrams.template find<br_sample>(pattern, right - q);
+        return q;
     }
 
     /*
-     * locate occurrences of current pattern P 
-     * use while backward searching only (since it assumes sample is SA[r] when SA range is [l,r])
+     * backward search P[left...right] from the initial sample, or from the
+     * q-gram table if P[left...right] has at least q characters, through the
+     * cache if any
+     */
+    br_sample search_part(std::string const& pattern, ulint left, ulint right) const
+    {
+        br_sample sample(get_initial_sample());
+        ulint matched = start_from_qgram(pattern, left, right + 1, sample);
+        if (sample.is_invalid() || left + matched > right) return sample;
+
+        if (cache)
+            return backward_search_cached(matched > 0 ? CACHE_QGRAM : CACHE_BACKWARD, pattern, left, right, sample, matched);
+
+        return backward_search(pattern, left, right - matched, sample);
+    }
+
+    /*
+     * the cached samples are those of searches from the initial sample,
+     * backward or forward, and of backward searches from the q-gram table.
+     * a key is the substring after its tag, so that each key has one sample
+     */
+    enum cache_tag : char { CACHE_BACKWARD = 'b', CACHE_FORWARD = 'f', CACHE_QGRAM = 'q' };
+
+    static std::string cache_key(cache_tag tag, std::string const& pattern, ulint pos, ulint len)
+    {
+        std::string key(1, tag);
+        key.append(pattern, pos, len);
+        return key;
+    }
+
+    /*
+     * the samples of a search of m characters are cached after m and after
+     * the powers of 2, so a search looks up at most log m + 1 keys
+     */
+    static bool is_checkpoint(ulint len, ulint m)
+    {
+        return len == m || (len & (len - 1)) == 0;
+    }
+
+    // the power of 2 below len
+    static ulint previous_checkpoint(ulint len)
+    {
+        ulint p = 1ULL << (bitsize(len) - 1);
+        return p < len ? p : p / 2;
+    }
+
+    bool is_initial_sample(br_sample const& sample) const
+    {
+        return sample.len == 0 && sample.j == get_initial_sample().j;
+    }
+
+    /*
+     * length of the longest suffix (prefix if forward) of P[left...right],
+     * at least min_len long, whose sample is cached under tag. its sample is
+     * copied to sample. 0 if there is none
+     */
+    ulint longest_cached(cache_tag tag, std::string const& pattern, ulint left, ulint right, ulint min_len, br_sample& sample) const
+    {
+        ulint m = right + 1 - left;
+        for (ulint len = m; len >= std::max<ulint>(min_len, 1); len = previous_checkpoint(len))
+        {
+            ulint pos = tag == CACHE_FORWARD ? left : right + 1 - len;
+            if (cache->find(cache_key(tag, pattern, pos, len), sample)) return len;
+        }
+        return 0;
+    }
+
+    /*
+     * backward search P[left...right] from sample, the sample of its last
+     * matched characters. resumes from the longest suffix cached under tag if
+     * longer, and caches the samples at the checkpoints
+     */
+    br_sample backward_search_cached(cache_tag tag, std::string const& pattern, ulint left, ulint right,
+                                     br_sample sample, ulint matched) const
+    {
+        ulint m = right + 1 - left;
+
+        ulint len = longest_cached(tag, pattern, left, right, matched + 1, sample);
+        if (len == 0) len = matched;
+        if (sample.is_invalid()) return sample;
+
+        while (len < m)
+        {
+            sample = left_extension(pattern[right - len], sample);
+            len++;
+
+            // the whole part is absent
+            if (sample.is_invalid())
+            {
+                cache->insert(cache_key(tag, pattern, left, m), sample);
+                return sample;
+            }
+            if (is_checkpoint(len, m)) cache->insert(cache_key(tag, pattern, right + 1 - len, len), sample);
+        }
+        return sample;
+    }
+
+    /*
+     * forward search P[left...right] from the initial sample. resumes from
+     * the longest cached prefix, and caches the samples at the checkpoints
+     */
+    br_sample forward_search_cached(std::string const& pattern, ulint left, ulint right, br_sample sample) const
+    {
+        ulint m = right + 1 - left;
+
+        ulint len = longest_cached(CACHE_FORWARD, pattern, left, right, 1, sample);
+        if (sample.is_invalid()) return sample;
+
+        while (len < m)
+        {
+            sample = right_extension(pattern[left + len], sample);
+            len++;
+
+            if (sample.is_invalid())
+            {
+                cache->insert(cache_key(CACHE_FORWARD, pattern, left, m), sample);
+                return sample;
+            }
+            if (is_checkpoint(len, m)) cache->insert(cache_key(CACHE_FORWARD, pattern, left, len), sample);
+        }
+        return sample;
+    }
+
+    /*
+     * forward search P[left...right]
+     * range for SA is not updated
+     */
+    br_sample forward_only(std::string const& pattern, ulint left, ulint right, br_sample const& sample) const
+    {
+        br_sample res(sample);
+        for (ulint i = left; i <= right; ++i)
+        {
+            res = right_only(pattern[i],res);
+            if (res.is_invalid()) return res;
+        }
+        return res;
+    }
+
+    /*
+     * locate occurrences of current pattern P 
+     * use while backward searching only (since it assumes sample is SA[r] when SA range is [l,r])
      * 
      * return them as std::vector
      * (space consuming if result is big)
      */
-    std::vector<ulint> locate_sample_backward(br_sample const& sample)
+    std::vector<ulint> locate_sample_backward(br_sample const& sample) const
     {
         ulint sa = sample.j - sample.d;
         ulint n_occ = sample.range.second + 1 - sample.range.first;
@@ -1529,81 +1882,892 @@ private:
     }
 
     /*
-     * builds BWT
+     * cache configuration private to one construction pipeline, so that
+     * concurrent pipelines never share cache files
      */
-    std::tuple<std::string, std::vector<range_t>, std::vector<range_t> > 
-    sufsort(sdsl::int_vector<8>& text, sdsl::int_vector_buffer<>& sa)
+    static sdsl::cache_config make_cache_config(std::string const& tag, std::string const& dir)
     {
-        std::string bwt_s;
-        std::vector<range_t> samples_first;
-        std::vector<range_t> samples_last;
+        return sdsl::cache_config(true, dir, 
+            "bri_" + sdsl::util::to_string(sdsl::util::pid()) + "_" + tag);
+    }
 
+    /*
+     * remaps the alphabet of input to 2,3,... preserving the order
+     * (0 and 1 are reserved for the terminators)
+     */
+    template<class text_t>
+    void remap_alphabet(text_t const& input)
+    {
+        remap = std::vector<uchar>(256,0);
+        remap_inv = std::vector<uchar>(256,0);
+        
+        sigma = 1;
+        std::vector<ulint> freqs(256,0);
+        for (size_t i = 0; i < input.size(); ++i)
         {
-            for (ulint i = 0; i < sa.size(); ++i)
+            if (freqs[(uchar)input[i]]++ == 0) sigma++;
+            if (sigma >= 255)
             {
-                auto x = sa[i];
+                std::cout << "Error: alphabet cannot be remapped (overflow)" << std::endl;
+                exit(1);
+            }
+        }
+        uchar new_c = 2; // avoid reserved chars
+        for (ulint c = 2; c < 256; ++c)
+        {
+            if (freqs[(uchar)c] != 0)
+            {
+                remap[(uchar)c] = new_c;
+                remap_inv[new_c++] = (uchar)c;
+            }
+        }
+    }
+
+    /*
+     * alphabet of the merge of idx1 & idx2: sep is remapped to 2 and the other
+     * characters follow in an order consistent with both indexes
+     * (the byte order, unless an index is itself the result of a merge)
+     */
+    void merge_alphabet(br_index const& idx1, br_index const& idx2, uchar sep)
+    {
+        if (sep < 2 || idx1.remap[sep] != 0 || idx2.remap[sep] != 0)
+        {
+            std::cout << "Error: the separator occurs in the texts" << std::endl;
+            exit(1);
+        }
 
-                assert(x <= text.size());
+        // characters in the order of each index
+        std::vector<uchar> seq1, seq2;
+        for (ulint c = 2; c <= idx1.sigma; ++c) seq1.push_back(idx1.remap_inv[c]);
+        for (ulint c = 2; c <= idx2.sigma; ++c) seq2.push_back(idx2.remap_inv[c]);
 
-                if (x > 0) 
-                    bwt_s.push_back((uchar)text[x-1]);
-                else 
-                    bwt_s.push_back(TERMINATOR);
-                
-                // insert samples at beginnings of runs
-                if (i > 0)
+        std::vector<uchar> order(1,sep);
+        for (ulint i = 0, j = 0; i < seq1.size() || j < seq2.size();)
+        {
+            if (i < seq1.size() && j < seq2.size() && seq1[i] == seq2[j])
+            {
+                order.push_back(seq1[i]);
+                ++i; ++j;
+                continue;
+            }
+
+            // a character of only one index can be placed at any time
+            bool free1 = i < seq1.size() && idx2.remap[seq1[i]] == 0;
+            bool free2 = j < seq2.size() && idx1.remap[seq2[j]] == 0;
+
+            if (free1 && (!free2 || seq1[i] < seq2[j])) order.push_back(seq1[i++]);
+            else if (free2) order.push_back(seq2[j++]);
+            else
+            {
+                std::cout << "Error: the alphabets of the indexes are ordered differently" << std::endl;
+                exit(1);
+            }
+        }
+
+        sigma = order.size() + 1;
+        if (sigma >= 255)
+        {
+            std::cout << "Error: alphabet cannot be remapped (overflow)" << std::endl;
+            exit(1);
+        }
+
+        remap = std::vector<uchar>(256,0);
+        remap_inv = std::vector<uchar>(256,0);
+        for (ulint i = 0; i < order.size(); ++i)
+        {
+            remap[order[i]] = i + 2;
+            remap_inv[i + 2] = order[i];
+        }
+    }
+
+    /*
+     * merges the rows of BWT (BWT^R if reversed) of idx1 & idx2 into runs.
+     *
+     * forward, the suffixes of T1 sep T2 $ starting in T1 are sorted as in idx1
+     * since sep is the smallest character, and the rows of idx2 are inserted
+     * after g of them, g computed by backward search of T2 on BWT of idx1.
+     * reversed, T2^R sep T1^R $ is symmetric: the rows of idx2 are ranked among
+     * the suffixes of T1^R $ by backward search of T2^R on BWT^R of idx1.
+     * in both cases only idx2 is traversed, by LF from its terminator row.
+     * the SA values of idx1 around the insertion points follow from the toehold
+     * lemma; the terminator of T2 (forward) or T1^R (reversed) becomes sep.
+     * \param irreducible: if not null, the PLCP values at the beginnings of
+     *        the runs are appended to it (forward only)
+     */
+    void merge_runs(br_index const& idx1, br_index const& idx2, bool reversed, bwt_runs& out,
+                    std::vector<range_t>* irreducible)
+    {
+        rle_string_t const& bwt1 = reversed ? idx1.bwtR : idx1.bwt;
+        rle_string_t const& bwt2 = reversed ? idx2.bwtR : idx2.bwt;
+        sdsl::int_vector<> const& first1 = reversed ? idx1.samples_firstR : idx1.samples_first;
+        sdsl::int_vector<> const& last1 = reversed ? idx1.samples_lastR : idx1.samples_last;
+
+        ulint n1 = bwt1.size();
+        ulint n2 = bwt2.size();
+
+        // text offsets of the rows of idx1 & idx2 in the merged text
+        ulint off1 = reversed ? n2 : 0;
+        ulint off2 = reversed ? 0 : n1;
+
+        // remapped characters of idx1 & idx2 to the merged alphabet
+        std::vector<uchar> conv1(256,0), conv2(256,0);
+        for (ulint c = 2; c <= idx1.sigma; ++c) conv1[c] = remap[idx1.remap_inv[c]];
+        for (ulint c = 2; c <= idx2.sigma; ++c) conv2[c] = remap[idx2.remap_inv[c]];
+        // sep is remapped to 2
+        conv1[TERMINATOR] = reversed ? 2 : TERMINATOR;
+        conv2[TERMINATOR] = reversed ? TERMINATOR : 2;
+
+        // number of c in BWT of idx
+        auto count = [&](br_index const& idx, ulint c) -> ulint
+        {
+            return (c == 255 ? idx.bwt.size() : idx.F[c+1]) - idx.F[c];
+        };
+
+        // C[a]: number of rows of idx1 starting with a merged character < a.
+        // the terminator row of idx1 (forward: sep T2 $) is the smallest
+        std::vector<ulint> C(257,0);
+        C[TERMINATOR+1] = 1;
+        for (ulint c = 2; c <= idx1.sigma; ++c) C[conv1[c]+1] = count(idx1, c);
+        for (ulint a = 1; a < 257; ++a) C[a] += C[a-1];
+
+        // SA values of idx1 at the first row after & the last row before
+        // the rows starting with a, where a does not occur or is exhausted
+        std::vector<ulint> sa_next(256,0), sa_prev(256,0);
+        {
+            ulint sa_after = 0, sa_before = 0;
+            std::vector<ulint> sa_block_first(256,0), sa_block_last(256,0);
+            // row 0 is the terminator of T1 (T1^R)
+            sa_block_first[TERMINATOR] = sa_block_last[TERMINATOR] = n1 - 1;
+            for (ulint c = 2; c <= idx1.sigma; ++c)
+            {
+                // LF of the first & last c
+                sa_block_first[conv1[c]] = first1[bwt1.run_of_position(bwt1.select(0,c))];
+                sa_block_last[conv1[c]] = last1[bwt1.run_of_position(bwt1.select(count(idx1,c)-1,c))];
+            }
+            for (ulint a = 256; a-- > 0;)
+            {
+                sa_next[a] = sa_after;
+                if (C[a+1] > C[a]) sa_after = sa_block_first[a];
+            }
+            for (ulint a = 0; a < 256; ++a)
+            {
+                sa_prev[a] = sa_before;
+                if (C[a+1] > C[a]) sa_before = sa_block_last[a];
+            }
+        }
+
+        // for each row k of idx2: number of rows of idx1 before it,
+        // SA values of idx1 at the rows before & after it and SA value of k
+        sdsl::int_vector<> g_at(n2, 0, bitsize(n1));
+        sdsl::int_vector<> sa1_before(n2, 0, bitsize(n1));
+        sdsl::int_vector<> sa1_after(n2, 0, bitsize(n1));
+        sdsl::int_vector<> sa2(n2, 0, bitsize(n2));
+
+        // T2 (original characters), only to compare suffixes for PLCP
+        std::string text2;
+        if (irreducible != nullptr) text2.resize(n2 - 1);
+
+        {
+            // T2 $ (resp. sep T1^R $) is preceded by g rows of idx1
+            ulint g = reversed ? 1 : 0;
+            ulint sb = n1 - 1, sa = reversed ? sa_next[2] : n1 - 1;
+
+            ulint k = 0;     // row of idx2
+            ulint j = n2 - 1; // SA value of k
+
+            for (ulint step = 0; step < n2; ++step)
+            {
+                g_at[k] = g;
+                sa1_before[k] = sb;
+                sa1_after[k] = sa;
+                sa2[k] = j;
+
+                uchar c2 = bwt2[k];
+                if (c2 == TERMINATOR)
                 {
-                    if (i==1 || (i>1 && bwt_s[i-1] != bwt_s[i-2]))
-                    {
-                        samples_first.push_back({
-                            sa[i-1] > 0
-                            ? sa[i-1] - 1
-                            : sa.size() - 1,
-                            samples_first.size()
-                        });
-                    }
-                    if (i==sa.size()-1 && bwt_s[i] != bwt_s[i-1])
-                    {
-                        samples_first.push_back({
-                            sa[i] > 0
-                            ? sa[i] - 1
-                            : sa.size() - 1,
-                            samples_first.size()
-                        });
-                    }
+                    assert(step == n2 - 1);
+                    break;
                 }
 
-                // insert samples at ends of runs
-                if (i > 0)
+                uchar a = conv2[c2];
+                uchar c = idx1.remap[idx2.remap_inv[c2]]; // 0 if not in idx1
+
+                if (irreducible != nullptr) text2[j-1] = idx2.remap_inv[c2];
+
+                ulint rk = c == 0 ? 0 : bwt1.rank(g, c);
+                ulint g_next = C[a] + rk;
+
+                // toehold: the row after is LF of the first c at or after g,
+                // the row before is LF of the last c before g
+                if (g_next < n1)
                 {
-                    if (bwt_s[i-1] != bwt_s[i])
-                    {
-                        samples_last.push_back({
-                            sa[i-1] > 0
-                            ? sa[i-1] - 1
-                            : sa.size() - 1,
-                            samples_last.size()
-                        });
-                    }
-                    if (i == sa.size()-1)
-                    {
-                        samples_last.push_back({
-                            sa[i] > 0
-                            ? sa[i] - 1
-                            : sa.size() - 1,
-                            samples_last.size()
-                        });
-                    }
+                    if (c == 0 || rk == count(idx1, c)) sa = sa_next[a];
+                    else if (g < n1 && bwt1[g] == c) sa = (sa + n1 - 1) % n1;
+                    else sa = first1[bwt1.run_of_position(bwt1.select(rk,c))];
                 }
+
+                if (c == 0 || rk == 0) sb = sa_prev[a];
+                else if (bwt1[g-1] == c) sb = (sb + n1 - 1) % n1;
+                else sb = last1[bwt1.run_of_position(bwt1.select(rk-1,c))];
+
+                g = g_next;
+                k = idx2.F[c2] + bwt2.rank(k, c2);
+                j--;
             }
         }
 
-        return std::tuple<std::string, std::vector<range_t>, std::vector<range_t> >
-            (bwt_s, samples_first, samples_last);
+        // LCP of T1[x..] sep T2 $ and T2[y..] $, x at row k1 of idx1: T1 is
+        // read by Psi from k1, until sep (row 0) or a mismatch
+        auto lcp_between = [&](ulint k1, ulint y) -> ulint
+        {
+            ulint l = 0;
+            while (y + l < n2 - 1)
+            {
+                ulint c = std::upper_bound(idx1.F.begin(), idx1.F.end(), k1) - idx1.F.begin() - 1;
+                if (c == TERMINATOR || idx1.remap_inv[c] != (uchar)text2[y+l]) break;
+
+                k1 = bwt1.select(k1 - idx1.F[c], c);
+                ++l;
+            }
+            return l;
+        };
+
+        // the last pushed row: index, row, SA value in the index
+        bool prev_in1 = false;
+        ulint prev_row = 0, prev_sa = 0;
+
+        // appends rows [row_first, row_last] of idx1 (in1) or idx2
+        auto push = [&](uchar c, bool in1, ulint row_first, ulint row_last, ulint sa_first, ulint sa_last)
+        {
+            ulint off = in1 ? off1 : off2;
+
+            if (irreducible != nullptr && (out.heads.size() == 0 || (uchar)out.heads.back() != c))
+            {
+                ulint l = 0;
+                if (out.heads.size() > 0)
+                {
+                    // rows of the same index keep their LCP
+                    if (in1 == prev_in1 && row_first == prev_row + 1)
+                        l = in1 ? idx1.plcp[sa_first] : idx2.plcp[sa_first];
+                    else if (in1)
+                        l = lcp_between(row_first, prev_sa);
+                    else
+                        l = lcp_between(prev_row, sa_first);
+                }
+                irreducible->push_back({off + sa_first, l});
+            }
+
+            out.push_back(c, row_last + 1 - row_first, off + sa_first, off + sa_last);
+
+            prev_in1 = in1;
+            prev_row = row_last;
+            prev_sa = sa_last;
+        };
+
+        ulint p = 0;                             // next row of idx1
+        ulint run = 0;                           // run of idx1 containing p
+        ulint run_last = bwt1.run_at(0) - 1;
+        ulint sa_p = (first1[0] + 1) % n1;       // SA value of p
+
+        // appends rows [p, q) of idx1. sa_q: SA value at q-1
+        auto push_rows1 = [&](ulint q, ulint sa_q)
+        {
+            while (p < q)
+            {
+                ulint e = std::min(q - 1, run_last);
+                ulint sa_e = e == run_last ? (last1[run] + 1) % n1 : sa_q;
+
+                push(conv1[bwt1[p]], true, p, e, sa_p, sa_e);
+
+                p = e + 1;
+                if (e == run_last && p < n1)
+                {
+                    run++;
+                    run_last = p + bwt1.run_at(run) - 1;
+                    sa_p = (first1[run] + 1) % n1;
+                }
+            }
+        };
+
+        for (ulint k = 0; k < n2; ++k)
+        {
+            push_rows1(g_at[k], sa1_before[k]);
+            push(conv2[bwt2[k]], false, k, k, sa2[k], sa2[k]);
+
+            // row p is now preceded by k
+            if (p < n1) sa_p = sa1_after[k];
+        }
+        push_rows1(n1, (last1[run] + 1) % n1);
+
+        assert(out.size == n1 + n2);
+    }
+
+    /*
+     * builds the index of input (std::string or mapped_text) by suffix sorting
+     * text and textR. see the constructor for derive_rev & bc
+     */
+    template<class text_t>
+    void build_from_text(text_t const& input, bool derive_rev, build_config const& bc)
+    {
+        if (input.size() < 1)
+        {
+
+            std::cout << "Error: input string is empty" << std::endl;
+            exit(1);
+
+        }
+
+        std::cout << "Text length = " << input.size() << std::endl << std::endl;
+
+        // the input is resident during the whole construction
+        ulint n = input.size() + 1;
+
+        // SE-SAIS is semi-external, so SA is built in RAM by divsufsort
+        // or by the parallel sorter
+        ulint threads = bc.threads;
+        if (threads > 1 && !bc.fits(n + parallel_sufsort_bytes(n)))
+        {
+            threads = 1;
+            std::cout << "Memory budget: suffixes are sorted by one thread" << std::endl;
+        }
+        bool in_memory = bc.in_memory || threads > 1;
+        if (in_memory) this->sais = false;
+
+        bool concurrent = !derive_rev && threads == 1;
+        if (concurrent && !bc.fits(n + 2*sufsort_bytes(n, this->sais)))
+        {
+            concurrent = false;
+            std::cout << "Memory budget: text and textR are sorted one after the other" << std::endl;
+        }
+        if (!this->sais && !bc.fits(n + sufsort_bytes(n, false)))
+        {
+            this->sais = true;
+            if (in_memory) std::cout << "Memory budget: SE-SAIS is used through cache files instead of RAM" << std::endl;
+            else std::cout << "Memory budget: SE-SAIS is used instead of divsufsort" << std::endl;
+            in_memory = false;
+        }
+        if (!bc.fits(n + sufsort_bytes(n, this->sais)))
+            std::cout << "Warning: suffix sorting may exceed the memory budget (consider -pfp)" << std::endl;
+        if (bc.mem > 0) std::cout << std::endl;
+
+        std::cout << "(1/4) Remapping alphabet ... " << std::flush;
+        
+        // build RLBWT
+
+        // remap alphabet
+        {
+            build_profile::phase ph(bc.profile, "remap");
+            remap_alphabet(input);
+        }
+
+        std::cout << "done." << std::endl;
+        std::cout << "(2/4) Building BWT, BWT^R and computing SA samples";
+        if (threads > 1) std::cout << " (parallel, " << threads << " threads) ... " << std::flush;
+        else if (this->sais) std::cout << " (SA-SAIS) ... " << std::flush;
+        else std::cout << " (DIVSUFSORT) ... " << std::flush;
+
+        // forward & reversed pipelines are independent until the F column,
+        // so they run concurrently, each with its own cache files
+        sdsl::construct_config::byte_algo_sa = this->sais ? sdsl::SE_SAIS : sdsl::LIBDIVSUFSORT;
+
+        // runs and their samples are extracted while SA is streamed,
+        // so BWT is never materialized
+        bwt_runs runs(n);
+        bwt_runs runsR(n);
+
+        // the remapped texts are streamed to the cache and read back from input
+        auto pipeline = [&](bool reversed, bwt_runs& out)
+        {
+            if (in_memory)
+            {
+                sdsl::int_vector<> sa;
+                {
+                    build_profile::phase ph(bc.profile, reversed ? "reverse SA" : "forward SA");
+                    sa = suffix_array(input, reversed, threads);
+                }
+
+                build_profile::phase ph(bc.profile, reversed ? "reverse sufsort" : "forward sufsort");
+                sufsort(input, reversed, sa, out);
+                return;
+            }
+
+            sdsl::cache_config cc = make_cache_config(reversed ? "rev" : "fwd", bc.tmp_dir);
+
+            {
+                build_profile::phase ph(bc.profile, reversed ? "reverse SA" : "forward SA");
+                store_text(input, reversed, cc);
+                sdsl::construct_sa<8>(cc);
+            }
+
+            build_profile::phase ph(bc.profile, reversed ? "reverse sufsort" : "forward sufsort");
+            {
+                sdsl::int_vector_buffer<> sa(sdsl::cache_file_name(sdsl::conf::KEY_SA, cc));
+                sufsort(input, reversed, sa, out);
+            }
+
+            // remove cache of text and SA
+            sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_TEXT, cc));
+            sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_SA, cc));
+        };
+
+        std::thread reverse_thread;
+        if (concurrent) reverse_thread = std::thread(pipeline, true, std::ref(runsR));
+
+        pipeline(false, runs);
+        last_SA_val = runs.last_SA;
+
+        if (derive_rev)
+        {
+            build_profile::phase ph(bc.profile, "derive BWT^R");
+            derive_from_forward(runs, runsR);
+        }
+        else if (concurrent) reverse_thread.join();
+        else pipeline(true, runsR);
+
+        build_from_runs(runs, runsR, bc);
+
+        std::cout << "Computing PLCP at irreducible positions ... " << std::flush;
+
+        // PLCP from the run boundary samples, without ISA & LCP
+        {
+            build_profile::phase ph(bc.profile, "PLCP");
+            plcp = permuted_lcp<>(input, samples_first, samples_last, bc.threads);
+        }
+
+        std::cout << "done. " << std::endl << std::endl;
+    }
+
+    /*
+     * builds the run-length encoded BWT & BWT^R, F column and the SA samples
+     * from the runs extracted by a construction pipeline
+     * \param bc: profile recording the phases (if any) & threads sorting the samples
+     */
+    void build_from_runs(bwt_runs& runs, bwt_runs& runsR, build_config const& bc = build_config())
+    {
+        build_profile* profile = bc.profile;
+
+        std::cout << "done.\n(3/4) Run-length encoding BWT ... " << std::flush;
+
+        {
+            build_profile::phase ph(profile, "RLE");
+
+            // run length compression on BWT and BWTR
+            {
+                std::thread rle_thread([&]() { bwtR = rle_string_t(runsR.heads, runsR.lengths); });
+                // BWT is already encoded if BWT^R has been derived from it
+                if (bwt.size() == 0) bwt = rle_string_t(runs.heads, runs.lengths);
+                rle_thread.join();
+            }
+
+            build_F(runs);
+
+            // remember BWT position of terminator (a run of length 1)
+            terminator_position = run_position(runs, TERMINATOR);
+            terminator_positionR = run_position(runsR, TERMINATOR);
+
+            assert(runs.n == bwt.size());
+
+            // only the samples are needed from now on
+            std::string().swap(runs.heads);
+            std::string().swap(runsR.heads);
+            std::vector<ulint>().swap(runs.lengths);
+            std::vector<ulint>().swap(runsR.lengths);
+        }
+
+        std::cout << "done." << std::endl << std::endl;
+
+        build_profile::phase ph(profile, "predecessor/Phi");
+        build_samples(runs.samples_first, runs.samples_last, runsR.samples_first, runsR.samples_last, bc.threads);
+
+        if (bc.qgram > 0)
+        {
+            ph.next("q-grams");
+
+            std::cout << "Building the table of " << bc.qgram << "-grams ... " << std::flush;
+            build_qgram_table(bc.qgram);
+            std::cout << "done. " << qgrams.number_of_qgrams() << " distinct " << bc.qgram << "-grams" << std::endl << std::endl;
+        }
+    }
+
+    /*
+     * builds F column (common between text and textR) from the runs of BWT
+     */
+    void build_F(bwt_runs const& runs)
+    {
+        F = std::vector<ulint>(256,0);
+
+        for (ulint i = 0; i < runs.heads.size(); ++i)
+            F[(uchar)runs.heads[i]] += runs.lengths[i];
+
+        for (ulint i = 255; i > 0; --i) 
+            F[i] = F[i-1];
+
+        F[0] = 0;
+
+        for(ulint i = 1; i < 256; ++i) 
+            F[i] += F[i-1];
+    }
+
+    /*
+     * encodes BWT and derives the runs of BWT^R from it
+     */
+    void derive_from_forward(bwt_runs& runs, bwt_runs& runsR)
+    {
+        bwt = rle_string_t(runs.heads, runs.lengths);
+        build_F(runs);
+        derive_reversed(runs, runsR);
+    }
+
+    /*
+     * derives the runs of BWT^R and their SA^R samples from the forward RLBWT,
+     * without suffix sorting the reversed text. bwt and F must be built in advance.
+     *
+     * strings x are enumerated by left extensions on BWT, keeping the BWT range
+     * of x and the BWT^R range of x^R (as in left_extension) together with the
+     * BWT ranges of xc for every c following x. the BWT^R range of x^R is
+     * partitioned by the characters preceding x, and BWT^R is c on the whole range
+     * once x is followed by a single character c. these leaves are visited in
+     * BWT^R order, so BWT^R is streamed into runsR.
+     * SA^R is computed only at run boundaries, descending from the leaf to the
+     * first (last) occurrence of x^R by the smallest (largest) left extensions
+     * until the range is a single position, whose SA value is kept by the toehold lemma.
+     *
+     * time is not bounded by the runs: every internal node of the enumeration
+     * and every step of a descent ranks up to sigma characters, and there are
+     * about n nodes and up to n steps per descent on repetitive texts. so it is
+     * experimental (bri-build -derive-rev), never used by default
+     */
+    void derive_reversed(bwt_runs const& runs, bwt_runs& runsR)
+    {
+        ulint n = bwt.size();
+
+        // remapped characters occurring in BWT
+        std::vector<uchar> alphabet;
+        for (ulint c = 1; c < 256; ++c)
+            if ((c == 255 ? n : F[c+1]) > F[c]) alphabet.push_back(c);
+
+        // characters in BWT[rn] and their numbers of occurrences
+        std::vector<std::pair<uchar,ulint> > chars;
+        auto chars_in = [&](range_t rn)
+        {
+            chars.clear();
+            if (bwt.run_of_position(rn.first) == bwt.run_of_position(rn.second))
+            {
+                chars.push_back({bwt[rn.first], rn.second + 1 - rn.first});
+                return;
+            }
+            for (auto c: alphabet)
+            {
+                auto rk = bwt.rank_pair(rn.first, rn.second+1, c);
+                ulint occ = rk.second - rk.first;
+                if (occ > 0) chars.push_back({c, occ});
+            }
+        };
+
+        // SA value at the end of LF(rn,c), where j is SA value at the end of rn
+        auto toehold = [&](range_t rn, ulint j, uchar c) -> ulint
+        {
+            auto last = bwt.last_run_of(rn.second, c);
+            if (last.second) return (j + n - 1) % n;
+            // the last c in rn is the end of a run
+            return runs.samples_last[last.first].first;
+        };
+
+        // x: BWT range rn, SA value j at its end, BWT^R range starting at lR,
+        // |x| = depth, and the following characters in children[begin,end)
+        struct node_t { range_t rn; ulint j, lR, depth, begin, end; };
+
+        std::vector<std::pair<uchar,range_t> > children;
+        std::vector<node_t> stack;
+
+        // SA^R value at the first (last) position of the BWT^R range of leaf x
+        auto sa_reversed = [&](node_t const& x, bool first) -> ulint
+        {
+            range_t rn = x.rn;
+            ulint j = x.j;
+            ulint steps = 0;
+
+            while (rn.first < rn.second)
+            {
+                chars_in(rn);
+                uchar c = first ? chars.front().first : chars.back().first;
+                j = toehold(rn, j, c);
+                rn = LF(rn, c);
+                steps++;
+            }
+
+            // x occurs at text position p, so x^R at n-1-p-|x| of reversed text
+            ulint p = (j + steps) % n;
+            return (2*n - 1 - p - x.depth) % n;
+        };
+
+        // current run of BWT^R and its first & last leaves
+        uchar run_c = 0;
+        ulint run_len = 0;
+        node_t run_first, run_last;
+
+        auto flush = [&]()
+        {
+            if (run_len == 0) return;
+            runsR.push_back(run_c, run_len, sa_reversed(run_first, true), sa_reversed(run_last, false));
+        };
+
+        // empty string
+        {
+            node_t root;
+            root.rn = {0, n-1};
+            root.j = runs.last_SA;
+            root.lR = 0;
+            root.depth = 0;
+            root.begin = 0;
+            for (auto c: alphabet)
+                children.push_back({c, {F[c], (c == 255 ? n : F[c+1]) - 1}});
+            root.end = children.size();
+            stack.push_back(root);
+        }
+
+        std::vector<std::pair<uchar,range_t> > x_children;
+        std::vector<std::pair<uchar,ulint> > extensions;
+
+        while (!stack.empty())
+        {
+            node_t x = stack.back();
+            stack.pop_back();
+
+            x_children.assign(children.begin() + x.begin, children.begin() + x.end);
+            children.resize(x.begin);
+
+            // x is followed only by c: BWT^R[lR..] = c
+            if (x_children.size() == 1)
+            {
+                uchar c = x_children[0].first;
+                ulint len = x.rn.second + 1 - x.rn.first;
+
+                if (run_len > 0 && c == run_c)
+                {
+                    run_len += len;
+                    run_last = x;
+                }
+                else
+                {
+                    flush();
+                    run_c = c;
+                    run_len = len;
+                    run_first = run_last = x;
+                }
+                continue;
+            }
+
+            chars_in(x.rn);
+            extensions = chars;
+
+            // BWT^R range of (ax)^R starts after those of (bx)^R, b < a
+            std::vector<ulint> lR(extensions.size());
+            for (ulint i = 0, acc = x.lR; i < extensions.size(); ++i)
+            {
+                lR[i] = acc;
+                acc += extensions[i].second;
+            }
+
+            // push in decreasing order, so that leaves are visited in BWT^R order
+            for (ulint i = extensions.size(); i-- > 0;)
+            {
+                uchar a = extensions[i].first;
+
+                node_t y;
+                y.rn = LF(x.rn, a);
+                y.j = toehold(x.rn, x.j, a);
+                y.lR = lR[i];
+                y.depth = x.depth + 1;
+                y.begin = children.size();
+                for (auto const& ch: x_children)
+                {
+                    range_t rn = LF(ch.second, a);
+                    if (rn.first <= rn.second) children.push_back({ch.first, rn});
+                }
+                y.end = children.size();
+
+                stack.push_back(y);
+            }
+        }
+        flush();
+
+        assert(runsR.size == n);
+    }
+
+    /*
+     * builds the SA samples, the predecessor structures for the toehold lemma
+     * and Phi/Phi^{-1}. bwt and bwtR must be built in advance.
+     * samples are <text position, run number> at beginnings & ends of runs.
+     * samples_first_vec & samples_last_vec are released
+     * \param threads: number of threads sorting the samples
+     */
+    void build_samples(std::vector<range_t>& samples_first_vec,
+                       std::vector<range_t>& samples_last_vec,
+                       std::vector<range_t>& samples_first_vecR,
+                       std::vector<range_t>& samples_last_vecR,
+                       ulint threads = 1)
+    {
+
+        r = bwt.number_of_runs();
+        rR = bwtR.number_of_runs();
+
+        assert(samples_first_vec.size() == r);
+        assert(samples_last_vec.size() == r);
+
+        assert(samples_first_vecR.size() == rR);
+        assert(samples_last_vecR.size() == rR);
+
+        int log_r = bitsize(r);
+        int log_rR = bitsize(rR);
+        int log_n = bitsize(bwt.size());
+
+        std::cout << "Number of BWT equal-letter runs: r = " << r << std::endl;
+		std::cout << "Rate n/r = " << double(bwt.size())/r << std::endl;
+		std::cout << "log2(r) = " << std::log2(double(r)) << std::endl;
+		std::cout << "log2(n/r) = " << std::log2(double(bwt.size())/r) << std::endl;
+
+        std::cout << "Number of BWT^R equal-letter runs: rR = " << rR << std::endl << std::endl;
+
+        // Phi, Phi inverse is needed only in forward case
+        std::cout << "(4/4) Building predecessor for toehold lemma & Phi/Phi^{-1} function ..." << std::flush;
+
+        
+        samples_last = sdsl::int_vector<>(r,0,log_n);
+        samples_first = sdsl::int_vector<>(r,0,log_n);
+        
+        samples_firstR = sdsl::int_vector<>(rR,0,log_n);
+        samples_lastR = sdsl::int_vector<>(rR,0,log_n);
+
+        for (ulint i = 0; i < r; ++i)
+        {
+            samples_last[i] = samples_last_vec[i].first;
+            samples_first[i] = samples_first_vec[i].first;
+        }
+        for (ulint i = 0; i < rR; ++i)
+        {
+            samples_lastR[i] = samples_last_vecR[i].first;
+            samples_firstR[i] = samples_first_vecR[i].first;
+        }
+
+        // first & last are independent of each other, so each gets half of the threads
+        ulint sort_threads = std::max<ulint>(1, threads / 2);
+
+        first_to_run = sdsl::int_vector<>(r,0,log_r);
+        last_to_run = sdsl::int_vector<>(r,0,log_r);
+
+        // samples are radix sorted by text position, then the Elias-Fano predecessor
+        // and the run numbers are written from the sorted stream
+        {
+            std::thread last_thread([&]() { build_predecessor(samples_last_vec, bwt.size(), last, last_to_run, sort_threads); });
+            build_predecessor(samples_first_vec, bwt.size(), first, first_to_run, sort_threads);
+            last_thread.join();
+        }
+
+        assert(first.rank(first.size()) == r);
+        assert(last.rank(last.size()) == r);
+
+        std::cout << " done. " << std::endl << std::endl;
+    }
+
+    /*
+     * the remapped text, recovered from BWT by LF from the terminator
+     */
+    std::string remapped_text()
+    {
+        ulint n = bwt.size() - 1;
+        std::string text(n, 0);
+
+        // row 0 is the suffix $, preceded by the last character
+        ulint i = 0;
+        for (ulint k = n; k > 0; --k)
+        {
+            text[k-1] = bwt[i];
+            i = LF(i);
+        }
+        return text;
+    }
+
+    /*
+     * BWT position of the first run with head c
+     */
+    ulint run_position(bwt_runs& runs, uchar c)
+    {
+        ulint pos = 0;
+        for (ulint i = 0; i < runs.heads.size(); ++i)
+        {
+            if ((uchar)runs.heads[i] == c) return pos;
+            pos += runs.lengths[i];
+        }
+        return pos;
+    }
+
+    /*
+     * stores the remapped text (textR if reversed) with the zero symbol to the
+     * cache of cc. it is streamed, so no remapped copy of input is kept in RAM
+     */
+    template<class text_t>
+    void store_text(text_t const& input, bool reversed, sdsl::cache_config& cc)
+    {
+        {
+            sdsl::int_vector_buffer<8> text(sdsl::cache_file_name(sdsl::conf::KEY_TEXT, cc), std::ios::out);
+            auto view = remap_view(input, remap, reversed);
+            for (ulint i = 0; i < view.size(); ++i) text.push_back(view[i]);
+        }
+        sdsl::register_cache_file(sdsl::conf::KEY_TEXT, cc);
+    }
+
+    /*
+     * SA of the remapped text (textR if reversed) with the zero symbol,
+     * built in RAM by divsufsort, or by the parallel sorter if threads > 1
+     */
+    template<class text_t>
+    sdsl::int_vector<> suffix_array(text_t const& input, bool reversed, ulint threads = 1)
+    {
+        auto view = remap_view(input, remap, reversed);
+        ulint n = view.size();
+
+        // the parallel sorter reads the view, divsufsort needs a contiguous copy
+        if (threads > 1) return parallel_suffix_array(view, threads);
+
+        std::string text(n, 0);
+        for (ulint i = 0; i < n; ++i) text[i] = view[i];
+
+        sdsl::int_vector<> sa(n, 0, bitsize(n));
+        sdsl::algorithm::calculate_sa((const unsigned char*)text.data(), n, sa);
+
+        return sa;
+    }
+
+    /*
+     * streams SA of text (textR if reversed) and appends the runs of BWT and
+     * their SA samples to runs. the characters are read from input.
+     * sa is an int_vector_buffer on the cache or an int_vector in RAM
+     */
+    template<class text_t, class sa_t>
+    void sufsort(text_t const& input, bool reversed, sa_t& sa, bwt_runs& runs)
+    {
+        auto text = remap_view(input, remap, reversed);
+
+        for (ulint i = 0; i < sa.size(); ++i)
+        {
+            ulint x = sa[i];
+
+            assert(x < text.size());
+
+            uchar c = x > 0 ? text[x-1] : (uchar)TERMINATOR;
+            runs.push_back(c, 1, x, x);
+        }
+
+        assert(runs.size == sa.size());
     }
 
     static const uchar TERMINATOR = 1;
 
+    // first word of the files of indexes with q-gram table ("bri-qgr" and a
+    // version number), where files without table start with sigma < 256
+    static const ulint FORMAT_QGRAMS = 0x007267712d697262ULL | (1ULL << 56);
+
     bool sais = true;
 
     /*
@@ -1648,8 +2812,17 @@ private:
     // needed for determining the end of locate
     permuted_lcp<> plcp;
 
+    // optional: samples of the q-grams, from which backward searches start
+    qgram_table<sparse_bitvector_t> qgrams;
+
+    // optional: samples of hot substrings. a copy of the index starts empty
+    sample_cache_ptr<br_sample> cache;
+
 };
 
+// with the wavelet matrix of rank_less_than whatever the build, for large alphabets
+typedef br_index<sparse_sd_vector, rle_string_sd_wm> br_index_wm;
+
 };
 
 #endif /* INCLUDED_BR_INDEX_HPP */
\ No newline at end of file
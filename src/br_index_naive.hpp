@@ -72,13 +72,13 @@ struct br_sample_naive {
     }
 
     // the pattern does not exist
-    bool is_invalid()
+    bool is_invalid() const
     {
         return (range.first > range.second) || (rangeR.first > rangeR.second);
     }
 
     // range size
-    ulint size()
+    ulint size() const
     {
         return range.second + 1 - range.first;
     }
@@ -390,7 +390,7 @@ public:
     /*
      * get full BWT range
      */
-    range_t full_range()
+    range_t full_range() const
     {
         return {0,bwt_size()-1};
     }
@@ -400,14 +400,17 @@ public:
      * c:  remapped character
      * returns: BWT range of cP
      */
-    range_t LF(range_t rn, uchar c)
+    range_t LF(range_t rn, uchar c) const
     {
 
         if ((c == 255 && F[c] == bwt.size()) || F[c] >= F[c+1]) return {1,0};
 
-        ulint c_before = bwt.rank(rn.first, c);
+        // ranks at both ends share the run lookup on narrow ranges
+        auto rk = bwt.rank_pair(rn.first, rn.second+1, c);
 
-        ulint c_inside = bwt.rank(rn.second+1,c) - c_before;
+        ulint c_before = rk.first;
+
+        ulint c_inside = rk.second - c_before;
 
         if (c_inside == 0) return {1,0};
 
@@ -422,14 +425,17 @@ public:
      * c:  remapped character
      * returns: BWT^R range of cP
      */
-    range_t LFR(range_t rn, uchar c)
+    range_t LFR(range_t rn, uchar c) const
     {
 
         if ((c == 255 && F[c] == bwt.size()) || F[c] >= F[c+1]) return {1,0};
 
-        ulint c_before = bwtR.rank(rn.first, c);
+        // ranks at both ends share the run lookup on narrow ranges
+        auto rk = bwtR.rank_pair(rn.first, rn.second+1, c);
+
+        ulint c_before = rk.first;
 
-        ulint c_inside = bwtR.rank(rn.second+1,c) - c_before;
+        ulint c_inside = rk.second - c_before;
 
         if (c_inside == 0) return {1,0};
 
@@ -443,7 +449,7 @@ public:
      * Phi function
      * get SA[i] from SA[i+1]
      */
-    ulint Phi(ulint i)
+    ulint Phi(ulint i) const
     {
         assert(i != bwt.size() - 1);
 
@@ -469,7 +475,7 @@ public:
      * Phi inverse
      * get SA[i] from SA[i-1]
      */
-    ulint PhiI(ulint i)
+    ulint PhiI(ulint i) const
     {
         assert(i != last_SA_val);
 
@@ -492,13 +498,13 @@ public:
         return (prev_sample + delta) % bwt.size();
     }
 
-    ulint LF(ulint i)
+    ulint LF(ulint i) const
     {
         auto c = bwt[i];
         return F[c] + bwt.rank(i,c);
     }
 
-    ulint LFR(ulint i)
+    ulint LFR(ulint i) const
     {
         auto c = bwtR[i];
         return F[c] + bwtR.rank(i,c);
@@ -507,7 +513,7 @@ public:
     /*
      * inverse of LF (known as Psi)
      */
-    ulint FL(ulint i)
+    ulint FL(ulint i) const
     {
 
         // i-th character in first BWT column F
@@ -520,7 +526,7 @@ public:
 
     }
 
-    ulint FLR(ulint i)
+    ulint FLR(ulint i) const
     {
 
         // i-th character in first BWT column F
@@ -536,7 +542,7 @@ public:
     /*
      * character of position i in column F
      */
-    uchar F_at(ulint i)
+    uchar F_at(ulint i) const
     {
 
         ulint c = (std::upper_bound(F.begin(),F.end(),i) - F.begin()) - 1;
@@ -550,7 +556,7 @@ public:
     /*
      * return BWT range of original char c (not remapped)
      */
-    range_t get_char_range(uchar c)
+    range_t get_char_range(uchar c) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -569,7 +575,7 @@ public:
     /*
      * get a sample corresponding to an empty string
      */
-    br_sample_naive get_initial_sample()
+    br_sample_naive get_initial_sample() const
     {
         return br_sample_naive(full_range(), // entire SA range
                                full_range(), // entire SAR range
@@ -588,7 +594,7 @@ public:
      * 
      * assumes c is original char (not remapped)
      */
-    br_sample_naive left_extension(uchar c, br_sample_naive const& prev_sample)
+    br_sample_naive left_extension(uchar c, br_sample_naive const& prev_sample) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -601,14 +607,8 @@ public:
         // pattern cP was not found
         if (sample.range.first > sample.range.second) return sample;
 
-        // accumulated occ of aP (for any a s.t. a < c)
-        ulint acc = 0;
-
-        for (ulint a = 1; a < c; ++a)
-        {
-            range_t smaller_range = LF(prev_sample.range,(uchar)a);
-            acc += (smaller_range.second+1) - smaller_range.first;
-        }
+        // occ of aP for any a s.t. a < c, by ranks of smaller characters
+        ulint acc = bwt.rank_less_than(prev_sample.range.second+1,c) - bwt.rank_less_than(prev_sample.range.first,c);
 
         // get SAR range of (cP)^R
         sample.rangeR.second = sample.rangeR.first + acc + sample.range.second - sample.range.first;
@@ -618,20 +618,14 @@ public:
         if (prev_sample.range.second - prev_sample.range.first != 
             sample.range.second      - sample.range.first)
         {
-            // fint last c in range and get its sample
-            // there must be at least one c due to the previous if clause
-            ulint rnk = bwt.rank(prev_sample.range.second+1,c);
-            assert(rnk > 0);
-
-            // update p by corresponding BWT position
-            sample.p = bwt.select(rnk-1,c);
-            assert(sample.p >= prev_sample.range.first && sample.p <= prev_sample.range.second);
-
-            // run number of position p
-            ulint run_of_p = bwt.run_of_position(sample.p);
+            // find the run of the last c in range and whether it ends the range
+            // in one traversal. there must be at least one c due to the previous if clause
+            auto last = bwt.last_run_of(prev_sample.range.second,c);
+            ulint run_of_p = last.first;
+            sample.p = last.second ? prev_sample.range.second : bwt.run_end(run_of_p);
 
             // update j by SA[p]
-            if (bwt[prev_sample.range.second] == c)
+            if (last.second)
                 sample.j = samples_first[run_of_p];
             else
                 sample.j = samples_last[run_of_p];
@@ -662,7 +656,7 @@ public:
      * 
      * assumes c is original char (not remapped)
      */
-    br_sample_naive right_extension(uchar c, br_sample_naive const& prev_sample)
+    br_sample_naive right_extension(uchar c, br_sample_naive const& prev_sample) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -675,14 +669,8 @@ public:
         // pattern Pc was not found
         if (sample.rangeR.first > sample.rangeR.second) return sample;
 
-        // accumulated occ of Pa (for any a s.t. a < c)
-        ulint acc = 0;
-
-        for (ulint a = 1; a < c; ++a)
-        {
-            range_t smaller_rangeR = LFR(prev_sample.rangeR,(uchar)a);
-            acc += (smaller_rangeR.second+1) - smaller_rangeR.first;
-        }
+        // occ of Pa for any a s.t. a < c, by ranks of smaller characters
+        ulint acc = bwtR.rank_less_than(prev_sample.rangeR.second+1,c) - bwtR.rank_less_than(prev_sample.rangeR.first,c);
 
         // get SA range of Pc
         sample.range.second = sample.range.first + acc + sample.rangeR.second - sample.rangeR.first; 
@@ -692,20 +680,14 @@ public:
         if (prev_sample.rangeR.second - prev_sample.rangeR.first != 
             sample.rangeR.second      - sample.rangeR.first)
         {
-            // fint last c in range and get its sample
-            // there must be at least one c due to the previous if clause
-            ulint rnk = bwtR.rank(prev_sample.rangeR.second+1,c);
-            assert(rnk > 0);
-
-            // update pR by corresponding BWTR position
-            sample.pR = bwtR.select(rnk-1,c);
-            assert(sample.pR >= prev_sample.rangeR.first && sample.pR <= prev_sample.rangeR.second);
-
-            // run number of position pR
-            ulint run_of_pR = bwtR.run_of_position(sample.pR);
+            // find the run of the last c in range and whether it ends the range
+            // in one traversal. there must be at least one c due to the previous if clause
+            auto last = bwtR.last_run_of(prev_sample.rangeR.second,c);
+            ulint run_of_pR = last.first;
+            sample.pR = last.second ? prev_sample.rangeR.second : bwtR.run_end(run_of_pR);
 
             // update jR by SAR[pR]
-            if (bwtR[prev_sample.rangeR.second] == c)
+            if (last.second)
                 sample.jR = samples_firstR[run_of_pR];
             else
                 sample.jR = samples_lastR[run_of_pR];
@@ -733,7 +715,7 @@ public:
     /*
      * backward search P[left...right]
      */
-    br_sample_naive backward_search(std::string const& pattern, ulint left, ulint right, br_sample_naive const& sample)
+    br_sample_naive backward_search(std::string const& pattern, ulint left, ulint right, br_sample_naive const& sample) const
     {
         br_sample_naive res(sample);
         for (ulint i = right + 1; i-- > left; )
@@ -747,7 +729,7 @@ public:
     /*
      * forward search P[left...right]
      */
-    br_sample_naive forward_search(std::string const& pattern, ulint left, ulint right, br_sample_naive const& sample)
+    br_sample_naive forward_search(std::string const& pattern, ulint left, ulint right, br_sample_naive const& sample) const
     {
         br_sample_naive res(sample);
         for (ulint i = left; i <= right; ++i)
@@ -761,7 +743,7 @@ public:
     /*
      * count occurrences of current pattern P
      */
-    ulint count_sample(br_sample_naive const& sample)
+    ulint count_sample(br_sample_naive const& sample) const
     {
         return (sample.range.second + 1) - sample.range.first;
     }
@@ -771,7 +753,7 @@ public:
      * return them as std::vector
      * (space consuming if result is big)
      */
-    std::vector<ulint> locate_sample(br_sample_naive const& sample)
+    std::vector<ulint> locate_sample(br_sample_naive const& sample) const
     {
         assert(sample.j >= sample.d);
 
@@ -803,7 +785,7 @@ public:
     /*
      * count the number of a given pattern
      */
-    ulint count(std::string const& pattern)
+    ulint count(std::string const& pattern) const
     {
         br_sample_naive sample(get_initial_sample());
         for (size_t i = 0; i < pattern.size(); ++i)
@@ -817,7 +799,7 @@ public:
     /*
      * count the number of a given pattern with exactly 1 mismatch
      */
-    ulint count1(std::string const& pattern)
+    ulint count1(std::string const& pattern) const
     {
         ulint m = pattern.size();
         ulint x = (m+1)/2;
@@ -899,7 +881,7 @@ public:
     /*
      * count the number of a given pattern with exactly 2 mismatches
      */
-    ulint count2(std::string const& pattern)
+    ulint count2(std::string const& pattern) const
     {
 
         ulint m = pattern.size();
@@ -1141,7 +1123,7 @@ public:
     /*
      * locate occurrences of a given pattern
      */
-    std::vector<ulint> locate(std::string const& pattern, bool right=true)
+    std::vector<ulint> locate(std::string const& pattern, bool right=true) const
     {
         if (right) 
         {
@@ -1168,7 +1150,7 @@ public:
     /*
      * locate occurrences of a given pattern with exactly 1 mismatch
      */
-    std::vector<ulint> locate1(std::string const& pattern)
+    std::vector<ulint> locate1(std::string const& pattern) const
     {
         ulint m = pattern.size();
         ulint x = (m+1)/2;
@@ -1252,7 +1234,7 @@ public:
     /*
      * locate occurrences of a given pattern with exactly 2 mismatches
      */
-    std::vector<ulint> locate2(std::string const& pattern)
+    std::vector<ulint> locate2(std::string const& pattern) const
     {
 
         ulint m = pattern.size();
@@ -1498,7 +1480,7 @@ public:
     /*
      * get BWT[i] or BWT^R[i]
      */
-    uchar bwt_at(ulint i, bool reversed = false)
+    uchar bwt_at(ulint i, bool reversed = false) const
     {
         if (!reversed) return remap_inv[bwt[i]];
         return remap_inv[bwtR[i]];
@@ -1507,7 +1489,7 @@ public:
     /*
      * get number of runs in BWT
      */
-    ulint number_of_runs(bool reversed = false)
+    ulint number_of_runs(bool reversed = false) const
     {
         if (!reversed) return bwt.number_of_runs();
         return bwtR.number_of_runs();
@@ -1516,7 +1498,7 @@ public:
     /*
      * get position of terminator symbol in BWT
      */
-    ulint get_terminator_position(bool reversed = false)
+    ulint get_terminator_position(bool reversed = false) const
     {
         if (!reversed) return terminator_position;
         return terminator_positionR;
@@ -1525,7 +1507,7 @@ public:
     /*
      * get string representation of BWT
      */
-    std::string get_bwt(bool reversed = false)
+    std::string get_bwt(bool reversed = false) const
     {
         if (!reversed)
         {
@@ -1541,7 +1523,7 @@ public:
         }
     }
 
-    uint serialize(std::ostream& out)
+    uint serialize(std::ostream& out) const
     {
         ulint w_bytes = 0;
 
@@ -1630,7 +1612,7 @@ public:
      * save index to "{path_prefix}.brin" file 
      * (different from the simpler impl's index name ".bri")
      */
-    void save_to_file(std::string const& path_prefix)
+    void save_to_file(std::string const& path_prefix) const
     {
 
         std::string path = path_prefix + ".brin";
@@ -1653,18 +1635,18 @@ public:
 
     }
 
-    ulint text_size() { return bwt.size() - 1; }
+    ulint text_size() const { return bwt.size() - 1; }
 
-    ulint bwt_size(bool reversed=false) { return bwt.size(); }
+    ulint bwt_size(bool reversed=false) const { return bwt.size(); }
 
-    uchar get_terminator() {
+    uchar get_terminator() const {
         return TERMINATOR;
     }
 
     /*
      * get statistics
      */
-    ulint print_space() 
+    ulint print_space() const
     {
 
         std::cout << "text length           : " << bwt.size() << std::endl;
@@ -1744,7 +1726,7 @@ public:
     /*
      * get space complexity
      */
-    ulint get_space()
+    ulint get_space() const
     {
 
         ulint tot_bytes = sizeof(sigma)
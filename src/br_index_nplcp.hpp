@@ -1,6 +1,9 @@
 /*
  * bi-directional r-index 
  *  the implementation without PLCP
+ *
+ *  As in br_index, queries are const and may run concurrently on one instance,
+ *  the optional sample cache included.
  */
 
 #ifndef INCLUDED_BR_INDEX_NPLCP_HPP
@@ -9,6 +12,12 @@
 #include "definitions.hpp"
 #include "rle_string.hpp"
 #include "sparse_sd_vector.hpp"
+#include "mapped_text.hpp"
+#include "remapped_view.hpp"
+#include "build_config.hpp"
+#include "sample_cache.hpp"
+#include "parallel_sa.hpp"
+#include "radix_sort.hpp"
 #include "utils.hpp"
 
 namespace bri {
@@ -58,13 +67,13 @@ struct br_sample_nplcp {
     }
 
     // the pattern does not exist
-    bool is_invalid()
+    bool is_invalid() const
     {
         return (range.first > range.second) || (rangeR.first > rangeR.second);
     }
 
     // range size
-    ulint size()
+    ulint size() const
     {
         return range.second + 1 - range.first;
     }
@@ -72,7 +81,7 @@ struct br_sample_nplcp {
 
 template<
     class sparse_bitvector_t = sparse_sd_vector,
-    class rle_string_t = rle_string_sd 
+    class rle_string_t = rle_string_default
 >
 class br_index_nplcp {
 
@@ -84,11 +93,18 @@ public:
 
     /*
      * constructor. 
-     * \param input: string on which br-index is built
+     * \param input: string on which br-index is built, std::string or mapped_text
+     *               (a memory-mapped text file: the text is neither read into RAM
+     *               nor copied, the remapped text and textR are views of it)
      * \param sais: flag determining if we use SAIS for suffix sort. 
      *              otherwise we use divsufsort
+     * \param bc: directory of the cache files & RAM budget. over the budget,
+     *            SAIS replaces divsufsort.
+     *            if bc.in_memory, SA is built by divsufsort in RAM without cache files.
+     *            if bc.threads > 1, SA is built in RAM by the parallel sorter
      */
-    br_index_nplcp(std::string const& input, bool sais = true)
+    template<class text_t>
+    br_index_nplcp(text_t const& input, bool sais = true, build_config const& bc = build_config())
     {
         
         this->sais = sais;
@@ -103,12 +119,35 @@ public:
 
         std::cout << "Text length = " << input.size() << std::endl << std::endl;
 
+        // SE-SAIS is semi-external, so SA is built in RAM by divsufsort
+        // or by the parallel sorter. the input and the remapped text are resident
+        ulint threads = bc.threads;
+        if (threads > 1 && !bc.fits(input.size() + parallel_sufsort_bytes(input.size()+1)))
+        {
+            threads = 1;
+            std::cout << "Memory budget: suffixes are sorted by one thread" << std::endl << std::endl;
+        }
+        bool in_memory = bc.in_memory || threads > 1;
+        if (in_memory) this->sais = sais = false;
+
+        // divsufsort needs a contiguous copy of the remapped text besides the input
+        if (!this->sais && !bc.fits(2*input.size() + sufsort_bytes(input.size()+1, false)))
+        {
+            this->sais = sais = true;
+            if (in_memory) std::cout << "Memory budget: SE-SAIS is used through cache files instead of RAM" << std::endl << std::endl;
+            else std::cout << "Memory budget: SE-SAIS is used instead of divsufsort" << std::endl << std::endl;
+            in_memory = false;
+        }
+
         std::cout << "(1/4) Remapping alphabet ... " << std::flush;
 
+        // consecutive phases of the construction
+        build_profile::phase ph(bc.profile, "remap");
+
         // build RLBWT
 
         // configure & build indexes for sufsort & plcp
-        sdsl::cache_config cc;
+        sdsl::cache_config cc(true, bc.tmp_dir);
 
         // remap alphabet
         remap = std::vector<uchar>(256,0);
@@ -138,63 +177,92 @@ public:
 
         std::cout << "done." << std::endl;
         std::cout << "(2/4) Building BWT, BWT^R, PLCP and computing SA samples";
-        if (sais) std::cout << " (SA-SAIS) ... " << std::flush;
+        if (threads > 1) std::cout << " (parallel, " << threads << " threads) ... " << std::flush;
+        else if (sais) std::cout << " (SA-SAIS) ... " << std::flush;
         else std::cout << " (DIVSUFSORT) ... " << std::flush;
 
-        // remap input text
-        sdsl::int_vector<8> text(input.size());
-        for (size_t i = 0; i < input.size(); ++i)
-            text[i] = remap[(uchar)input[i]];
+        ph.next("forward SA");
 
-        sdsl::append_zero_symbol(text);
+        // the remapped text is read from input
+        auto text = remap_view(input, remap);
 
-        // cache text
-        sdsl::store_to_cache(text, sdsl::conf::KEY_TEXT, cc);
-        sdsl::construct_config::byte_algo_sa = sais ? sdsl::SE_SAIS : sdsl::LIBDIVSUFSORT;
-        
-        // cache SA
-        sdsl::construct_sa<8>(cc);
-        // cache ISA 
-        sdsl::construct_isa(cc);
+        // SA in RAM. it is kept until inv_order is computed
+        sdsl::int_vector<> sa_in_memory;
 
-        
-        sdsl::int_vector_buffer<> sa(sdsl::cache_file_name(sdsl::conf::KEY_SA, cc));
-        last_SA_val = sa[sa.size()-1];
-        auto bwt_and_samples = sufsort(text,sa);
+        std::tuple<std::string, std::vector<range_t>, std::vector<range_t> > bwt_and_samples;
 
-        // remove cache of text and SA
-        sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_TEXT, cc));
-        sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_SA, cc));
+        if (in_memory)
+        {
+            sa_in_memory = suffix_array(text, threads);
 
+            ph.next("forward sufsort");
 
+            last_SA_val = sa_in_memory[sa_in_memory.size()-1];
+            bwt_and_samples = sufsort(text,sa_in_memory);
+        }
+        else
+        {
+            // cache text
+            store_text(text, cc);
+            sdsl::construct_config::byte_algo_sa = sais ? sdsl::SE_SAIS : sdsl::LIBDIVSUFSORT;
 
+            // cache SA. it is kept until inv_order is computed
+            sdsl::construct_sa<8>(cc);
+
+            ph.next("forward sufsort");
+
+            {
+                sdsl::int_vector_buffer<> sa(sdsl::cache_file_name(sdsl::conf::KEY_SA, cc));
+                last_SA_val = sa[sa.size()-1];
+                bwt_and_samples = sufsort(text,sa);
+            }
+
+            // remove cache of text
+            sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_TEXT, cc));
+        }
+
+
+
+
+        ph.next("reverse SA");
 
         // configure & build reversed indexes for sufsort
-        sdsl::cache_config ccR;
+        sdsl::cache_config ccR(true, bc.tmp_dir);
 
-        sdsl::int_vector<8> textR(input.size());
-        for (ulint i = 0; i < input.size(); ++i)
-            textR[i] = remap[(uchar)input[input.size()-1-i]];
+        auto textR = remap_view(input, remap, true);
 
-        sdsl::append_zero_symbol(textR);
+        std::tuple<std::string, std::vector<range_t>, std::vector<range_t> > bwt_and_samplesR;
 
-        // cache textR
-        sdsl::store_to_cache(textR, sdsl::conf::KEY_TEXT, ccR);
-        sdsl::construct_config::byte_algo_sa = sais ? sdsl::SE_SAIS : sdsl::LIBDIVSUFSORT;
-        
-        // cache SAR
-        sdsl::construct_sa<8>(ccR);
-        // cache ISAR
-        sdsl::construct_isa(ccR);
+        if (in_memory)
+        {
+            sdsl::int_vector<> saR = suffix_array(textR, threads);
 
-        sdsl::int_vector_buffer<> saR(sdsl::cache_file_name(sdsl::conf::KEY_SA, ccR));
-        auto bwt_and_samplesR = sufsort(textR,saR);
+            ph.next("reverse sufsort");
 
-        // plcp is not needed in the reversed case
+            bwt_and_samplesR = sufsort(textR,saR);
+        }
+        else
+        {
+            // cache textR
+            store_text(textR, ccR);
+            sdsl::construct_config::byte_algo_sa = sais ? sdsl::SE_SAIS : sdsl::LIBDIVSUFSORT;
 
-        // remove cache of textR and SAR
-        sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_TEXT, ccR));
-        sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_SA, ccR));
+            // cache SAR
+            sdsl::construct_sa<8>(ccR);
+
+            ph.next("reverse sufsort");
+
+            {
+                sdsl::int_vector_buffer<> saR(sdsl::cache_file_name(sdsl::conf::KEY_SA, ccR));
+                bwt_and_samplesR = sufsort(textR,saR);
+            }
+
+            // plcp is not needed in the reversed case
+
+            // remove cache of textR and SAR
+            sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_TEXT, ccR));
+            sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_SA, ccR));
+        }
 
 
 
@@ -210,6 +278,7 @@ public:
 
         std::cout << "done.\n(3/4) Run length encoding BWT ... " << std::flush;
 
+        ph.next("RLE");
 
         // run length compression on BWT and BWTR
         bwt = rle_string_t(bwt_s);
@@ -267,6 +336,7 @@ public:
         // Phi, Phi inverse is needed only in forward case
         std::cout << "(4/4) Building predecessor for toehold lemma & Phi/Phi^{-1} function ..." << std::flush;
 
+        ph.next("predecessor/Phi");
         
         samples_last = sdsl::int_vector<>(r,0,log_n);
         samples_first = sdsl::int_vector<>(r,0,log_n);
@@ -285,30 +355,14 @@ public:
             samples_firstR[i] = samples_first_vecR[i].first;
         }
 
-        // sort samples of first positions in runs according to text position
-        std::sort(samples_first_vec.begin(), samples_first_vec.end());
-        // sort samples of last positions in runs according to text position
-        std::sort(samples_last_vec.begin(), samples_last_vec.end());
+        first_to_run = sdsl::int_vector<>(r,0,log_r);
 
-        // build Elias-Fano predecessor
-        {
-            std::vector<bool> first_bv(bwt_s.size(),false);
-            for (auto p: samples_first_vec)
-            {
-                assert(p.first < first_bv.size());
-                first_bv[p.first] = true;
-            }
-            first = sparse_bitvector_t(first_bv);
-        }
-        {
-            std::vector<bool> last_bv(bwt_s.size(),false);
-            for (auto p: samples_last_vec)
-            {
-                assert(p.first < last_bv.size());
-                last_bv[p.first] = true;
-            }
-            last = sparse_bitvector_t(last_bv);
-        }
+        last_to_run = sdsl::int_vector<>(r,0,log_r);
+
+        // sort samples of first & last positions in runs according to text position,
+        // then build Elias-Fano predecessor and construct first_to_run & last_to_run
+        build_predecessor(samples_first_vec, bwt.size(), first, first_to_run, bc.threads);
+        build_predecessor(samples_last_vec, bwt.size(), last, last_to_run, bc.threads);
 
         assert(first.rank(first.size()) == r);
         assert(last.rank(last.size()) == r);
@@ -319,21 +373,6 @@ public:
 
         inv_order_last = sdsl::int_vector<>(rR,0,log_n);
 
-        first_to_run = sdsl::int_vector<>(r,0,log_r);
-
-        last_to_run = sdsl::int_vector<>(r,0,log_r);
-
-        // construct first_to_run
-        for (ulint i = 0; i < samples_first_vec.size(); ++i)
-        {
-            first_to_run[i] = samples_first_vec[i].second;
-        }
-
-        // construct last_to_run
-        for (ulint i = 0; i < samples_last_vec.size(); ++i)
-        {
-            last_to_run[i] = samples_last_vec[i].second;
-        }
 
         // construct inv_order
         /*{
@@ -350,31 +389,36 @@ public:
             }
         }*/
 
-        // construct inv_orderR
+        // construct inv_orderR: ISA at the text positions of the samples of BWT^R,
+        // found by one scan of SA instead of building ISA
         {
-            //sdsl::int_vector_buffer<> isa(sdsl::cache_file_name(sdsl::conf::KEY_ISA, cc));
-            sdsl::int_vector<> isa;
-            sdsl::load_from_file(isa, sdsl::cache_file_name(sdsl::conf::KEY_ISA, cc));
-            assert(isa.size() == bwt.size());
+            ulint n = bwt.size();
+
+            // <text position, index in inv_order_first (+rR: inv_order_last)>
+            std::vector<range_t> queries;
             for (ulint i = 0; i < samples_firstR.size(); ++i)
             {
-                if (bwt.size() >= samples_firstR[i] + 2)
-                    inv_order_first[i] = isa[bwt.size()-2-samples_firstR[i]];
-                else 
-                    inv_order_first[i] = 0;
+                if (n >= samples_firstR[i] + 2) queries.push_back({n-2-samples_firstR[i], i});
+                else inv_order_first[i] = 0;
             }
             for (ulint i = 0; i < samples_lastR.size(); ++i)
             {
-                if (bwt.size() >= samples_lastR[i] + 2)
-                    inv_order_last[i] = isa[bwt.size()-2-samples_lastR[i]];
-                else 
-                    inv_order_last[i] = 0;
+                if (n >= samples_lastR[i] + 2) queries.push_back({n-2-samples_lastR[i], rR+i});
+                else inv_order_last[i] = 0;
+            }
+            std::sort(queries.begin(), queries.end());
+
+            if (in_memory) inverse_order(sa_in_memory, queries);
+            else
+            {
+                sdsl::int_vector_buffer<> sa(sdsl::cache_file_name(sdsl::conf::KEY_SA, cc));
+                inverse_order(sa, queries);
             }
         }
 
-        // release ISA cache
-        sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_ISA, cc));
-        sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_ISA, ccR));
+        // release SA
+        if (in_memory) sa_in_memory = sdsl::int_vector<>();
+        else sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_SA, cc));
 
         std::cout << " done. " << std::endl << std::endl;
 
@@ -383,7 +427,7 @@ public:
     /*
      * get full BWT range
      */
-    range_t full_range()
+    range_t full_range() const
     {
         return {0,bwt_size()-1};
     }
@@ -393,14 +437,17 @@ public:
      * c:  remapped character
      * returns: BWT range of cP
      */
-    range_t LF(range_t rn, uchar c)
+    range_t LF(range_t rn, uchar c) const
     {
 
         if ((c == 255 && F[c] == bwt.size()) || F[c] >= F[c+1]) return {1,0};
 
-        ulint c_before = bwt.rank(rn.first, c);
+        // ranks at both ends share the run lookup on narrow ranges
+        auto rk = bwt.rank_pair(rn.first, rn.second+1, c);
+
+        ulint c_before = rk.first;
 
-        ulint c_inside = bwt.rank(rn.second+1,c) - c_before;
+        ulint c_inside = rk.second - c_before;
 
         if (c_inside == 0) return {1,0};
 
@@ -415,14 +462,17 @@ public:
      * c:  remapped character
      * returns: BWT^R range of cP
      */
-    range_t LFR(range_t rn, uchar c)
+    range_t LFR(range_t rn, uchar c) const
     {
 
         if ((c == 255 && F[c] == bwt.size()) || F[c] >= F[c+1]) return {1,0};
 
-        ulint c_before = bwtR.rank(rn.first, c);
+        // ranks at both ends share the run lookup on narrow ranges
+        auto rk = bwtR.rank_pair(rn.first, rn.second+1, c);
 
-        ulint c_inside = bwtR.rank(rn.second+1,c) - c_before;
+        ulint c_before = rk.first;
+
+        ulint c_inside = rk.second - c_before;
 
         if (c_inside == 0) return {1,0};
 
@@ -436,7 +486,7 @@ public:
      * Phi function
      * get SA[i] from SA[i+1]
      */
-    ulint Phi(ulint i)
+    ulint Phi(ulint i) const
     {
         assert(i != bwt.size() - 1);
 
@@ -462,7 +512,7 @@ public:
      * Phi inverse
      * get SA[i] from SA[i-1]
      */
-    ulint PhiI(ulint i)
+    ulint PhiI(ulint i) const
     {
         assert(i != last_SA_val);
 
@@ -485,13 +535,13 @@ public:
         return (prev_sample + delta) % bwt.size();
     }
 
-    ulint LF(ulint i)
+    ulint LF(ulint i) const
     {
         auto c = bwt[i];
         return F[c] + bwt.rank(i,c);
     }
 
-    ulint LFR(ulint i)
+    ulint LFR(ulint i) const
     {
         auto c = bwtR[i];
         return F[c] + bwtR.rank(i,c);
@@ -500,7 +550,7 @@ public:
     /*
      * inverse of LF (known as Psi)
      */
-    ulint FL(ulint i)
+    ulint FL(ulint i) const
     {
 
         // i-th character in first BWT column F
@@ -513,7 +563,7 @@ public:
 
     }
 
-    ulint FLR(ulint i)
+    ulint FLR(ulint i) const
     {
 
         // i-th character in first BWT column F
@@ -529,7 +579,7 @@ public:
     /*
      * character of position i in column F
      */
-    uchar F_at(ulint i)
+    uchar F_at(ulint i) const
     {
 
         ulint c = (std::upper_bound(F.begin(),F.end(),i) - F.begin()) - 1;
@@ -543,7 +593,7 @@ public:
     /*
      * return BWT range of original char c (not remapped)
      */
-    range_t get_char_range(uchar c)
+    range_t get_char_range(uchar c) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -559,10 +609,27 @@ public:
 
     }
 
+    /*
+     * caches the samples of hot pattern substrings in up to max_bytes (see
+     * br_index::set_cache). 0 removes the cache
+     */
+    void set_cache(ulint max_bytes)
+    {
+        cache.reset(max_bytes);
+    }
+
+    /*
+     * the cache, with its hit counters. null if there is none
+     */
+    sample_cache<br_sample_nplcp> const* get_cache() const
+    {
+        return cache.get();
+    }
+
     /*
      * get a sample corresponding to an empty string
      */
-    br_sample_nplcp get_initial_sample(bool right=true)
+    br_sample_nplcp get_initial_sample(bool right=true) const
     {
         if (!right) {
             return br_sample_nplcp(full_range(), // entire SA range
@@ -591,7 +658,7 @@ public:
      * 
      * assumes c is original char (not remapped)
      */
-    br_sample_nplcp left_extension(uchar c, br_sample_nplcp const& prev_sample)
+    br_sample_nplcp left_extension(uchar c, br_sample_nplcp const& prev_sample) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -609,32 +676,20 @@ public:
             sample.range.second      - sample.range.first)
         {
             
-            // accumulated occ of aP (for any a s.t. a < c)
-            ulint acc = 0;
-            for (ulint a = 1; a < c; ++a)
-            {
-                range_t smaller_range = LF(prev_sample.range,(uchar)a);
-                acc += (smaller_range.second+1) - smaller_range.first;
-            }
+            // occ of aP for any a s.t. a < c, by ranks of smaller characters
+            ulint acc = bwt.rank_less_than(prev_sample.range.second+1,c) - bwt.rank_less_than(prev_sample.range.first,c);
             // get SAR range of (cP)^R
             sample.rangeR.second = sample.rangeR.first + acc + sample.range.second - sample.range.first;
             sample.rangeR.first = sample.rangeR.first + acc;
 
 
-            // fint last c in range and get its sample
-            // there must be at least one c due to the previous if clause
-            ulint rnk = bwt.rank(prev_sample.range.second+1,c);
-            assert(rnk > 0);
-
-            // update p by corresponding BWT position
-            sample.p = bwt.select(rnk-1,c);
-            //assert(p >= prev_sample.range.first && p <= prev_sample.range.second);
-
-            // run number of position p
-            ulint run_of_p = bwt.run_of_position(sample.p);
+            // find the run of the last c in range and whether it ends the range
+            // in one traversal. there must be at least one c due to the previous if clause
+            auto last = bwt.last_run_of(prev_sample.range.second,c);
+            ulint run_of_p = last.first;
 
             // update j by SA[p]
-            if (bwt[prev_sample.range.second] == c)
+            if (last.second)
             {
                 sample.j = samples_first[run_of_p] + 1;
                 sample.p = bwt.run_start(run_of_p);
@@ -666,7 +721,7 @@ public:
      * 
      * assumes c is original char (not remapped)
      */
-    br_sample_nplcp right_extension(uchar c, br_sample_nplcp const& prev_sample)
+    br_sample_nplcp right_extension(uchar c, br_sample_nplcp const& prev_sample) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -684,32 +739,20 @@ public:
             sample.rangeR.second      - sample.rangeR.first)
         {
 
-            // accumulated occ of Pa (for any a s.t. a < c)
-            ulint acc = 0;
-            for (ulint a = 1; a < c; ++a)
-            {
-                range_t smaller_rangeR = LFR(prev_sample.rangeR,(uchar)a);
-                acc += (smaller_rangeR.second+1) - smaller_rangeR.first;
-            }
+            // occ of Pa for any a s.t. a < c, by ranks of smaller characters
+            ulint acc = bwtR.rank_less_than(prev_sample.rangeR.second+1,c) - bwtR.rank_less_than(prev_sample.rangeR.first,c);
             // get SA range of Pc
             sample.range.second = sample.range.first + acc + sample.rangeR.second - sample.rangeR.first; 
             sample.range.first = sample.range.first + acc;
 
 
-            // fint last c in range and get its sample
-            // there must be at least one c due to the previous if clause
-            ulint rnk = bwtR.rank(prev_sample.rangeR.second+1,c);
-            assert(rnk > 0);
-
-            // update pR by corresponding BWTR position
-            ulint pR = bwtR.select(rnk-1,c);
-            assert(pR >= prev_sample.rangeR.first && pR <= prev_sample.rangeR.second);
-
-            // run number of position pR
-            ulint run_of_pR = bwtR.run_of_position(pR);
+            // find the run of the last c in range and whether it ends the range
+            // in one traversal. there must be at least one c due to the previous if clause
+            auto last = bwtR.last_run_of(prev_sample.rangeR.second,c);
+            ulint run_of_pR = last.first;
 
             // j = SA[p]
-            if (bwtR[prev_sample.rangeR.second] == c) 
+            if (last.second) 
             {
                 sample.j = bwt.size()-2-samples_firstR[run_of_pR];
                 sample.p = inv_order_first[run_of_pR];
@@ -737,9 +780,13 @@ public:
 
     /*
      * backward search P[left...right]
+     * from the initial sample, goes through the cache if any
      */
-    br_sample_nplcp backward_search(std::string const& pattern, ulint left, ulint right, br_sample_nplcp const& sample)
+    br_sample_nplcp backward_search(std::string const& pattern, ulint left, ulint right, br_sample_nplcp const& sample) const
     {
+        if (cache && is_initial_sample(sample))
+            return backward_search_cached(pattern, left, right, sample);
+
         br_sample_nplcp res(sample);
         for (ulint i = right + 1; i-- > left; )
         {
@@ -751,9 +798,13 @@ public:
 
     /*
      * forward search P[left...right]
+     * from the initial sample, goes through the cache if any
      */
-    br_sample_nplcp forward_search(std::string const& pattern, ulint left, ulint right, br_sample_nplcp const& sample)
+    br_sample_nplcp forward_search(std::string const& pattern, ulint left, ulint right, br_sample_nplcp const& sample) const
     {
+        if (cache && is_initial_sample(sample))
+            return forward_search_cached(pattern, left, right, sample);
+
         br_sample_nplcp res(sample);
         for (ulint i = left; i <= right; ++i)
         {
@@ -766,12 +817,12 @@ public:
     /*
      * count occurrences of current pattern P
      */
-    ulint count_sample(br_sample_nplcp const& sample)
+    ulint count_sample(br_sample_nplcp const& sample) const
     {
         return (sample.range.second + 1) - sample.range.first;
     }
 
-    ulint count_samples(std::unordered_map<range_t,br_sample_nplcp,range_hash> const& samples)
+    ulint count_samples(std::unordered_map<range_t,br_sample_nplcp,range_hash> const& samples) const
     {
         ulint res = 0;
 		for (auto it = samples.begin(); it != samples.end(); ++it)
@@ -786,7 +837,7 @@ public:
      * return them as std::vector
      * (space consuming if result is big)
      */
-    std::vector<ulint> locate_sample(br_sample_nplcp const& sample)
+    std::vector<ulint> locate_sample(br_sample_nplcp const& sample) const
     {
         assert(sample.j >= sample.d);
 
@@ -823,7 +874,7 @@ public:
         return res;
     }
 
-    std::vector<ulint> locate_samples(std::vector<br_sample_nplcp> const& samples)
+    std::vector<ulint> locate_samples(std::vector<br_sample_nplcp> const& samples) const
     {
         std::vector<ulint> res;
 		for (auto s: samples)
@@ -834,7 +885,7 @@ public:
 		return res;
     }
 
-    std::vector<ulint> locate_samples(std::unordered_map<range_t,br_sample_nplcp,range_hash> const& samples)
+    std::vector<ulint> locate_samples(std::unordered_map<range_t,br_sample_nplcp,range_hash> const& samples) const
     {
         std::vector<ulint> res;
 		for (auto it = samples.begin(); it != samples.end(); ++it)
@@ -848,7 +899,7 @@ public:
     /*
      * count the number of a given pattern
      */
-    ulint count(std::string const& pattern, bool right=false)
+    ulint count(std::string const& pattern, bool right=false) const
     {
         if (right) 
         {
@@ -872,7 +923,7 @@ public:
         }
     }
 
-    std::unordered_map<range_t,br_sample_nplcp,range_hash> search_with_mismatch(std::string const& pattern, ulint allowed_mis=0)
+    std::unordered_map<range_t,br_sample_nplcp,range_hash> search_with_mismatch(std::string const& pattern, ulint allowed_mis=0) const
     {
         std::unordered_map<range_t,br_sample_nplcp,range_hash> res;
         ulint m = pattern.size();
@@ -904,7 +955,7 @@ public:
         return res;
     }
 
-    std::unordered_map<range_t,br_sample_nplcp,range_hash> seed_and_extend(std::string const& pattern, ulint m1, ulint m2, ulint allowed_mis=0)
+    std::unordered_map<range_t,br_sample_nplcp,range_hash> seed_and_extend(std::string const& pattern, ulint m1, ulint m2, ulint allowed_mis=0) const
     {
         // P[0,m1-1], P[m1,m2-1], P[m2,m-1]
         std::unordered_map<range_t,br_sample_nplcp,range_hash> res;
@@ -920,9 +971,9 @@ public:
     }
 
     void backward_dfs(std::unordered_map<range_t,br_sample_nplcp,range_hash>& res, std::string const& pattern,
-                    ulint m, ulint allowed_mis, ulint left_pos, ulint right_pos, ulint mis, br_sample_nplcp prev_sample)
+                    ulint m, ulint allowed_mis, ulint left_pos, ulint right_pos, ulint mis, br_sample_nplcp prev_sample) const
     {
-        uchar c = remap[pattern[left_pos]];
+        uchar c = remap[(uchar)pattern[left_pos]];
 
         //std::cout << mis << " " << allowed_mis << "  ";
 
@@ -942,18 +993,13 @@ public:
             } 
             else 
             {
-                for (ulint a = 1; a < c; ++a)
-                {
-                    range_t smaller_range = LF(prev_sample.range,(uchar)a);
-                    acc += smaller_range.second + 1 - smaller_range.first;
-                }
+                acc = bwt.rank_less_than(prev_sample.range.second+1,c) - bwt.rank_less_than(prev_sample.range.first,c);
 
                 sample.rangeR.first = sample.rangeR.first + acc;
                 sample.rangeR.second = sample.rangeR.first + sample.range.second - sample.range.first;
-                ulint rnk = bwt.rank(prev_sample.range.second+1,c);
-                sample.p = bwt.select(rnk-1,c);
-                ulint run_of_p = bwt.run_of_position(sample.p);
-                if (bwt[prev_sample.range.second] == c)
+                auto last = bwt.last_run_of(prev_sample.range.second,c);
+                ulint run_of_p = last.first;
+                if (last.second)
                 {
                     sample.j = samples_first[run_of_p] + 1;
                     sample.p = bwt.run_start(run_of_p);
@@ -1003,10 +1049,9 @@ public:
                 {
                     sample.rangeR.first = sample.rangeR.first + acc;
                     sample.rangeR.second = sample.rangeR.first + sample.range.second - sample.range.first;
-                    ulint rnk = bwt.rank(prev_sample.range.second+1,a);
-                    sample.p = bwt.select(rnk-1,a);
-                    ulint run_of_p = bwt.run_of_position(sample.p);
-                    if (bwt[prev_sample.range.second] == a)
+                    auto last = bwt.last_run_of(prev_sample.range.second,a);
+                    ulint run_of_p = last.first;
+                    if (last.second)
                     {
                         sample.j = samples_first[run_of_p] + 1;
                         sample.p = bwt.run_start(run_of_p);
@@ -1048,9 +1093,9 @@ public:
     }
 
     void forward_dfs(std::unordered_map<range_t,br_sample_nplcp,range_hash>& res, std::string const& pattern,
-                    ulint m, ulint allowed_mis, ulint left_pos, ulint right_pos, ulint mis, br_sample_nplcp prev_sample)
+                    ulint m, ulint allowed_mis, ulint left_pos, ulint right_pos, ulint mis, br_sample_nplcp prev_sample) const
     {
-        uchar c = remap[pattern[right_pos]];
+        uchar c = remap[(uchar)pattern[right_pos]];
 
         if (mis == allowed_mis)
         {
@@ -1065,18 +1110,13 @@ public:
             if (sample.rangeR.second - sample.rangeR.first != 
                 prev_sample.rangeR.second - prev_sample.rangeR.first)
             {
-                for (ulint a = 1; a < c; ++a)
-                {
-                    range_t smaller_rangeR = LFR(prev_sample.rangeR,(uchar)a);
-                    acc += (smaller_rangeR.second + 1) - smaller_rangeR.first;
-                }
+                acc = bwtR.rank_less_than(prev_sample.rangeR.second+1,c) - bwtR.rank_less_than(prev_sample.rangeR.first,c);
 
                 sample.range.first = sample.range.first + acc;
                 sample.range.second = sample.range.first + sample.rangeR.second - sample.rangeR.first;
-                ulint rnk = bwtR.rank(prev_sample.rangeR.second+1,c);
-                ulint p = bwtR.select(rnk-1,c);
-                ulint run_of_p = bwtR.run_of_position(p);
-                if (bwtR[prev_sample.rangeR.second] == c)
+                auto last = bwtR.last_run_of(prev_sample.rangeR.second,c);
+                ulint run_of_p = last.first;
+                if (last.second)
                 {
                     sample.j = bwt.size()-2-samples_firstR[run_of_p];
                     sample.p = inv_order_first[run_of_p];
@@ -1127,10 +1167,9 @@ public:
                 {
                     sample.range.first = sample.range.first + acc;
                     sample.range.second = sample.range.first + sample.rangeR.second - sample.rangeR.first;
-                    ulint rnk = bwtR.rank(prev_sample.rangeR.second+1,a);
-                    ulint p = bwtR.select(rnk-1,a);
-                    ulint run_of_p = bwtR.run_of_position(p);
-                    if (bwtR[prev_sample.rangeR.second] == a)
+                    auto last = bwtR.last_run_of(prev_sample.rangeR.second,a);
+                    ulint run_of_p = last.first;
+                    if (last.second)
                     {
                         sample.j = bwt.size()-2-samples_firstR[run_of_p];
                         sample.p = inv_order_first[run_of_p];
@@ -1183,7 +1222,7 @@ public:
     /*
      * locate occurrences of a given pattern
      */
-    std::vector<ulint> locate(std::string const& pattern, bool right=false)
+    std::vector<ulint> locate(std::string const& pattern, bool right=false) const
     {
         if (right) 
         {
@@ -1197,7 +1236,7 @@ public:
         }
         else 
         {
-            br_sample_nplcp sample(get_initial_sample());
+            br_sample_nplcp sample(get_initial_sample(false));
             for (size_t i = 0; i < pattern.size(); ++i)
             {
                 sample = left_only(pattern[pattern.size()-1-i],sample);
@@ -1207,11 +1246,96 @@ public:
         }
     }
 
+    /*
+     * backward search of each pattern. the patterns advance in lockstep, one
+     * character each per step, so the LF steps of different patterns do not
+     * depend on each other. no prefetch is issued: the cache lines of a step
+     * follow from its first lookups. an invalid sample means no occurrence
+     */
+    std::vector<br_sample_nplcp> search_batch(std::vector<std::string> const& patterns) const
+    {
+        std::vector<br_sample_nplcp> samples(patterns.size(), get_initial_sample(false));
+
+        // patterns with characters left to search
+        std::vector<ulint> active;
+        for (ulint k = 0; k < patterns.size(); ++k)
+            if (patterns[k].size() > 0) active.push_back(k);
+
+        for (ulint step = 0; !active.empty(); ++step)
+        {
+            ulint kept = 0;
+            for (auto k: active)
+            {
+                std::string const& p = patterns[k];
+                samples[k] = left_only(p[p.size()-1-step],samples[k]);
+                if (!samples[k].is_invalid() && step+1 < p.size()) active[kept++] = k;
+            }
+            active.resize(kept);
+        }
+
+        return samples;
+    }
+
+    /*
+     * count the occurrences of each pattern by search_batch
+     */
+    std::vector<ulint> count_batch(std::vector<std::string> const& patterns) const
+    {
+        std::vector<br_sample_nplcp> samples = search_batch(patterns);
+
+        std::vector<ulint> res(patterns.size(), 0);
+        for (ulint k = 0; k < patterns.size(); ++k)
+            if (!samples[k].is_invalid()) res[k] = count_sample(samples[k]);
+
+        return res;
+    }
+
+    /*
+     * locate the occurrences of each pattern by search_batch
+     */
+    std::vector<std::vector<ulint> > locate_batch(std::vector<std::string> const& patterns) const
+    {
+        return locate_batch(search_batch(patterns));
+    }
+
+    /*
+     * locate the occurrences of each sample given by search_batch. the Phi
+     * steps of the samples are interleaved in the same way
+     */
+    std::vector<std::vector<ulint> > locate_batch(std::vector<br_sample_nplcp> const& samples) const
+    {
+        std::vector<std::vector<ulint> > res(samples.size());
+
+        // patterns with occurrences left to locate
+        std::vector<ulint> active;
+        for (ulint k = 0; k < samples.size(); ++k)
+        {
+            if (samples[k].is_invalid()) continue;
+
+            res[k].reserve(count_sample(samples[k]));
+            res[k].push_back(samples[k].j - samples[k].d);
+            if (count_sample(samples[k]) > 1) active.push_back(k);
+        }
+
+        while (!active.empty())
+        {
+            ulint kept = 0;
+            for (auto k: active)
+            {
+                res[k].push_back(Phi(res[k].back()));
+                if (res[k].size() < count_sample(samples[k])) active[kept++] = k;
+            }
+            active.resize(kept);
+        }
+
+        return res;
+    }
+
 
     /*
      * get BWT[i] or BWT^R[i]
      */
-    uchar bwt_at(ulint i, bool reversed = false)
+    uchar bwt_at(ulint i, bool reversed = false) const
     {
         if (!reversed) return remap_inv[bwt[i]];
         return remap_inv[bwtR[i]];
@@ -1220,7 +1344,7 @@ public:
     /*
      * get number of runs in BWT
      */
-    ulint number_of_runs(bool reversed = false)
+    ulint number_of_runs(bool reversed = false) const
     {
         if (!reversed) return bwt.number_of_runs();
         return bwtR.number_of_runs();
@@ -1229,7 +1353,7 @@ public:
     /*
      * get position of terminator symbol in BWT
      */
-    ulint get_terminator_position(bool reversed = false)
+    ulint get_terminator_position(bool reversed = false) const
     {
         if (!reversed) return terminator_position;
         return terminator_positionR;
@@ -1238,7 +1362,7 @@ public:
     /*
      * get string representation of BWT
      */
-    std::string get_bwt(bool reversed = false)
+    std::string get_bwt(bool reversed = false) const
     {
         if (!reversed)
         {
@@ -1254,7 +1378,7 @@ public:
         }
     }
 
-    uint serialize(std::ostream& out)
+    uint serialize(std::ostream& out) const
     {
         ulint w_bytes = 0;
 
@@ -1335,13 +1459,14 @@ public:
         inv_order_first.load(in);
         inv_order_last.load(in);
 
+        if (cache) cache->clear();
 
     }
 
     /*
      * save index to "{path_prefix}.brin" file
      */
-    void save_to_file(std::string const& path_prefix)
+    void save_to_file(std::string const& path_prefix) const
     {
 
         std::string path = path_prefix + ".brin";
@@ -1364,18 +1489,18 @@ public:
 
     }
 
-    ulint text_size() { return bwt.size() - 1; }
+    ulint text_size() const { return bwt.size() - 1; }
 
-    ulint bwt_size(bool reversed=false) { return bwt.size(); }
+    ulint bwt_size(bool reversed=false) const { return bwt.size(); }
 
-    uchar get_terminator() {
+    uchar get_terminator() const {
         return TERMINATOR;
     }
 
     /*
      * get statistics
      */
-    ulint print_space() 
+    ulint print_space() const
     {
 
         std::cout << "text length           : " << bwt.size() << std::endl;
@@ -1454,7 +1579,7 @@ public:
     /*
      * get space complexity
      */
-    ulint get_space()
+    ulint get_space() const
     {
 
         ulint tot_bytes = sizeof(sigma)
@@ -1489,8 +1614,150 @@ public:
 
     }
 
+    /*
+     * space in bytes of each component, as in get_space
+     */
+    std::vector<std::pair<std::string, ulint> > space_breakdown() const
+    {
+        std::vector<std::pair<std::string, ulint> > res;
+
+        res.push_back({"header", sizeof(sigma)
+                                 + 256*sizeof(uchar)
+                                 + 256*sizeof(uchar)
+                                 + sizeof(terminator_position)
+                                 + sizeof(terminator_positionR)
+                                 + sizeof(last_SA_val)
+                                 + 256*sizeof(ulint)});
+
+        res.push_back({"bwt", bwt.get_space()});
+        res.push_back({"bwtR", bwtR.get_space()});
+
+        std::ofstream out("/dev/null");
+
+        res.push_back({"samples_first", samples_first.serialize(out)});
+        res.push_back({"samples_last", samples_last.serialize(out)});
+
+        res.push_back({"first", first.serialize(out)});
+        res.push_back({"first_to_run", first_to_run.serialize(out)});
+
+        res.push_back({"last", last.serialize(out)});
+        res.push_back({"last_to_run", last_to_run.serialize(out)});
+
+        res.push_back({"samples_firstR", samples_firstR.serialize(out)});
+        res.push_back({"samples_lastR", samples_lastR.serialize(out)});
+
+        res.push_back({"inv_order_first", inv_order_first.serialize(out)});
+        res.push_back({"inv_order_last", inv_order_last.serialize(out)});
+
+        return res;
+
+    }
+
 private:
 
+    /*
+     * the cached samples are those of searches from the initial sample,
+     * backward or forward, keyed by the substring after the direction
+     */
+    enum cache_tag : char { CACHE_BACKWARD = 'b', CACHE_FORWARD = 'f' };
+
+    static std::string cache_key(cache_tag tag, std::string const& pattern, ulint pos, ulint len)
+    {
+        std::string key(1, tag);
+        key.append(pattern, pos, len);
+        return key;
+    }
+
+    /*
+     * the samples of a search of m characters are cached after m and after
+     * the powers of 2, so a search looks up at most log m + 1 keys
+     */
+    static bool is_checkpoint(ulint len, ulint m)
+    {
+        return len == m || (len & (len - 1)) == 0;
+    }
+
+    // the power of 2 below len
+    static ulint previous_checkpoint(ulint len)
+    {
+        ulint p = 1ULL << (bitsize(len) - 1);
+        return p < len ? p : p / 2;
+    }
+
+    bool is_initial_sample(br_sample_nplcp const& sample) const
+    {
+        return sample.len == 0 && sample.j == get_initial_sample().j;
+    }
+
+    /*
+     * length of the longest suffix (prefix if forward) of P[left...right]
+     * whose sample is cached under tag. its sample is copied to sample.
+     * 0 if there is none
+     */
+    ulint longest_cached(cache_tag tag, std::string const& pattern, ulint left, ulint right, br_sample_nplcp& sample) const
+    {
+        ulint m = right + 1 - left;
+        for (ulint len = m; len > 0; len = previous_checkpoint(len))
+        {
+            ulint pos = tag == CACHE_FORWARD ? left : right + 1 - len;
+            if (cache->find(cache_key(tag, pattern, pos, len), sample)) return len;
+        }
+        return 0;
+    }
+
+    /*
+     * backward search P[left...right] from the initial sample. resumes from
+     * the longest cached suffix, and caches the samples at the checkpoints
+     */
+    br_sample_nplcp backward_search_cached(std::string const& pattern, ulint left, ulint right, br_sample_nplcp sample) const
+    {
+        ulint m = right + 1 - left;
+
+        ulint len = longest_cached(CACHE_BACKWARD, pattern, left, right, sample);
+        if (sample.is_invalid()) return sample;
+
+        while (len < m)
+        {
+            sample = left_extension(pattern[right - len], sample);
+            len++;
+
+            // the whole part is absent
+            if (sample.is_invalid())
+            {
+                cache->insert(cache_key(CACHE_BACKWARD, pattern, left, m), sample);
+                return sample;
+            }
+            if (is_checkpoint(len, m)) cache->insert(cache_key(CACHE_BACKWARD, pattern, right + 1 - len, len), sample);
+        }
+        return sample;
+    }
+
+    /*
+     * forward search P[left...right] from the initial sample. resumes from
+     * the longest cached prefix, and caches the samples at the checkpoints
+     */
+    br_sample_nplcp forward_search_cached(std::string const& pattern, ulint left, ulint right, br_sample_nplcp sample) const
+    {
+        ulint m = right + 1 - left;
+
+        ulint len = longest_cached(CACHE_FORWARD, pattern, left, right, sample);
+        if (sample.is_invalid()) return sample;
+
+        while (len < m)
+        {
+            sample = right_extension(pattern[left + len], sample);
+            len++;
+
+            if (sample.is_invalid())
+            {
+                cache->insert(cache_key(CACHE_FORWARD, pattern, left, m), sample);
+                return sample;
+            }
+            if (is_checkpoint(len, m)) cache->insert(cache_key(CACHE_FORWARD, pattern, left, len), sample);
+        }
+        return sample;
+    }
+
     /*
      * only updates range for SA
      * use when you only search backward
@@ -1498,7 +1765,7 @@ private:
      * assumes sample is SA[r] if range is [l,r]
      * assumes c is original char (not remapped)
      */
-    br_sample_nplcp left_only(uchar c, br_sample_nplcp const& prev_sample)
+    br_sample_nplcp left_only(uchar c, br_sample_nplcp const& prev_sample) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -1511,17 +1778,17 @@ private:
         // pattern cP was not found
         if (sample.is_invalid()) return sample;
 
-        if (bwt[prev_sample.range.second] == c)
+        // the last c in range ends it, or ends a run. the empty pattern ends
+        // the last run, and its j may be a sample of the other direction
+        auto last = bwt.last_run_of(prev_sample.range.second,c);
+
+        if (last.second && prev_sample.len > 0)
         {
             sample.d++;
         } 
         else 
         {
-            ulint rnk = bwt.rank(prev_sample.range.second,c);
-            rnk--;
-            ulint k = bwt.select(rnk,c);
-            ulint run_of_k = bwt.run_of_position(k);
-            sample.j = samples_last[run_of_k];
+            sample.j = samples_last[last.first];
             sample.d = 0;
         }
         sample.len++;
@@ -1536,7 +1803,7 @@ private:
      * assumes sample is SAR[e] if range is [s,e]
      * assumes c is original char (not remapped)
      */
-    br_sample_nplcp right_only(uchar c, br_sample_nplcp const& prev_sample)
+    br_sample_nplcp right_only(uchar c, br_sample_nplcp const& prev_sample) const
     {
         // replace c with internal representation
         c = remap[c];
@@ -1549,13 +1816,13 @@ private:
         // pattern Pc was not found
         if (sample.is_invalid()) return sample;
 
-        if (bwtR[prev_sample.rangeR.second] != c)
+        // the last c in rangeR ends it, or ends a run. the empty pattern ends
+        // the last run, and its j may be a sample of the other direction
+        auto last = bwtR.last_run_of(prev_sample.rangeR.second,c);
+
+        if (!last.second || prev_sample.len == 0)
         {
-            ulint rnk = bwtR.rank(prev_sample.rangeR.second,c);
-            rnk--;
-            ulint k = bwtR.select(rnk,c);
-            ulint run_of_k = bwtR.run_of_position(k);
-            sample.j = bwt.size()-2-samples_lastR[run_of_k];
+            sample.j = bwt.size()-2-samples_lastR[last.first];
             sample.d = sample.len;
         }
         sample.len++;
@@ -1566,7 +1833,7 @@ private:
      * backward search P[left...right]
      * range for SAR is not updated
      */
-    br_sample_nplcp backward_only(std::string const& pattern, ulint left, ulint right, br_sample_nplcp const& sample)
+    br_sample_nplcp backward_only(std::string const& pattern, ulint left, ulint right, br_sample_nplcp const& sample) const
     {
         br_sample_nplcp res(sample);
         for (ulint i = right + 1; i-- > left; )
@@ -1581,7 +1848,7 @@ private:
      * forward search P[left...right]
      * range for SA is not updated
      */
-    br_sample_nplcp forward_only(std::string const& pattern, ulint left, ulint right, br_sample_nplcp const& sample)
+    br_sample_nplcp forward_only(std::string const& pattern, ulint left, ulint right, br_sample_nplcp const& sample) const
     {
         br_sample_nplcp res(sample);
         for (ulint i = left; i <= right; ++i)
@@ -1599,7 +1866,7 @@ private:
      * return them as std::vector
      * (space consuming if result is big)
      */
-    std::vector<ulint> locate_sample_backward(br_sample_nplcp const& sample)
+    std::vector<ulint> locate_sample_backward(br_sample_nplcp const& sample) const
     {
         ulint sa = sample.j - sample.d;
         ulint n_occ = sample.range.second + 1 - sample.range.first;
@@ -1618,10 +1885,62 @@ private:
     }
 
     /*
-     * builds BWT
+     * SA of text (ending with the zero symbol), built in RAM by divsufsort,
+     * or by the parallel sorter if threads > 1
+     */
+    template<class text_t>
+    static sdsl::int_vector<> suffix_array(text_t const& text, ulint threads = 1)
+    {
+        if (threads > 1) return parallel_suffix_array(text, threads);
+
+        // divsufsort needs a contiguous copy
+        ulint n = text.size();
+        std::string buf(n, 0);
+        for (ulint i = 0; i < n; ++i) buf[i] = text[i];
+
+        sdsl::int_vector<> sa(n, 0, bitsize(n));
+        sdsl::algorithm::calculate_sa((const unsigned char*)buf.data(), n, sa);
+        return sa;
+    }
+
+    /*
+     * streams text (ending with the zero symbol) to the cache of cc
+     */
+    template<class text_t>
+    static void store_text(text_t const& text, sdsl::cache_config& cc)
+    {
+        {
+            sdsl::int_vector_buffer<8> buf(sdsl::cache_file_name(sdsl::conf::KEY_TEXT, cc), std::ios::out);
+            for (ulint i = 0; i < text.size(); ++i) buf.push_back(text[i]);
+        }
+        sdsl::register_cache_file(sdsl::conf::KEY_TEXT, cc);
+    }
+
+    /*
+     * fills inv_order_first/last by one scan of SA.
+     * queries: sorted <text position, index in inv_order_first (+rR: inv_order_last)>
+     */
+    template<class sa_t>
+    void inverse_order(sa_t& sa, std::vector<range_t> const& queries)
+    {
+        assert(sa.size() == bwt.size());
+        for (ulint k = 0; k < sa.size(); ++k)
+        {
+            auto it = std::lower_bound(queries.begin(), queries.end(), range_t(sa[k], 0));
+            for (; it != queries.end() && it->first == sa[k]; ++it)
+            {
+                if (it->second < rR) inv_order_first[it->second] = k;
+                else inv_order_last[it->second - rR] = k;
+            }
+        }
+    }
+
+    /*
+     * builds BWT. sa is an int_vector_buffer on the cache or an int_vector in RAM
      */
+    template<class text_t, class sa_t>
     std::tuple<std::string, std::vector<range_t>, std::vector<range_t> > 
-    sufsort(sdsl::int_vector<8>& text, sdsl::int_vector_buffer<>& sa)
+    sufsort(text_t const& text, sa_t& sa)
     {
         std::string bwt_s;
         std::vector<range_t> samples_first;
@@ -1740,8 +2059,14 @@ private:
     // needed for determining the end of locate
     //permuted_lcp<> plcp;
 
+    // optional: samples of hot substrings. a copy of the index starts empty
+    sample_cache_ptr<br_sample_nplcp> cache;
+
 };
 
+// with the wavelet matrix of rank_less_than whatever the build, for large alphabets
+typedef br_index_nplcp<sparse_sd_vector, rle_string_sd_wm> br_index_nplcp_wm;
+
 };
 
 #endif /* INCLUDED_BR_INDEX_NPLCP_HPP */
\ No newline at end of file
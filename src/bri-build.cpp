@@ -4,6 +4,7 @@
 
 #include "br_index.hpp"
 #include "br_index_nplcp.hpp"
+#include "documents.hpp"
 #include "utils.hpp"
 
 using namespace std;
@@ -13,6 +14,19 @@ string out_basename = string();
 string input_file = string();
 bool sais = true;
 bool nplcp = false;
+bool pfp = false;
+bool derive_rev = false;
+bool fasta = false;
+bool list = false;
+ulint pfp_w = 10;
+ulint pfp_p = 100;
+double mem_gb = 0;
+string tmp_dir = "./";
+string profile_file = string();
+bool in_memory = false;
+ulint threads = 1;
+bool from_bwt = false;
+ulint qgram = 0;
 
 void help(){
 	cout << "bri-build: builds the bidirectional r-index. Extension .bri/.brin is automatically added to output index file" << endl << endl;
@@ -22,6 +36,36 @@ void help(){
 	cout << "                        SE-SAIS is used (about 4 time slower than divsufsort, 4n Bytes of RAM)."<<endl;
     cout << "   -nplcp               use the version without PLCP. When locating, calculate LF^d(p) first."<<endl;
     cout << "                        fast when occ is very high, but takes slightly larger space than the normal version."<<endl;
+    cout << "   -pfp                 use prefix-free parsing to build the BWTs. neither SA nor ISA of the whole text is built,"<<endl;
+    cout << "                        so RAM usage is proportional to the dictionary and the parse. not available with -nplcp."<<endl;
+    cout << "   -derive-rev          experimental: derive BWT^R from BWT instead of building it from the reversed text."<<endl;
+    cout << "                        halves suffix sorting (or parsing), but takes up to sigma ranks per step of a"<<endl;
+    cout << "                        traversal that is not bounded by the runs, so it may be much slower. not available"<<endl;
+    cout << "                        with -nplcp."<<endl;
+    cout << "   -w <window>          length of trigger strings for -pfp. Default: 10"<<endl;
+    cout << "   -p <modulus>         modulus of trigger string fingerprints for -pfp. Default: 100"<<endl;
+    cout << "   -from-bwt            input_file_name is the basename of a BWT computed by another tool (e.g. Big-BWT):"<<endl;
+    cout << "                        basename.bwt (BWT of T$, $ = byte 0) and basename.ssa/.esa (5-byte <BWT position, (SA+1) mod n>"<<endl;
+    cout << "                        at the beginnings/ends of runs). BWT^R is read from basename.rev.bwt/.ssa/.esa, or"<<endl;
+    cout << "                        derived with -derive-rev. no suffix is sorted. not available with -nplcp/-pfp."<<endl;
+    cout << "   -fasta               index a collection: each FASTA record of the input file is a document."<<endl;
+    cout << "   -list                index a collection: the input file lists the document files, one per line."<<endl;
+    cout << "                        with -fasta/-list, document boundaries are saved to basename.docs"<<endl;
+    cout << "                        (without them, a basename.docs of a previous build is removed)"<<endl;
+    cout << "   -mem <GB>            RAM budget for the construction. over the budget, BWT and BWT^R are built one after"<<endl;
+    cout << "                        the other, then SE-SAIS replaces divsufsort, then -pfp is used. Default: no limit"<<endl;
+    cout << "   -tmp <dir>           directory of the temporary files. Default: current directory"<<endl;
+    cout << "   -inmem               keep text and SA in RAM instead of temporary files (SA is built by divsufsort,"<<endl;
+    cout << "                        the parse of -pfp is sorted in RAM). faster when RAM suffices."<<endl;
+    cout << "   -threads <N>         sort suffixes in RAM with the parallel sorter of N threads (about 10n Bytes of RAM)"<<endl;
+    cout << "                        compute PLCP and sort the run samples with N threads. BWT and BWT^R are then built"<<endl;
+    cout << "                        one after the other."<<endl;
+    cout << "   -q <q>               store the SA/SA^R ranges of all the q-grams of the text (e.g. q = 10-12 for DNA),"<<endl;
+    cout << "                        so that patterns of length >= q are searched with their last q characters matched"<<endl;
+    cout << "                        at once and absent q-grams are rejected by one lookup. not available with -nplcp."<<endl;
+    cout << "   -profile <file>      save to file a JSON report of the construction: per phase the wall time, the CPU"<<endl;
+    cout << "                        time of its thread, the peak RSS of the process and the bytes of its read/write"<<endl;
+    cout << "                        system calls; n, r and space per component"<<endl;
 	cout << "   <input_file_name>    input text file." << endl;
 	exit(0);
 }
@@ -56,6 +100,151 @@ void parse_args(char** argv, int argc, int &ptr){
 
         nplcp = true;
 
+    }
+    else if (s.compare("-pfp") == 0)
+    {
+
+        pfp = true;
+
+    }
+    else if (s.compare("-derive-rev") == 0)
+    {
+
+        derive_rev = true;
+
+    }
+    else if (s.compare("-from-bwt") == 0)
+    {
+
+        from_bwt = true;
+
+    }
+    else if (s.compare("-fasta") == 0)
+    {
+
+        fasta = true;
+
+    }
+    else if (s.compare("-list") == 0)
+    {
+
+        list = true;
+
+    }
+    else if (s.compare("-mem") == 0)
+    {
+
+        if(ptr >= argc-1){
+            cout << "Error: missing parameter after -mem option." << endl;
+            help();
+        }
+
+        mem_gb = atof(argv[ptr]);
+        ptr++;
+
+        if (mem_gb <= 0){
+            cout << "Error: memory budget must be positive." << endl;
+            help();
+        }
+
+    }
+    else if (s.compare("-tmp") == 0)
+    {
+
+        if(ptr >= argc-1){
+            cout << "Error: missing parameter after -tmp option." << endl;
+            help();
+        }
+
+        tmp_dir = string(argv[ptr]);
+        ptr++;
+
+    }
+    else if (s.compare("-inmem") == 0)
+    {
+
+        in_memory = true;
+
+    }
+    else if (s.compare("-threads") == 0)
+    {
+
+        if(ptr >= argc-1){
+            cout << "Error: missing parameter after -threads option." << endl;
+            help();
+        }
+
+        threads = atoi(argv[ptr]);
+        ptr++;
+
+        if (threads == 0){
+            cout << "Error: number of threads must be positive." << endl;
+            help();
+        }
+
+    }
+    else if (s.compare("-profile") == 0)
+    {
+
+        if(ptr >= argc-1){
+            cout << "Error: missing parameter after -profile option." << endl;
+            help();
+        }
+
+        profile_file = string(argv[ptr]);
+        ptr++;
+
+    }
+    else if (s.compare("-q") == 0)
+    {
+
+        if(ptr >= argc-1){
+            cout << "Error: missing parameter after -q option." << endl;
+            help();
+        }
+
+        qgram = atoi(argv[ptr]);
+        ptr++;
+
+        if (qgram == 0){
+            cout << "Error: q must be positive." << endl;
+            help();
+        }
+
+    }
+    else if (s.compare("-w") == 0)
+    {
+
+        if(ptr >= argc-1){
+            cout << "Error: missing parameter after -w option." << endl;
+            help();
+        }
+
+        pfp_w = atoi(argv[ptr]);
+        ptr++;
+
+        if (pfp_w == 0){
+            cout << "Error: window length must be positive." << endl;
+            help();
+        }
+
+    }
+    else if (s.compare("-p") == 0)
+    {
+
+        if(ptr >= argc-1){
+            cout << "Error: missing parameter after -p option." << endl;
+            help();
+        }
+
+        pfp_p = atoi(argv[ptr]);
+        ptr++;
+
+        if (pfp_p == 0){
+            cout << "Error: modulus must be positive." << endl;
+            help();
+        }
+
     }
     else
     {
@@ -65,6 +254,92 @@ void parse_args(char** argv, int argc, int &ptr){
 
 }
 
+string read_file(string const& path)
+{
+    std::ifstream fs(path);
+    if (!fs)
+    {
+        cout << "Error: cannot open " << path << endl;
+        exit(1);
+    }
+    // read at once into a string of the file size, without an intermediate buffer
+    fs.seekg(0, std::ios::end);
+    string text(fs.tellg(), 0);
+    fs.seekg(0, std::ios::beg);
+    fs.read(&text[0], text.size());
+
+    return text;
+}
+
+// each record is a document named by its header
+void read_fasta(string const& path, vector<string>& docs, vector<string>& names)
+{
+    std::ifstream fs(path);
+    if (!fs)
+    {
+        cout << "Error: cannot open " << path << endl;
+        exit(1);
+    }
+
+    string line;
+    while (getline(fs, line))
+    {
+        if (line.size() > 0 && line.back() == '\r') line.pop_back();
+        if (line.size() == 0) continue;
+
+        if (line[0] == '>')
+        {
+            names.push_back(line.substr(1));
+            docs.push_back(string());
+        }
+        else
+        {
+            if (docs.size() == 0)
+            {
+                cout << "Error: " << path << " is not in FASTA format" << endl;
+                exit(1);
+            }
+            docs.back() += line;
+        }
+    }
+}
+
+// each listed file is a document named by its path
+void read_list(string const& path, vector<string>& docs, vector<string>& names)
+{
+    std::ifstream fs(path);
+    if (!fs)
+    {
+        cout << "Error: cannot open " << path << endl;
+        exit(1);
+    }
+
+    string line;
+    while (getline(fs, line))
+    {
+        if (line.size() == 0) continue;
+
+        names.push_back(line);
+        docs.push_back(read_file(line));
+    }
+}
+
+// records the statistics & space of idx to the profile (if any), then saves idx
+template<class index_t>
+void save_index(index_t& idx, std::ofstream& out, build_profile* profile)
+{
+    if (profile != nullptr)
+    {
+        profile->set("n", idx.text_size());
+        profile->set("r", idx.number_of_runs());
+        profile->set("rR", idx.number_of_runs(true));
+        profile->set_space(idx.space_breakdown());
+    }
+
+    build_profile::phase ph(profile, "serialize");
+    idx.serialize(out);
+}
+
 int main(int argc, char** argv) 
 {
     using std::chrono::high_resolution_clock;
@@ -84,6 +359,36 @@ int main(int argc, char** argv)
 
     input_file = string(argv[ptr]);
 
+    if (pfp && nplcp)
+    {
+        cout << "Error: -pfp is not available with -nplcp." << endl;
+        help();
+    }
+
+    if (derive_rev && nplcp)
+    {
+        cout << "Error: -derive-rev is not available with -nplcp." << endl;
+        help();
+    }
+
+    if (from_bwt && (nplcp || pfp || fasta || list))
+    {
+        cout << "Error: -from-bwt is not available with -nplcp, -pfp, -fasta and -list." << endl;
+        help();
+    }
+
+    if (qgram > 0 && nplcp)
+    {
+        cout << "Error: -q is not available with -nplcp." << endl;
+        help();
+    }
+
+    if (fasta && list)
+    {
+        cout << "Error: -fasta and -list are exclusive." << endl;
+        help();
+    }
+
     if (out_basename.compare("") == 0)
         out_basename = string(input_file);
     
@@ -95,27 +400,134 @@ int main(int argc, char** argv)
     cout << "Building br-index of input file " << input_file << endl;
     cout << "Index will be saved to " << idx_file << endl;
 
+    std::ofstream out(idx_file);
+
+    build_config bc(tmp_dir, (ulint)(mem_gb * (1ULL << 30)));
+    bc.in_memory = in_memory;
+    bc.threads = threads;
+    bc.qgram = qgram;
+
+    build_profile profile;
+    if (profile_file.compare("") != 0)
+    {
+        bc.profile = &profile;
+        cout << "Construction profile will be saved to " << profile_file << endl;
+    }
+
     string input;
 
+    if (fasta || list)
     {
-        std::ifstream fs(input_file);
-        std::stringstream buffer;
-        buffer << fs.rdbuf();
+        build_profile::phase ph(bc.profile, "read input");
+
+        vector<string> docs, names;
+        if (fasta) read_fasta(input_file, docs, names);
+        else read_list(input_file, docs, names);
+
+        if (docs.size() == 0)
+        {
+            cout << "Error: no documents in " << input_file << endl;
+            exit(1);
+        }
+
+        documents<> collection(docs, names, input);
+        collection.save_to_file(out_basename);
 
-        input = buffer.str();
+        cout << "Number of documents: " << collection.size() << endl;
+        cout << "Document boundaries will be saved to " << out_basename << ".docs" << endl;
+    }
+    else if (std::remove((out_basename + ".docs").c_str()) == 0)
+    {
+        // boundaries of a collection previously indexed under this basename
+        cout << "Removed " << out_basename << ".docs of a previous collection" << endl;
     }
 
-    std::ofstream out(idx_file);
+    // suffix sorting needs the text in RAM, PFP only the dictionary & the parse
+    if (!from_bwt && !pfp && !nplcp && bc.mem > 0)
+    {
+        ulint n = input.size();
+        if (!fasta && !list)
+        {
+            std::ifstream fs(input_file, std::ios::ate);
+            n = fs.tellg();
+        }
+
+        if (!bc.fits(n + 1 + sufsort_bytes(n + 1, true)))
+        {
+            pfp = true;
+            cout << "Memory budget: suffix sorting does not fit, -pfp is used" << endl;
+        }
+    }
 
-    if (nplcp)
+    if (from_bwt)
+    {
+        if (!external_bwt::exists(input_file))
+        {
+            cout << "Error: cannot open " << input_file << ".bwt/.ssa/.esa" << endl;
+            exit(1);
+        }
+
+        string rev = input_file + ".rev";
+        if (!external_bwt::exists(rev) && !derive_rev)
+        {
+            cout << "Error: cannot open " << rev << ".bwt/.ssa/.esa (give -derive-rev to derive BWT^R from BWT)" << endl;
+            exit(1);
+        }
+        external_bwt in(input_file, external_bwt::exists(rev) ? rev : "");
+
+        if (in.has_reversed()) cout << "BWT^R is read from " << rev << ".bwt" << endl;
+        else cout << "BWT^R is derived from BWT" << endl;
+
+        br_index<> idx(in, bc);
+        save_index(idx, out, bc.profile);
+    }
+    else if (pfp)
+    {
+        // the text file is memory-mapped by the index
+        string text_file = input_file;
+        if (fasta || list)
+        {
+            text_file = tmp_dir + "/" + idx_file.substr(idx_file.find_last_of('/') + 1) + ".tmp";
+            std::ofstream tmp(text_file);
+            tmp << input;
+        }
+        string().swap(input);
+
+        {
+            br_index<> idx(text_file,pfp_config(pfp_w,pfp_p),derive_rev,bc);
+            save_index(idx, out, bc.profile);
+        }
+
+        if (fasta || list) std::remove(text_file.c_str());
+    }
+    else if (!fasta && !list)
     {
-        br_index_nplcp<> idx(input,sais);
-        idx.serialize(out);
-    } 
-    else 
+        // the text file is memory-mapped and never copied
+        mapped_text text(input_file);
+
+        if (nplcp)
+        {
+            br_index_nplcp<> idx(text,sais,bc);
+            save_index(idx, out, bc.profile);
+        } 
+        else 
+        {
+            br_index<> idx(text,sais,derive_rev,bc);
+            save_index(idx, out, bc.profile);
+        }
+    }
+    else
     {
-        br_index<> idx(input,sais);
-        idx.serialize(out);
+        if (nplcp)
+        {
+            br_index_nplcp<> idx(input,sais,bc);
+            save_index(idx, out, bc.profile);
+        } 
+        else 
+        {
+            br_index<> idx(input,sais,derive_rev,bc);
+            save_index(idx, out, bc.profile);
+        }
     }
 
     auto t2 = high_resolution_clock::now();
@@ -124,4 +536,6 @@ int main(int argc, char** argv)
     cout << "Build time: " << get_time(total) << endl;
 
     out.close();
+
+    if (bc.profile != nullptr) profile.save_to_file(profile_file);
 }
\ No newline at end of file
@@ -4,12 +4,19 @@
 #include "br_index.hpp"
 #include "br_index_nplcp.hpp"
 #include "utils.hpp"
+#include "work_stealing_pool.hpp"
 
 using namespace bri;
 using namespace std;
 
 long allowed = 0;
 bool nplcp = false;
+ulint threads = 1;
+ulint cache_mb = 0;
+
+// patterns of a task of the thread pool, searched together by count_batch
+// when no mismatch is allowed
+const ulint batch_size = 32;
 
 void help()
 {
@@ -19,6 +26,8 @@ void help()
 	cout << "Usage: bri-count [options] <index> <patterns>" << endl;
     cout << "   -nplcp       use the version without PLCP."<<endl;
     cout << "   -m <number>  number of mismatched characters allowed (0 by default)" << endl;
+    cout << "   -t <number>  number of threads searching the patterns (1 by default)" << endl;
+    cout << "   -cache <MB>  cache the search samples of hot pattern substrings in MB megabytes (needs -m)" << endl;
 	cout << "   <index>      index file (with extension .bri)" << endl;
 	cout << "   <patterns>   file in pizza&chili format containing the patterns." << endl;
 	exit(0);
@@ -55,6 +64,46 @@ void parse_args(char** argv, int argc, int &ptr){
 
         nplcp = true;
 
+    }
+    else if (s.compare("-t") == 0)
+    {
+
+        if(ptr>=argc-1){
+            cout << "Error: missing parameter after -t option." << endl;
+            help();
+        }
+
+        char* e;
+        long t = strtol(argv[ptr],&e,10);
+
+        if(*e != '\0' || t <= 0){
+            cout << "Error: number of threads must be positive." << endl;
+            help();
+        }
+        threads = t;
+
+        ptr++;
+
+    }
+    else if (s.compare("-cache") == 0)
+    {
+
+        if(ptr>=argc-1){
+            cout << "Error: missing parameter after -cache option." << endl;
+            help();
+        }
+
+        char* e;
+        long mb = strtol(argv[ptr],&e,10);
+
+        if(*e != '\0' || mb <= 0){
+            cout << "Error: cache size must be positive." << endl;
+            help();
+        }
+        cache_mb = mb;
+
+        ptr++;
+
     }
     else 
     {
@@ -82,6 +131,7 @@ void count_all(ifstream& in, string patterns)
     T idx;
 
     idx.load(in);
+    if (cache_mb > 0) idx.set_cache(cache_mb << 20);
 
     auto t2 = high_resolution_clock::now();
 
@@ -97,33 +147,51 @@ void count_all(ifstream& in, string patterns)
     ulint n = get_number_of_patterns(header);
     ulint m = get_patterns_length(header);
 
-    ulint last_perc = 0;
-
-    ulint occ_tot = 0;
-
-    // extract patterns from file and search them in the index
+    std::vector<string> patts(n);
     for (ulint i = 0; i < n; ++i)
     {
-        ulint perc = 100 * i / n;
-        if (perc > last_perc)
+        for (ulint j = 0; j < m; ++j)
         {
-            cout << perc << "% done ..." << endl;
-            last_perc = perc;
+            char c;
+            ifs.get(c);
+            patts[i] += c;
         }
+    }
 
-        string p = string();
+    ulint tasks = (n + batch_size - 1) / batch_size;
+    work_stealing_pool pool(threads);
+    ordered_output output(cout, tasks);
 
-        for (ulint j = 0; j < m; ++j)
+    // occurrences counted by each thread, merged at the end
+    std::vector<ulint> occ_thr(pool.size(), 0);
+
+    pool.run(tasks, [&](ulint task, ulint t)
+    {
+        ulint b = task * batch_size;
+        ulint e = std::min(n, b + batch_size);
+
+        ostringstream out;
+        for (ulint i = b; i < e; ++i) print_progress(out, i, n);
+
+        if (allowed == 0)
         {
-            char c;
-            ifs.get(c);
-            p += c;
+            for (auto occ: idx.count_batch(std::vector<string>(patts.begin() + b, patts.begin() + e)))
+                occ_thr[t] += occ;
+        }
+        else
+        {
+            for (ulint i = b; i < e; ++i)
+            {
+                auto samples = idx.search_with_mismatch(patts[i],allowed);
+                occ_thr[t] += idx.count_samples(samples);
+            }
         }
 
-        auto samples = idx.search_with_mismatch(p,allowed);
-        occ_tot += idx.count_samples(samples);
+        output.done(task, out.str());
+    });
 
-    }
+    ulint occ_tot = 0;
+    for (auto occ: occ_thr) occ_tot += occ;
 
     double occ_avg = (double)occ_tot / n;
     
@@ -141,9 +209,17 @@ void count_all(ifstream& in, string patterns)
 	cout << "Pattern length                 m = " << m << endl;
 	cout << "Total number of occurrences  occ = " << occ_tot << endl << endl;
 
-    cout << "Total time : " << search << " milliseconds" << endl;
+    cout << "Total time : " << search << " milliseconds";
+    if (pool.size() > 1) cout << " (" << pool.size() << " threads)";
+    cout << endl;
 	cout << "Search time: " << (double)search/n << " milliseconds/pattern (total: " << n << " patterns)" << endl;
 	cout << "Search time: " << (double)search/occ_tot << " milliseconds/occurrence (total: " << occ_tot << " occurrences)" << endl;
+    if (idx.get_cache() != nullptr)
+    {
+        auto cache = idx.get_cache();
+        cout << "Cache hits : " << cache->hits() << " of " << cache->lookups() << " lookups (" << 100 * cache->hit_rate() << "%), "
+             << cache->evictions() << " evictions" << endl;
+    }
 }
 
 
@@ -156,6 +232,13 @@ int main(int argc, char** argv)
 
     while (ptr < argc - 2) parse_args(argv, argc, ptr);
 
+    // the exact batches advance in lockstep without going through the cache
+    if (cache_mb > 0 && allowed == 0)
+    {
+        cout << "Error: -cache needs -m (samples are cached only for searches with mismatches)." << endl;
+        help();
+    }
+
     string idx_file(argv[ptr]);
     string patt_file(argv[ptr+1]);
 
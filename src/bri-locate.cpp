@@ -4,14 +4,23 @@
 
 #include "br_index.hpp"
 #include "br_index_nplcp.hpp"
+#include "documents.hpp"
 #include "utils.hpp"
+#include "work_stealing_pool.hpp"
 
 using namespace bri;
 using namespace std;
 
 string check = string();
+string docs_file = string();
 long allowed = 0;
 bool nplcp = false;
+ulint threads = 1;
+ulint cache_mb = 0;
+
+// patterns of a task of the thread pool, searched together by search_batch &
+// locate_batch when no mismatch is allowed
+const ulint batch_size = 32;
 
 void help()
 {
@@ -21,8 +30,11 @@ void help()
 	cout << "Usage: bri-locate [options] <index> <patterns>" << endl;
     cout << "   -nplcp       use the version without PLCP." << endl;
     cout << "   -m <number>  max number of mismatched characters allowed (0 by default)" << endl;
+    cout << "   -t <number>  number of threads searching the patterns (1 by default)" << endl;
+    cout << "   -cache <MB>  cache the search samples of hot pattern substrings in MB megabytes (needs -m)" << endl;
 	cout << "   -c <text>    check correctness of each pattern occurrence on this text file (must be the same indexed)" << endl;
-	cout << "   <index>      index file (with extension .bri)" << endl;
+	cout << "   <index>      index file (with extension .bri). if basename.docs exists and matches the text length, occurrences are" << endl;
+	cout << "                resolved to <document, offset> and those crossing documents are discarded" << endl;
 	cout << "   <patterns>   file in pizza&chili format containing the patterns." << endl;
 	exit(0);
 }
@@ -70,6 +82,46 @@ void parse_args(char** argv, int argc, int &ptr){
 
         nplcp = true;
 
+    }
+    else if (s.compare("-t") == 0)
+    {
+
+        if(ptr>=argc-1){
+            cout << "Error: missing parameter after -t option." << endl;
+            help();
+        }
+
+        char* e;
+        long t = strtol(argv[ptr],&e,10);
+
+        if(*e != '\0' || t <= 0){
+            cout << "Error: number of threads must be positive." << endl;
+            help();
+        }
+        threads = t;
+
+        ptr++;
+
+    }
+    else if (s.compare("-cache") == 0)
+    {
+
+        if(ptr>=argc-1){
+            cout << "Error: missing parameter after -cache option." << endl;
+            help();
+        }
+
+        char* e;
+        long mb = strtol(argv[ptr],&e,10);
+
+        if(*e != '\0' || mb <= 0){
+            cout << "Error: cache size must be positive." << endl;
+            help();
+        }
+        cache_mb = mb;
+
+        ptr++;
+
     }
     else
     {
@@ -108,6 +160,24 @@ void locate_all(ifstream& in, string patterns)
     T idx;
 
     idx.load(in);
+    if (cache_mb > 0) idx.set_cache(cache_mb << 20);
+
+    documents<> docs;
+    bool d = docs_file.compare(string()) != 0;
+
+    if (d)
+    {
+        docs.load_from_file(docs_file);
+
+        // boundaries of another text indexed under the same basename
+        if (docs.text_size() != idx.text_size())
+        {
+            cout << "Warning: " << docs_file << " does not match the index (text length "
+                 << docs.text_size() << " instead of " << idx.text_size() << "), it is ignored" << endl;
+            d = false;
+        }
+        else cout << "Number of documents: " << docs.size() << endl;
+    }
 
     auto t2 = high_resolution_clock::now();
 
@@ -123,69 +193,123 @@ void locate_all(ifstream& in, string patterns)
     ulint n = get_number_of_patterns(header);
     ulint m = get_patterns_length(header);
 
-    ulint last_perc = 0;
-
-    ulint occ_tot = 0;
-
-    auto t3 = high_resolution_clock::now();
-    auto t4 = high_resolution_clock::now();
-    auto t5 = high_resolution_clock::now();
-    ulint count_time = 0;
-    ulint locate_time = 0;
-    ulint tot_time = 0;
-
-    // extract patterns from file and search them in the index
+    std::vector<string> patts(n);
     for (ulint i = 0; i < n; ++i)
     {
-        ulint perc = 100 * i / n;
-        if (perc > last_perc)
-        {
-            cout << perc << "% done ..." << endl;
-            last_perc = perc;
-        }
-
-        string p = string();
-
         for (ulint j = 0; j < m; ++j)
         {
             char c;
             ifs.get(c);
-            p += c;
+            patts[i] += c;
         }
+    }
 
-        t3 = high_resolution_clock::now();
-        auto samples = idx.search_with_mismatch(p,allowed);
-        t4 = high_resolution_clock::now();
-        auto occs = idx.locate_samples(samples);
-        t5 = high_resolution_clock::now();
+    // a task searches batch_size patterns, without mismatches all at once
+    ulint tasks = (n + batch_size - 1) / batch_size;
+    work_stealing_pool pool(threads);
+    ordered_output output(cout, tasks);
 
-        count_time += duration_cast<microseconds>(t4-t3).count();
-        locate_time += duration_cast<microseconds>(t5-t4).count();
-        occ_tot += occs.size();
-        tot_time += duration_cast<microseconds>(t4-t3).count() + duration_cast<microseconds>(t5-t4).count();
+    // counters of each thread, merged at the end
+    std::vector<ulint> occ_thr(pool.size(), 0);
+    std::vector<ulint> count_thr(pool.size(), 0);
+    std::vector<ulint> locate_thr(pool.size(), 0);
 
+    auto w1 = high_resolution_clock::now();
 
-        if (c) // check occurrences
+    pool.run(tasks, [&](ulint task, ulint t)
+    {
+        ulint b = task * batch_size;
+        ulint e = std::min(n, b + batch_size);
+
+        // progress & check lines of the task, printed in the order of the patterns
+        ostringstream out;
+
+        // searches the patterns [first, last) of the task, all at once without mismatches
+        auto search = [&](ulint first, ulint last)
         {
-            cout << "number of occs with at most " << allowed << " mismatch   : " << occs.size() << endl;
-            for (auto o : occs)
+            std::vector<std::vector<ulint> > batch_occs;
+
+            auto t3 = high_resolution_clock::now();
+            auto t4 = t3;
+            if (allowed == 0)
             {
-                int mismatches = 0;
-                for (size_t i = 0; i < p.size(); ++i)
-                {
-                    if (text[o+i] != p[i]) mismatches++;
-                }
-                if (mismatches > allowed) 
+                auto samples = idx.search_batch(std::vector<string>(patts.begin() + first, patts.begin() + last));
+                t4 = high_resolution_clock::now();
+                batch_occs = idx.locate_batch(samples);
+            }
+            else
+            {
+                auto samples = idx.search_with_mismatch(patts[first],allowed);
+                t4 = high_resolution_clock::now();
+                batch_occs.push_back(idx.locate_samples(samples));
+            }
+            std::vector<std::vector<range_t> > batch_doc_occs(batch_occs.size());
+            if (d)
+            {
+                for (ulint k = 0; k < batch_occs.size(); ++k)
+                    batch_doc_occs[k] = docs.resolve(batch_occs[k], patts[first + k].size());
+            }
+            auto t5 = high_resolution_clock::now();
+
+            count_thr[t] += duration_cast<microseconds>(t4-t3).count();
+            locate_thr[t] += duration_cast<microseconds>(t5-t4).count();
+
+            for (ulint k = 0; k < batch_occs.size(); ++k)
+            {
+                auto const& occs = batch_occs[k];
+                string const& p = patts[first + k];
+                occ_thr[t] += d ? batch_doc_occs[k].size() : occs.size();
+
+                if (c) // check occurrences
                 {
-                    cout << "Error: wrong occurrence:  " << o << endl;
-                    cout << "       original pattern:  " << p << endl;
-                    cout << "       wrong    pattern:  " << text.substr(o,p.size()) << endl;
+                    out << "number of occs with at most " << allowed << " mismatch   : " << occs.size() << endl;
+                    for (auto o : occs)
+                    {
+                        int mismatches = 0;
+                        for (size_t i = 0; i < p.size(); ++i)
+                        {
+                            if (text[o+i] != p[i]) mismatches++;
+                        }
+                        if (mismatches > allowed) 
+                        {
+                            out << "Error: wrong occurrence:  " << o << endl;
+                            out << "       original pattern:  " << p << endl;
+                            out << "       wrong    pattern:  " << text.substr(o,p.size()) << endl;
+                        }
+                    }
                 }
             }
+        };
+
+        if (allowed == 0)
+        {
+            for (ulint i = b; i < e; ++i) print_progress(out, i, n);
+            search(b, e);
+        }
+        else
+        {
+            for (ulint i = b; i < e; ++i)
+            {
+                print_progress(out, i, n);
+                search(i, i + 1);
+            }
         }
 
-        
+        output.done(task, out.str());
+    });
+
+    auto w2 = high_resolution_clock::now();
+
+    ulint occ_tot = 0;
+    ulint count_time = 0;
+    ulint locate_time = 0;
+    for (ulint t = 0; t < pool.size(); ++t)
+    {
+        occ_tot += occ_thr[t];
+        count_time += count_thr[t];
+        locate_time += locate_thr[t];
     }
+    ulint tot_time = count_time + locate_time;
 
     double occ_avg = (double)occ_tot / n;
     
@@ -203,8 +327,18 @@ void locate_all(ifstream& in, string patterns)
     cout << "LF-mapping time: " << count_time << " microseconds" << endl;
     cout << "Phi        time: " << locate_time << " microseconds" << endl;
     cout << "Total time     : " << tot_time << " microseconds" << endl;
+    if (pool.size() > 1)
+    {
+        cout << "Wall time      : " << duration_cast<microseconds>(w2-w1).count() << " microseconds (" << pool.size() << " threads)" << endl;
+    }
 	cout << "Search time    : " << (double)tot_time/n << " microseconds/pattern (total: " << n << " patterns)" << endl;
 	cout << "Search time    : " << (double)tot_time/occ_tot << " microseconds/occurrence (total: " << occ_tot << " occurrences)" << endl;
+    if (idx.get_cache() != nullptr)
+    {
+        auto cache = idx.get_cache();
+        cout << "Cache hits : " << cache->hits() << " of " << cache->lookups() << " lookups (" << 100 * cache->hit_rate() << "%), "
+             << cache->evictions() << " evictions" << endl;
+    }
 }
 
 
@@ -217,11 +351,25 @@ int main(int argc, char** argv)
 
     while (ptr < argc - 2) parse_args(argv, argc, ptr);
 
+    // the exact batches advance in lockstep without going through the cache
+    if (cache_mb > 0 && allowed == 0)
+    {
+        cout << "Error: -cache needs -m (samples are cached only for searches with mismatches)." << endl;
+        help();
+    }
+
     string idx_file(argv[ptr]);
     string patt_file(argv[ptr+1]);
 
     ifstream in(idx_file);
 
+    // document boundaries of a collection
+    {
+        string base = idx_file.substr(0, idx_file.find_last_of('.'));
+        ifstream docs_in(base + ".docs");
+        if (docs_in) docs_file = base + ".docs";
+    }
+
     cout << "Loading br-index" << endl;
 
     if (nplcp)
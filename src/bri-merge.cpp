@@ -0,0 +1,128 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "br_index.hpp"
+#include "documents.hpp"
+#include "utils.hpp"
+
+using namespace std;
+using namespace bri;
+
+string out_basename = string();
+
+void help(){
+	cout << "bri-merge: merges two br-indexes into the index of the concatenation of their texts," << endl;
+	cout << "           separated by a character occurring in neither. no suffix is sorted again." << endl << endl;
+	cout << "Usage: bri-merge [options] <index1> <index2>" << endl;
+	cout << "   -o <basename>   use 'basename' as prefix for the merged index files. Default: basename of index1 + '.merged'" << endl;
+	cout << "   <index1>        index file (with extension .bri) of the first text" << endl;
+	cout << "   <index2>        index file (with extension .bri) of the second text, e.g. the new data" << endl;
+	cout << "                   time is proportional to the length of the second text and the number of runs." << endl;
+	cout << "                   document boundaries (basename.docs) are merged; an index without them is a single document." << endl;
+	cout << "                   each level of merges takes a byte occurring in neither text as separator: merge pairwise" << endl;
+	cout << "                   (k documents in log2(k) levels) rather than one by one (k - 1 levels) for many documents." << endl;
+	exit(0);
+}
+
+void parse_args(char** argv, int argc, int &ptr){
+
+	assert(ptr<argc);
+
+	string s(argv[ptr]);
+	ptr++;
+
+	if (s.compare("-o") == 0)
+    {
+
+		if(ptr >= argc-2){
+			cout << "Error: missing parameter after -o option." << endl;
+			help();
+		}
+
+		out_basename = string(argv[ptr]);
+		ptr++;
+
+	}
+    else
+    {
+		cout << "Error: unrecognized '" << s << "' option." << endl;
+		help();
+	}
+
+}
+
+// documents of the index at idx_file, or a single document named by it
+void load_documents(string const& idx_file, ulint n, documents<>& docs)
+{
+    string base = idx_file.substr(0, idx_file.find_last_of('.'));
+
+    ifstream docs_in(base + ".docs");
+    if (docs_in)
+    {
+        docs.load(docs_in);
+        if (docs.text_size() == n) return;
+
+        cout << "Warning: " << base << ".docs does not match the index, it is ignored" << endl;
+    }
+    docs = documents<>(n, base);
+}
+
+int main(int argc, char** argv)
+{
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::duration;
+
+    auto t1 = high_resolution_clock::now();
+
+    if (argc < 3) help();
+
+    int ptr = 1;
+
+    while (ptr < argc-2) parse_args(argv, argc, ptr);
+
+    string idx_file1(argv[ptr]);
+    string idx_file2(argv[ptr+1]);
+
+    if (out_basename.compare("") == 0)
+        out_basename = idx_file1.substr(0, idx_file1.find_last_of('.')) + ".merged";
+
+    string idx_file = out_basename + ".bri";
+
+    cout << "Merging br-indexes " << idx_file1 << " and " << idx_file2 << endl;
+    cout << "Index will be saved to " << idx_file << endl;
+
+    {
+        br_index<> idx1, idx2;
+
+        cout << "Loading br-indexes" << endl;
+        idx1.load_from_file(idx_file1);
+        idx2.load_from_file(idx_file2);
+
+        uchar sep = br_index<>::merge_separator(idx1, idx2);
+
+        {
+            documents<> docs1, docs2;
+            load_documents(idx_file1, idx1.text_size(), docs1);
+            load_documents(idx_file2, idx2.text_size(), docs2);
+
+            documents<> collection(docs1, docs2, sep);
+            collection.save_to_file(out_basename);
+
+            cout << "Number of documents: " << collection.size() << endl;
+            cout << "Document boundaries will be saved to " << out_basename << ".docs" << endl << endl;
+        }
+
+        br_index<> idx(idx1, idx2, sep);
+
+        std::ofstream out(idx_file);
+        idx.serialize(out);
+        out.close();
+    }
+
+    auto t2 = high_resolution_clock::now();
+
+    ulint total = duration_cast<duration<double, std::ratio<1>>>(t2-t1).count();
+    cout << "Merge time: " << get_time(total) << endl;
+}
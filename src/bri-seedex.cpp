@@ -5,6 +5,7 @@
 #include "br_index.hpp"
 #include "br_index_nplcp.hpp"
 #include "utils.hpp"
+#include "work_stealing_pool.hpp"
 
 using namespace bri;
 using namespace std;
@@ -12,6 +13,11 @@ using namespace std;
 string check = string();
 long allowed = 0;
 bool nplcp = false;
+ulint threads = 1;
+ulint cache_mb = 0;
+
+// patterns of a task of the thread pool
+const ulint batch_size = 32;
 size_t left_len = 0;
 size_t core_len = 0;
 
@@ -23,6 +29,8 @@ void help()
 	cout << "Usage: bri-seedex [options] <index> <patterns>" << endl;
     cout << "   -nplcp       use the version without PLCP." << endl;
     cout << "   -m <number>  max number of mismatched characters allowed (0 by default)" << endl;
+    cout << "   -t <number>  number of threads searching the patterns (1 by default)" << endl;
+    cout << "   -cache <MB>  cache the search samples of hot pattern substrings in MB megabytes" << endl;
 	cout << "   -c <text>    check correctness of each pattern occurrence on this text file (must be the same indexed)" << endl;
 	cout << "   <index>      index file (with extension .bri)" << endl;
 	cout << "   <patterns>   file in pizza&chili format containing the patterns." << endl;
@@ -75,6 +83,46 @@ void parse_args(char** argv, int argc, int &ptr){
 
         nplcp = true;
 
+    }
+    else if (s.compare("-t") == 0)
+    {
+
+        if(ptr>=argc-1){
+            cout << "Error: missing parameter after -t option." << endl;
+            help();
+        }
+
+        char* e;
+        long t = strtol(argv[ptr],&e,10);
+
+        if(*e != '\0' || t <= 0){
+            cout << "Error: number of threads must be positive." << endl;
+            help();
+        }
+        threads = t;
+
+        ptr++;
+
+    }
+    else if (s.compare("-cache") == 0)
+    {
+
+        if(ptr>=argc-1){
+            cout << "Error: missing parameter after -cache option." << endl;
+            help();
+        }
+
+        char* e;
+        long mb = strtol(argv[ptr],&e,10);
+
+        if(*e != '\0' || mb <= 0){
+            cout << "Error: cache size must be positive." << endl;
+            help();
+        }
+        cache_mb = mb;
+
+        ptr++;
+
     }
     else
     {
@@ -113,6 +161,7 @@ void locate_all(ifstream& in, string patterns)
     T idx;
 
     idx.load(in);
+    if (cache_mb > 0) idx.set_cache(cache_mb << 20);
 
     auto t2 = high_resolution_clock::now();
 
@@ -128,86 +177,104 @@ void locate_all(ifstream& in, string patterns)
     ulint n = get_number_of_patterns(header);
     ulint m = get_patterns_length(header);
 
-    ulint last_perc = 0;
-
-    ulint occ_tot = 0;
-
-    auto t3 = high_resolution_clock::now();
-    auto t4 = high_resolution_clock::now();
-    auto t5 = high_resolution_clock::now();
-    ulint count_time = 0;
-    ulint locate_time = 0;
-    ulint tot_time = 0;
-
-    // extract patterns from file and search them in the index
+    std::vector<string> patts(n);
     for (ulint i = 0; i < n; ++i)
     {
-        ulint perc = 100 * i / n;
-        if (perc > last_perc)
-        {
-            cout << perc << "% done ..." << endl;
-            last_perc = perc;
-        }
-
-        string p = string();
-
         for (ulint j = 0; j < m; ++j)
         {
             char c;
             ifs.get(c);
-            p += c;
+            patts[i] += c;
         }
+    }
 
-        size_t m1 = left_len;
-        size_t m2 = left_len + core_len;
+    size_t m1 = left_len;
+    size_t m2 = left_len + core_len;
 
-        t3 = high_resolution_clock::now();
-        auto samples = idx.seed_and_extend(p,m1,m2,allowed);
-        t4 = high_resolution_clock::now();
-        auto occs = idx.locate_samples(samples);
-        t5 = high_resolution_clock::now();
+    ulint tasks = (n + batch_size - 1) / batch_size;
+    work_stealing_pool pool(threads);
+    ordered_output output(cout, tasks);
 
-        count_time += duration_cast<microseconds>(t4-t3).count();
-        locate_time += duration_cast<microseconds>(t5-t4).count();
-        occ_tot += occs.size();
-        tot_time += duration_cast<microseconds>(t4-t3).count() + duration_cast<microseconds>(t5-t4).count();
+    // counters of each thread, merged at the end
+    std::vector<ulint> occ_thr(pool.size(), 0);
+    std::vector<ulint> count_thr(pool.size(), 0);
+    std::vector<ulint> locate_thr(pool.size(), 0);
 
+    auto w1 = high_resolution_clock::now();
+
+    pool.run(tasks, [&](ulint task, ulint t)
+    {
+        ulint b = task * batch_size;
+        ulint e = std::min(n, b + batch_size);
 
-        if (c) // check occurrences
+        // progress & check lines of the task, printed in the order of the patterns
+        ostringstream out;
+
+        for (ulint i = b; i < e; ++i)
         {
-            cout << "number of occs with at most " << allowed << " mismatch   : " << occs.size() << endl;
-            //cout << "the original pattern: " << p << endl;
-            for (auto s : samples)
-            {
-                cout << s.second.range.first << " " << s.second.range.second << " " << s.second.j << " " << s.second.len << endl;
-            }
-            for (auto o : occs)
+            print_progress(out, i, n);
+
+            string const& p = patts[i];
+
+            auto t3 = high_resolution_clock::now();
+            auto samples = idx.seed_and_extend(p,m1,m2,allowed);
+            auto t4 = high_resolution_clock::now();
+            auto occs = idx.locate_samples(samples);
+            auto t5 = high_resolution_clock::now();
+
+            count_thr[t] += duration_cast<microseconds>(t4-t3).count();
+            locate_thr[t] += duration_cast<microseconds>(t5-t4).count();
+            occ_thr[t] += occs.size();
+
+            if (c) // check occurrences
             {
-                int mismatches = 0;
-                for (size_t i = 0; i < m; ++i)
+                out << "number of occs with at most " << allowed << " mismatch   : " << occs.size() << endl;
+                //out << "the original pattern: " << p << endl;
+                for (auto s : samples)
                 {
-                    if (text[o+i] != p[i]) mismatches++;
+                    out << s.second.range.first << " " << s.second.range.second << " " << s.second.j << " " << s.second.len << endl;
                 }
-                if (mismatches > allowed) 
+                for (auto o : occs)
                 {
-                    cout << "Error: wrong occurrence:  " << o << endl;
-                    cout << "       original pattern:  " << p << endl;
-                    cout << "       wrong    pattern:  " << text.substr(o,p.size()) << endl;
-                }
-                for (ulint k = m1; k < m2; ++k)
-                {
-                    if (text[o+k] != p[k]) 
+                    int mismatches = 0;
+                    for (size_t i = 0; i < m; ++i)
+                    {
+                        if (text[o+i] != p[i]) mismatches++;
+                    }
+                    if (mismatches > allowed) 
+                    {
+                        out << "Error: wrong occurrence:  " << o << endl;
+                        out << "       original pattern:  " << p << endl;
+                        out << "       wrong    pattern:  " << text.substr(o,p.size()) << endl;
+                    }
+                    for (ulint k = m1; k < m2; ++k)
                     {
-                        cout << "Error: wrong occurrence:  " << o << endl;
-                        cout << "       original pattern:  " << p << endl;
-                        cout << "       wrong    pattern:  " << text.substr(o,p.size()) << endl;
+                        if (text[o+k] != p[k]) 
+                        {
+                            out << "Error: wrong occurrence:  " << o << endl;
+                            out << "       original pattern:  " << p << endl;
+                            out << "       wrong    pattern:  " << text.substr(o,p.size()) << endl;
+                        }
                     }
                 }
             }
         }
 
-        
+        output.done(task, out.str());
+    });
+
+    auto w2 = high_resolution_clock::now();
+
+    ulint occ_tot = 0;
+    ulint count_time = 0;
+    ulint locate_time = 0;
+    for (ulint t = 0; t < pool.size(); ++t)
+    {
+        occ_tot += occ_thr[t];
+        count_time += count_thr[t];
+        locate_time += locate_thr[t];
     }
+    ulint tot_time = count_time + locate_time;
 
     double occ_avg = (double)occ_tot / n;
     
@@ -225,8 +292,18 @@ void locate_all(ifstream& in, string patterns)
     cout << "LF-mapping time: " << count_time << " microseconds" << endl;
     cout << "Phi        time: " << locate_time << " microseconds" << endl;
     cout << "Total time : " << tot_time << " microseconds" << endl;
+    if (pool.size() > 1)
+    {
+        cout << "Wall time  : " << duration_cast<microseconds>(w2-w1).count() << " microseconds (" << pool.size() << " threads)" << endl;
+    }
 	cout << "Search time: " << (double)tot_time/n << " microseconds/pattern (total: " << n << " patterns)" << endl;
 	cout << "Search time: " << (double)tot_time/occ_tot << " microseconds/occurrence (total: " << occ_tot << " occurrences)" << endl;
+    if (idx.get_cache() != nullptr)
+    {
+        auto cache = idx.get_cache();
+        cout << "Cache hits : " << cache->hits() << " of " << cache->lookups() << " lookups (" << 100 * cache->hit_rate() << "%), "
+             << cache->evictions() << " evictions" << endl;
+    }
 }
 
 
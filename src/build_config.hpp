@@ -0,0 +1,58 @@
+/*
+ * build_config: resources available to the construction of the indexes
+ */
+
+#ifndef INCLUDED_BUILD_CONFIG_HPP
+#define INCLUDED_BUILD_CONFIG_HPP
+
+#include "definitions.hpp"
+#include "build_profile.hpp"
+
+namespace bri {
+
+struct build_config {
+    /*
+     * tmp_dir: directory of the temporary (cache) files
+     * mem: RAM budget in bytes. 0 means no limit
+     * profile: if not null, the phases of the construction are recorded to it
+     * in_memory: text & SA are kept in RAM and handed between the phases,
+     *            without cache files. SA is built by divsufsort
+     * threads: over 1, SA is built in RAM by the parallel sorter (parallel_sa.hpp)
+     *          and PLCP is computed by as many threads
+     * qgram: over 0, the samples of all the q-grams for q = qgram are stored
+     *        (qgram_table.hpp). not supported by br_index_nplcp
+     */
+    std::string tmp_dir;
+    ulint mem;
+    build_profile* profile = nullptr;
+    bool in_memory = false;
+    ulint threads = 1;
+    ulint qgram = 0;
+
+    explicit build_config(std::string const& tmp_dir_ = "./", ulint mem_ = 0) : tmp_dir(tmp_dir_), mem(mem_) {}
+
+    // true iff bytes of RAM are within the budget
+    bool fits(ulint bytes) const { return mem == 0 || bytes <= mem; }
+};
+
+/*
+ * estimated peak RAM in bytes of suffix sorting a text of length n,
+ * the text included (SE-SAIS: 4n, divsufsort: 7.5n)
+ */
+inline ulint sufsort_bytes(ulint n, bool sais)
+{
+    return sais ? 4*n : 15*n/2;
+}
+
+/*
+ * estimated peak RAM in bytes of the parallel suffix sorting of a text
+ * of length n, the text included
+ */
+inline ulint parallel_sufsort_bytes(ulint n)
+{
+    return n < (1ULL << 32) ? 10*n : 18*n;
+}
+
+};
+
+#endif /* INCLUDED_BUILD_CONFIG_HPP */
@@ -0,0 +1,268 @@
+/*
+ * build_profile: resource usage of the phases of a construction, reported as JSON.
+ *
+ *  For each phase: wall time; CPU time of the thread running it, without the
+ *  helper threads it starts (e.g. -threads); the peak RSS of the whole process
+ *  at its end and how much the phase raised it; and the bytes passed to read &
+ *  write system calls by its thread, mostly the sdsl cache files (the input is
+ *  read before the phases start), whether or not they reach the disk. The
+ *  forward & reversed pipelines run concurrently, so their intervals overlap and
+ *  the peak RSS of one includes the memory of the other. The totals are those of
+ *  the process.
+ */
+
+#ifndef INCLUDED_BUILD_PROFILE_HPP
+#define INCLUDED_BUILD_PROFILE_HPP
+
+#include <chrono>
+#include <sys/resource.h>
+
+#include "definitions.hpp"
+
+namespace bri {
+
+class build_profile {
+
+    typedef std::chrono::steady_clock clock;
+
+public:
+
+    build_profile() : start(clock::now()), start_cpu(process_cpu_seconds()) {}
+
+    /*
+     * measures the enclosing scope as a phase. nothing is done if profile is null
+     */
+    class phase {
+    public:
+
+        phase(build_profile* profile, std::string const& name) : profile(profile), name(name)
+        {
+            restart();
+        }
+
+        ~phase()
+        {
+            close();
+        }
+
+        /*
+         * ends this phase and measures the following code as phase name
+         */
+        void next(std::string const& name)
+        {
+            close();
+            this->name = name;
+            restart();
+        }
+
+    private:
+
+        void restart()
+        {
+            if (profile == nullptr) return;
+
+            begin = clock::now();
+            cpu = thread_cpu_seconds();
+            rss = peak_rss();
+            io = thread_io();
+        }
+
+        void close()
+        {
+            if (profile == nullptr) return;
+
+            record rec;
+            rec.name = name;
+            rec.start = seconds(profile->start, begin);
+            rec.wall = seconds(begin, clock::now());
+            rec.cpu = thread_cpu_seconds() - cpu;
+            rec.peak_rss = peak_rss();
+            rec.rss_growth = rec.peak_rss - rss;
+
+            range_t io_end = thread_io();
+            rec.read = io_end.first - io.first;
+            rec.written = io_end.second - io.second;
+
+            profile->add(rec);
+        }
+
+        build_profile* profile;
+        std::string name;
+
+        clock::time_point begin;
+        double cpu = 0;
+        ulint rss = 0;
+        range_t io;
+    };
+
+    /*
+     * statistic of the built index (text length, number of runs, ...)
+     */
+    void set(std::string const& key, ulint value)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stats.push_back({key, value});
+    }
+
+    /*
+     * space in bytes of the components of the built index
+     */
+    void set_space(std::vector<std::pair<std::string, ulint> > const& components)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        space = components;
+    }
+
+    /*
+     * writes the profile as a JSON object
+     */
+    void to_json(std::ostream& out)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        out << "{\n";
+        out << "  \"wall_s\": " << seconds(start, clock::now()) << ",\n";
+        out << "  \"process_cpu_s\": " << process_cpu_seconds() - start_cpu << ",\n";
+        out << "  \"process_peak_rss_bytes\": " << peak_rss() << ",\n";
+
+        out << "  \"statistics\": {";
+        for (ulint i = 0; i < stats.size(); ++i)
+            out << (i > 0 ? ", " : "") << quoted(stats[i].first) << ": " << stats[i].second;
+        out << "},\n";
+
+        out << "  \"phases\": [";
+        for (ulint i = 0; i < phases.size(); ++i)
+        {
+            record const& p = phases[i];
+            out << (i > 0 ? "," : "") << "\n    {"
+                << "\"name\": " << quoted(p.name)
+                << ", \"start_s\": " << p.start
+                << ", \"wall_s\": " << p.wall
+                << ", \"thread_cpu_s\": " << p.cpu
+                << ", \"process_peak_rss_bytes\": " << p.peak_rss
+                << ", \"peak_rss_growth_bytes\": " << p.rss_growth
+                << ", \"syscall_read_bytes\": " << p.read
+                << ", \"syscall_written_bytes\": " << p.written << "}";
+        }
+        out << (phases.size() > 0 ? "\n  ],\n" : "],\n");
+
+        ulint total = 0;
+        out << "  \"space_bytes\": {";
+        for (ulint i = 0; i < space.size(); ++i)
+        {
+            out << (i > 0 ? ", " : "") << quoted(space[i].first) << ": " << space[i].second;
+            total += space[i].second;
+        }
+        out << (space.size() > 0 ? ", " : "") << "\"total\": " << total << "}\n";
+        out << "}\n";
+    }
+
+    /*
+     * save to the JSON file path
+     */
+    void save_to_file(std::string const& path)
+    {
+        std::ofstream out(path);
+        to_json(out);
+        out.close();
+    }
+
+    // number of phases recorded so far
+    ulint size()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return phases.size();
+    }
+
+private:
+
+    struct record {
+        std::string name;
+        double start, wall, cpu;
+        ulint peak_rss, rss_growth, read, written;
+    };
+
+    void add(record const& rec)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        phases.push_back(rec);
+    }
+
+    static double seconds(clock::time_point from, clock::time_point to)
+    {
+        return std::chrono::duration<double>(to - from).count();
+    }
+
+    // user + system CPU time of the process, or of the calling thread
+    static double cpu_seconds(int who)
+    {
+        rusage ru;
+        getrusage(who, &ru);
+        return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec
+               + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+    }
+
+    static double process_cpu_seconds()
+    {
+        return cpu_seconds(RUSAGE_SELF);
+    }
+
+    // RUSAGE_THREAD is Linux only, like /proc/thread-self
+    static double thread_cpu_seconds()
+    {
+#ifdef RUSAGE_THREAD
+        return cpu_seconds(RUSAGE_THREAD);
+#else
+        return 0;
+#endif
+    }
+
+    // peak resident set size of the process in bytes
+    static ulint peak_rss()
+    {
+        rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+        return (ulint)ru.ru_maxrss * 1024;
+    }
+
+    // <bytes read, bytes written> by system calls of the calling thread
+    // (rchar & wchar, including the page cache hits). 0 where unsupported
+    static range_t thread_io()
+    {
+        range_t res(0, 0);
+
+        std::ifstream in("/proc/thread-self/io");
+        std::string key;
+        ulint value;
+        while (in >> key >> value)
+        {
+            if (key == "rchar:") res.first = value;
+            else if (key == "wchar:") res.second = value;
+        }
+        return res;
+    }
+
+    static std::string quoted(std::string const& s)
+    {
+        std::string res("\"");
+        for (auto c: s)
+        {
+            if (c == '"' || c == '\\') res.push_back('\\');
+            res.push_back(c);
+        }
+        return res + "\"";
+    }
+
+    clock::time_point start;
+    double start_cpu;
+
+    std::mutex mtx;
+    std::vector<record> phases;
+    std::vector<std::pair<std::string, ulint> > stats;
+    std::vector<std::pair<std::string, ulint> > space;
+
+};
+
+};
+
+#endif /* INCLUDED_BUILD_PROFILE_HPP */
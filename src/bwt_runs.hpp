@@ -0,0 +1,85 @@
+/*
+ * bwt_runs: the BWT as a sequence of equal-letter runs, together with the
+ * SA samples at the run boundaries. It is filled while the BWT is produced,
+ * so that the BWT itself is never materialized.
+ */
+
+#ifndef INCLUDED_BWT_RUNS_HPP
+#define INCLUDED_BWT_RUNS_HPP
+
+#include "definitions.hpp"
+
+namespace bri {
+
+class bwt_runs {
+
+public:
+
+    bwt_runs() {}
+
+    /*
+     * constructor
+     * \param n: length of the BWT (text length + 1)
+     */
+    bwt_runs(ulint n) : n(n) {}
+
+    /*
+     * append c^len to the BWT
+     * \param sa_first: SA value at the first position of c^len
+     * \param sa_last: SA value at the last position of c^len
+     */
+    void push_back(uchar c, ulint len, ulint sa_first, ulint sa_last)
+    {
+        assert(len > 0);
+        assert(sa_first < n && sa_last < n);
+
+        if (heads.size() > 0 && (uchar)heads.back() == c)
+        {
+            // extend the current run
+            lengths.back() += len;
+            samples_last.back().first = sample(sa_last);
+        }
+        else
+        {
+            heads.push_back(c);
+            lengths.push_back(len);
+            samples_first.push_back({sample(sa_first), samples_first.size()});
+            samples_last.push_back({sample(sa_last), samples_last.size()});
+        }
+
+        size += len;
+        last_SA = sa_last;
+    }
+
+    ulint number_of_runs() { return heads.size(); }
+
+    // BWT length
+    ulint n = 0;
+
+    // number of characters pushed so far
+    ulint size = 0;
+
+    // SA value at the last pushed position
+    ulint last_SA = 0;
+
+    // run heads & run lengths
+    std::string heads;
+    std::vector<ulint> lengths;
+
+    // <text position of BWT character, run number> at beginnings & ends of runs
+    std::vector<range_t> samples_first;
+    std::vector<range_t> samples_last;
+
+private:
+
+    // text position of the BWT character at SA value sa
+    ulint sample(ulint sa)
+    {
+        return sa > 0 ? sa - 1 : n - 1;
+    }
+
+};
+
+};
+
+#endif /* INCLUDED_BWT_RUNS_HPP */
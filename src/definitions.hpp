@@ -3,11 +3,15 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <deque>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <new>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
@@ -43,6 +47,36 @@ struct range_hash
 
 };
 
+/*
+ * allocator of storage aligned to a cache line (64 bytes), e.g. for arrays of
+ * entries padded to whole cache lines
+ */
+template<class T>
+struct cache_aligned_allocator
+{
+    typedef T value_type;
+
+    cache_aligned_allocator() {}
+
+    template<class U>
+    cache_aligned_allocator(cache_aligned_allocator<U> const&) {}
+
+    T* allocate(std::size_t n)
+    {
+        void* p = nullptr;
+        if (posix_memalign(&p, 64, std::max<std::size_t>(1, n * sizeof(T))) != 0) throw std::bad_alloc();
+        return (T*)p;
+    }
+
+    void deallocate(T* p, std::size_t) { free(p); }
+};
+
+template<class T, class U>
+bool operator==(cache_aligned_allocator<T> const&, cache_aligned_allocator<U> const&) { return true; }
+
+template<class T, class U>
+bool operator!=(cache_aligned_allocator<T> const&, cache_aligned_allocator<U> const&) { return false; }
+
 };
 
 #endif /* INCLUDED_DEFINITIONS_HPP */
\ No newline at end of file
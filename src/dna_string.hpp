@@ -0,0 +1,214 @@
+/*
+ * dna_string: a string over at most 8 distinct symbols (e.g. terminator, A, C,
+ * G, T, N) with rank/select, meant for the run heads of a DNA BWT in place of
+ * huffman_string.
+ *
+ *  The symbols get 3-bit codes stored as 3 bit-planes. Every 64 positions form
+ *  one contiguous block: the 3 planes followed by the number of each code before
+ *  the block, so rank reads one block and makes one popcount, and access reads
+ *  3 bits. space: (3 + sigma) * 64 bits per 64 symbols.
+ */
+
+#ifndef INCLUDED_DNA_STRING_HPP
+#define INCLUDED_DNA_STRING_HPP
+
+#include "definitions.hpp"
+
+namespace bri {
+
+class dna_string {
+
+public:
+
+    // maximum number of distinct symbols
+    static const ulint MAX_SIGMA = 8;
+
+    dna_string() {}
+
+    /*
+     * constructor
+     * \param s: string with at most MAX_SIGMA distinct symbols
+     */
+    dna_string(std::string const& s)
+    {
+        n = s.size();
+
+        code_of = std::vector<uchar>(256, NONE);
+        symbol_of = std::vector<uchar>();
+        for (uchar c: s)
+        {
+            if (code_of[c] != NONE) continue;
+            if (symbol_of.size() == MAX_SIGMA)
+            {
+                std::cout << "Error: more than " << MAX_SIGMA << " symbols in dna_string" << std::endl;
+                exit(1);
+            }
+            code_of[c] = 0;
+            symbol_of.push_back(c);
+        }
+
+        // codes in the order of the symbols
+        std::sort(symbol_of.begin(), symbol_of.end());
+        for (ulint k = 0; k < symbol_of.size(); ++k) code_of[symbol_of[k]] = k;
+
+        sigma = symbol_of.size();
+        stride = 3 + sigma;
+
+        // one more block holding the total counts
+        ulint blocks = n / 64 + 1;
+        data = std::vector<uint64_t>(blocks * stride, 0);
+
+        std::vector<ulint> count(sigma, 0);
+        for (ulint b = 0; b < blocks; ++b)
+        {
+            uint64_t* block = &data[b * stride];
+            for (ulint k = 0; k < sigma; ++k) block[3 + k] = count[k];
+
+            for (ulint i = b * 64; i < std::min(n, (b + 1) * 64); ++i)
+            {
+                uchar code = code_of[(uchar)s[i]];
+                for (ulint p = 0; p < 3; ++p)
+                    block[p] |= uint64_t((code >> p) & 1) << (i % 64);
+                count[code]++;
+            }
+        }
+    }
+
+    uchar operator[](size_t i) const
+    {
+        assert(i < n);
+
+        uint64_t const* block = &data[(i / 64) * stride];
+        ulint bit = i % 64;
+
+        uchar code = ((block[0] >> bit) & 1)
+                   | (((block[1] >> bit) & 1) << 1)
+                   | (((block[2] >> bit) & 1) << 2);
+
+        return symbol_of[code];
+    }
+
+    /*
+     * length of the string
+     */
+    size_t size() const
+    {
+        return n;
+    }
+
+    /*
+     * number of character c in S[0...i-1]
+     */
+    ulint rank(size_t i, uchar c) const
+    {
+        assert(i <= n);
+
+        if (code_of[c] == NONE) return 0;
+        uchar code = code_of[c];
+
+        uint64_t const* block = &data[(i / 64) * stride];
+        ulint bit = i % 64;
+
+        ulint res = block[3 + code];
+        if (bit > 0) res += __builtin_popcountll(match(block, code) & ((1ULL << bit) - 1));
+
+        return res;
+    }
+
+    /*
+     * position of i-th character c
+     * i starts from 0
+     */
+    ulint select(ulint i, uchar c) const
+    {
+        assert(code_of[c] != NONE);
+        uchar code = code_of[c];
+
+        // last block with at most i c's before it
+        ulint lo = 0, hi = data.size() / stride - 1;
+        while (lo < hi)
+        {
+            ulint mid = (lo + hi + 1) / 2;
+            if (data[mid * stride + 3 + code] <= i) lo = mid;
+            else hi = mid - 1;
+        }
+
+        uint64_t const* block = &data[lo * stride];
+        uint64_t m = match(block, code);
+
+        // drop the c's of the block before the i-th one
+        for (ulint k = block[3 + code]; k < i; ++k) m &= m - 1;
+
+        assert(m != 0);
+        return lo * 64 + __builtin_ctzll(m);
+    }
+
+    /*
+     * serialize the string to the ostream
+     */
+    ulint serialize(std::ostream& out) const
+    {
+        ulint size = data.size();
+        ulint w_bytes = 0;
+
+        out.write((char*)&n, sizeof(n));
+        out.write((char*)&sigma, sizeof(sigma));
+        out.write((char*)symbol_of.data(), sigma);
+        out.write((char*)&size, sizeof(size));
+        out.write((char*)data.data(), size * sizeof(uint64_t));
+
+        w_bytes += sizeof(n) + sizeof(sigma) + sigma + sizeof(size) + size * sizeof(uint64_t);
+
+        return w_bytes;
+    }
+
+    /*
+     * load the string from the istream
+     */
+    void load(std::istream& in)
+    {
+        ulint size = 0;
+
+        in.read((char*)&n, sizeof(n));
+        in.read((char*)&sigma, sizeof(sigma));
+        symbol_of = std::vector<uchar>(sigma);
+        in.read((char*)symbol_of.data(), sigma);
+        in.read((char*)&size, sizeof(size));
+        data = std::vector<uint64_t>(size);
+        in.read((char*)data.data(), size * sizeof(uint64_t));
+
+        stride = 3 + sigma;
+        code_of = std::vector<uchar>(256, NONE);
+        for (ulint k = 0; k < sigma; ++k) code_of[symbol_of[k]] = k;
+    }
+
+private:
+
+    /*
+     * positions of the block with the given code
+     */
+    static uint64_t match(uint64_t const* block, uchar code)
+    {
+        return (code & 1 ? block[0] : ~block[0])
+             & (code & 2 ? block[1] : ~block[1])
+             & (code & 4 ? block[2] : ~block[2]);
+    }
+
+    static const uchar NONE = 255;
+
+    ulint n = 0;
+    ulint sigma = 0;
+
+    // 3-bit code of each symbol (NONE if absent) and symbol of each code
+    std::vector<uchar> code_of;
+    std::vector<uchar> symbol_of;
+
+    // blocks of 64 positions: 3 bit-planes, then the count of each code before the block
+    std::vector<uint64_t> data;
+    ulint stride = 0;
+
+};
+
+};
+
+#endif /* INCLUDED_DNA_STRING_HPP */
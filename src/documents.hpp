@@ -0,0 +1,259 @@
+/*
+ * documents: boundaries of the documents of a collection indexed as a single text.
+ *
+ *  The documents are concatenated with a separator character occurring in none
+ *  of them, so an exact match never crosses a document boundary. Separator
+ *  positions are kept in a sparse bitvector, which maps a text position to
+ *  <document, offset> with one rank and one select.
+ */
+
+#ifndef INCLUDED_DOCUMENTS_HPP
+#define INCLUDED_DOCUMENTS_HPP
+
+#include "definitions.hpp"
+#include "sparse_sd_vector.hpp"
+
+namespace bri {
+
+template<class sparse_bitvector_t = sparse_sd_vector>
+class documents {
+
+public:
+
+    documents() {}
+
+    /*
+     * constructor. concatenates the documents into text
+     * \param docs: the documents. separator must occur in none of them
+     * \param names: names of the documents (FASTA headers, file names, ...)
+     * \param text: (output) d_0 # d_1 # ... # d_{k-1}, # being the separator
+     */
+    documents(std::vector<std::string> const& docs, std::vector<std::string> const& names, std::string& text)
+    {
+        assert(docs.size() > 0 && docs.size() == names.size());
+
+        sep = choose_separator(docs);
+        this->names = names;
+
+        text.clear();
+        std::vector<ulint> seps;
+        for (ulint i = 0; i < docs.size(); ++i)
+        {
+            if (i > 0)
+            {
+                seps.push_back(text.size());
+                text.push_back(sep);
+            }
+            text += docs[i];
+        }
+
+        n = text.size();
+        separators = sparse_bitvector_t(seps, n);
+    }
+
+    /*
+     * constructor. a single document of length n
+     */
+    documents(ulint n, std::string const& name) : n(n)
+    {
+        names.push_back(name);
+        separators = sparse_bitvector_t(std::vector<ulint>(), n);
+    }
+
+    /*
+     * constructor. documents of the concatenation T1 sep T2 of two collections
+     * (see the merging constructor of br_index). the separators of d1 & d2 are
+     * kept as boundaries, so that resolve() still splits their documents
+     */
+    documents(documents& d1, documents& d2, uchar sep) : n(d1.n + 1 + d2.n), sep(sep)
+    {
+        names = d1.names;
+        names.insert(names.end(), d2.names.begin(), d2.names.end());
+
+        std::vector<ulint> seps;
+        for (ulint i = 0; i + 1 < d1.size(); ++i) seps.push_back(d1.separators.select(i));
+        seps.push_back(d1.n);
+        for (ulint i = 0; i + 1 < d2.size(); ++i) seps.push_back(d1.n + 1 + d2.separators.select(i));
+
+        separators = sparse_bitvector_t(seps, n);
+    }
+
+    /*
+     * separator: the smallest character not occurring in the documents.
+     * 0 and 1 are reserved for the terminators
+     */
+    static uchar choose_separator(std::vector<std::string> const& docs)
+    {
+        std::vector<bool> used(256,false);
+        for (auto const& d: docs)
+            for (auto c: d) used[(uchar)c] = true;
+
+        for (ulint c = 2; c < 256; ++c)
+            if (!used[c]) return (uchar)c;
+
+        std::cout << "Error: no character is left for the document separator" << std::endl;
+        exit(1);
+    }
+
+    /*
+     * document number & offset in the document of text position i
+     */
+    range_t document_of(ulint i) const
+    {
+        assert(i < n);
+
+        ulint d = separators.rank(i);
+        ulint begin = d == 0 ? 0 : separators.select(d-1) + 1;
+
+        return {d, i - begin};
+    }
+
+    /*
+     * true iff the occurrence [i, i+m) lies inside one document
+     */
+    bool inside(ulint i, ulint m) const
+    {
+        assert(i + m <= n);
+        return separators.rank(i+m) == separators.rank(i);
+    }
+
+    /*
+     * <document, offset> of text occurrences of length m.
+     * occurrences crossing a boundary (possible only with mismatches) are discarded
+     */
+    std::vector<range_t> resolve(std::vector<ulint> const& occs, ulint m) const
+    {
+        std::vector<range_t> res;
+        res.reserve(occs.size());
+
+        for (auto o: occs)
+            if (inside(o, m)) res.push_back(document_of(o));
+
+        return res;
+    }
+
+    /*
+     * locate the occurrences of pattern as <document, offset>
+     */
+    template<class index_t>
+    std::vector<range_t> locate(index_t const& idx, std::string const& pattern) const
+    {
+        // a match containing the separator would cross a boundary
+        if (pattern.find((char)sep) != std::string::npos) return std::vector<range_t>();
+
+        return resolve(idx.locate(pattern), pattern.size());
+    }
+
+    uchar separator() const { return sep; }
+
+    // number of documents
+    ulint size() const { return names.size(); }
+
+    std::string const& name(ulint d) const
+    {
+        assert(d < names.size());
+        return names[d];
+    }
+
+    // length of the concatenated text
+    ulint text_size() const { return n; }
+
+    ulint serialize(std::ostream& out) const
+    {
+        ulint w_bytes = 0;
+
+        out.write((char*)&n,sizeof(n));
+        out.write((char*)&sep,sizeof(sep));
+
+        w_bytes += sizeof(n) + sizeof(sep);
+
+        ulint k = names.size();
+        out.write((char*)&k,sizeof(k));
+        w_bytes += sizeof(k);
+
+        for (auto const& s: names)
+        {
+            ulint len = s.size();
+            out.write((char*)&len,sizeof(len));
+            out.write(s.data(),len);
+            w_bytes += sizeof(len) + len;
+        }
+
+        w_bytes += separators.serialize(out);
+
+        return w_bytes;
+    }
+
+    void load(std::istream& in)
+    {
+        in.read((char*)&n,sizeof(n));
+        in.read((char*)&sep,sizeof(sep));
+
+        ulint k;
+        in.read((char*)&k,sizeof(k));
+
+        names = std::vector<std::string>(k);
+        for (auto& s: names)
+        {
+            ulint len;
+            in.read((char*)&len,sizeof(len));
+            s.resize(len);
+            in.read(&s[0],len);
+        }
+
+        separators.load(in);
+    }
+
+    /*
+     * save to "{path_prefix}.docs" file
+     */
+    void save_to_file(std::string const& path_prefix)
+    {
+        std::ofstream out(path_prefix + ".docs");
+        serialize(out);
+        out.close();
+    }
+
+    void load_from_file(std::string const& path)
+    {
+        std::ifstream in(path);
+        load(in);
+        in.close();
+    }
+
+    ulint print_space() const
+    {
+        std::ofstream out("/dev/null");
+
+        std::cout << "space for documents:" << std::endl;
+
+        auto bytes = separators.serialize(out);
+        std::cout << "- bitvector separators: " << bytes << " bytes" << std::endl;
+
+        return serialize(out);
+    }
+
+    ulint get_space() const
+    {
+        std::ofstream out("/dev/null");
+        return serialize(out);
+    }
+
+private:
+
+    // length of the concatenated text
+    ulint n = 0;
+
+    // separator character (not remapped)
+    uchar sep = 0;
+
+    std::vector<std::string> names;
+
+    // positions of separators in the text
+    sparse_bitvector_t separators;
+
+};
+
+};
+
+#endif /* INCLUDED_DOCUMENTS_HPP */
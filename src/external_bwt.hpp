@@ -0,0 +1,136 @@
+/*
+ * external_bwt: a BWT and its SA samples at run boundaries computed by another
+ * tool, in the format of Big-BWT:
+ *
+ *  basename.bwt: BWT of T$, one byte per character, $ being the byte 0
+ *  basename.ssa: <BWT position, SA value> at the beginning of every run
+ *  basename.esa: <BWT position, SA value> at the end of every run
+ *
+ *  Samples are in BWT order, each value a 5-byte little-endian integer. As
+ *  written by Big-BWT, an SA value is stored as (SA[i] + 1) mod n, n being the
+ *  length of the BWT. Samples at other positions are skipped, so runs need not
+ *  be maximal.
+ */
+
+#ifndef INCLUDED_EXTERNAL_BWT_HPP
+#define INCLUDED_EXTERNAL_BWT_HPP
+
+#include "definitions.hpp"
+#include "bwt_runs.hpp"
+#include "mapped_text.hpp"
+
+namespace bri {
+
+class external_bwt {
+
+public:
+
+    // bytes of a position or SA value in the sample files
+    static const ulint SABYTES = 5;
+
+    /*
+     * constructor
+     * \param basename: prefix of the files of BWT
+     * \param basenameR: prefix of the files of BWT^R. if empty, BWT^R is derived from BWT
+     */
+    external_bwt(std::string const& basename, std::string const& basenameR = "") :
+        basename(basename), basenameR(basenameR) {}
+
+    // true iff basename.bwt, basename.ssa & basename.esa exist
+    static bool exists(std::string const& basename)
+    {
+        return std::ifstream(basename + ".bwt").good()
+            && std::ifstream(basename + ".ssa").good()
+            && std::ifstream(basename + ".esa").good();
+    }
+
+    // true iff the files of BWT^R are given
+    bool has_reversed() const { return basenameR.size() > 0; }
+
+    // path of the BWT (BWT^R if reversed) file
+    std::string bwt_file(bool reversed = false) const
+    {
+        return (reversed ? basenameR : basename) + ".bwt";
+    }
+
+    /*
+     * appends the runs of the BWT (BWT^R if reversed) in bwt with their SA samples to out
+     * \param remap: alphabet remapper. the byte 0 becomes terminator
+     */
+    void read_runs(mapped_text const& bwt, std::vector<uchar> const& remap, uchar terminator,
+                   bool reversed, bwt_runs& out) const
+    {
+        std::string base = reversed ? basenameR : basename;
+        std::ifstream ssa(base + ".ssa", std::ios::binary);
+        std::ifstream esa(base + ".esa", std::ios::binary);
+        if (!ssa || !esa)
+        {
+            std::cout << "Error: cannot open " << base << ".ssa/.esa" << std::endl;
+            exit(1);
+        }
+
+        ulint n = bwt.size();
+        ulint terminators = 0;
+
+        for (ulint b = 0, e; b < n; b = e)
+        {
+            e = b + 1;
+            while (e < n && bwt[e] == bwt[b]) ++e;
+
+            if (bwt[b] == 0) terminators += e - b;
+
+            ulint sa_first = sample_at(ssa, b, n, base + ".ssa");
+            ulint sa_last = sample_at(esa, e - 1, n, base + ".esa");
+
+            out.push_back(bwt[b] == 0 ? terminator : remap[bwt[b]], e - b, sa_first, sa_last);
+        }
+
+        if (terminators != 1)
+        {
+            std::cout << "Error: " << base << ".bwt must contain the byte 0 exactly once" << std::endl;
+            exit(1);
+        }
+    }
+
+private:
+
+    /*
+     * SA value of the sample at BWT position pos, skipping the samples before it.
+     * the stored value is (SA + 1) mod n
+     */
+    static ulint sample_at(std::ifstream& in, ulint pos, ulint n, std::string const& path)
+    {
+        ulint p = 0, sa = 0;
+        do
+        {
+            if (!read_value(in, p) || !read_value(in, sa))
+            {
+                std::cout << "Error: no sample at BWT position " << pos << " in " << path << std::endl;
+                exit(1);
+            }
+        }
+        while (p < pos);
+
+        if (p != pos || sa >= n)
+        {
+            std::cout << "Error: no sample at BWT position " << pos << " in " << path << std::endl;
+            exit(1);
+        }
+        return sa > 0 ? sa - 1 : n - 1;
+    }
+
+    static bool read_value(std::ifstream& in, ulint& x)
+    {
+        x = 0;
+        in.read((char*)&x, SABYTES);
+        return (ulint)in.gcount() == SABYTES;
+    }
+
+    std::string basename;
+    std::string basenameR;
+
+};
+
+};
+
+#endif /* INCLUDED_EXTERNAL_BWT_HPP */
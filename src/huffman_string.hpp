@@ -21,12 +21,18 @@ public:
     huffman_string(std::string& s)
     {
         s.push_back(0);
-        sdsl::construct_im(wt, s.c_str(), 1);
+        {
+            // construct_im names its temporary files with a counter
+            // that is not thread-safe
+            static std::mutex construct_mutex;
+            std::lock_guard<std::mutex> lock(construct_mutex);
+            sdsl::construct_im(wt, s.c_str(), 1);
+        }
 
         assert(wt.size()==s.size()-1);
     }
 
-    uchar operator[](size_t i) 
+    uchar operator[](size_t i) const
     {
 
         assert(i<wt.size());
@@ -37,7 +43,7 @@ public:
     /*
      * length of the string
      */
-    size_t size()
+    size_t size() const
     {
         return wt.size();
     }
@@ -45,7 +51,7 @@ public:
     /*
      * number of character c in S[0...i-1]
      */
-    ulint rank(size_t i, uchar c)
+    ulint rank(size_t i, uchar c) const
     {
         assert(i<=wt.size());
         return wt.rank(i,c);
@@ -55,7 +61,7 @@ public:
      * position of i-th character c
      * i starts from 0
      */
-    ulint select(ulint i, uchar c)
+    ulint select(ulint i, uchar c) const
     {
         return wt.select(i+1,c);
     }
@@ -63,7 +69,7 @@ public:
     /*
      * serialize the index to the ostream
      */
-    ulint serialize(std::ostream& out)
+    ulint serialize(std::ostream& out) const
     {
         return wt.serialize(out);
     }
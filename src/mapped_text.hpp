@@ -0,0 +1,87 @@
+/*
+ * mapped_text: a read-only memory-mapped text file with random access
+ */
+
+#ifndef INCLUDED_MAPPED_TEXT_HPP
+#define INCLUDED_MAPPED_TEXT_HPP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "definitions.hpp"
+
+namespace bri {
+
+class mapped_text {
+
+public:
+
+    mapped_text() {}
+
+    /*
+     * constructor. maps the whole file read-only
+     * \param path: path of the text file
+     */
+    mapped_text(std::string const& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            std::cout << "Error: cannot open " << path << std::endl;
+            exit(1);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            std::cout << "Error: cannot stat " << path << std::endl;
+            exit(1);
+        }
+
+        n = st.st_size;
+
+        if (n > 0)
+        {
+            void* addr = mmap(NULL, n, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED)
+            {
+                std::cout << "Error: cannot map " << path << std::endl;
+                exit(1);
+            }
+            // no access advice: besides the scans of the text, suffix sorting
+            // and PLCP read it in SA order, i.e. at random
+            data = (const uchar*)addr;
+        }
+
+        close(fd);
+    }
+
+    ~mapped_text()
+    {
+        if (data != NULL) munmap((void*)data, n);
+    }
+
+    uchar operator[](ulint i) const
+    {
+        assert(i < n);
+        return data[i];
+    }
+
+    ulint size() const { return n; }
+
+private:
+
+    // the mapping is owned, so copying is not allowed
+    mapped_text(mapped_text const&);
+    mapped_text& operator=(mapped_text const&);
+
+    const uchar* data = NULL;
+    ulint n = 0;
+
+};
+
+};
+
+#endif /* INCLUDED_MAPPED_TEXT_HPP */
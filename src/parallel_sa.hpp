@@ -0,0 +1,225 @@
+/*
+ * parallel_sa: suffix array construction using multiple threads.
+ *
+ *  Prefix doubling in the style of Larsson & Sadakane: suffixes are first sorted
+ *  by their prefixes of 8 characters, then each group of suffixes sharing their
+ *  h first characters is sorted by the rank of the suffix h positions ahead,
+ *  doubling h until every group is a singleton. The groups of a round are
+ *  independent, so they are distributed among the threads (a large group is
+ *  split among all of them). O(n log n) work, 9n bytes (17n for n >= 2^32)
+ *  besides the text.
+ */
+
+#ifndef INCLUDED_PARALLEL_SA_HPP
+#define INCLUDED_PARALLEL_SA_HPP
+
+#include "definitions.hpp"
+#include "utils.hpp"
+
+namespace bri {
+
+template<class index_t>
+class parallel_sa {
+
+public:
+
+    /*
+     * \param text: text ending with its unique smallest symbol 0
+     * \param threads: number of threads (>= 1)
+     */
+    template<class text_t>
+    parallel_sa(text_t const& text, ulint threads) : n(text.size()), threads(std::max<ulint>(threads, 1))
+    {
+        assert(n > 0 && text[n-1] == 0);
+
+        sa = std::vector<index_t>(n);
+        rank = std::vector<index_t>(n);
+        head = std::vector<uchar>(n, 0);
+
+        for (ulint i = 0; i < n; ++i) sa[i] = i;
+
+        // first round: the prefixes of 8 characters, packed in one word
+        auto key = [&](ulint i) -> ulint
+        {
+            ulint k = 0;
+            for (ulint j = 0; j < 8; ++j)
+                k = (k << 8) | (i + j < n ? (uchar)text[i + j] : 0);
+            return k;
+        };
+
+        std::vector<range_t> groups(1, {0, n});
+        refine(groups, [&](index_t a, index_t b) { return key(a) < key(b); },
+                       [&](index_t a, index_t b) { return key(a) != key(b); });
+
+        // a suffix shorter than h contains the unique 0 within its h first
+        // characters, so it is a singleton: i + h < n in every group
+        for (ulint h = 8; groups.size() > 0; h *= 2)
+        {
+            refine(groups, [&](index_t a, index_t b) { return rank[a + h] < rank[b + h]; },
+                           [&](index_t a, index_t b) { return rank[a + h] != rank[b + h]; });
+        }
+    }
+
+    /*
+     * the suffix array, bit-compressed
+     */
+    sdsl::int_vector<> get()
+    {
+        sdsl::int_vector<> res(n, 0, bitsize(n));
+        for (ulint i = 0; i < n; ++i) res[i] = sa[i];
+        return res;
+    }
+
+private:
+
+    /*
+     * sorts every group [b, e) of sa by less, and replaces groups with the
+     * groups of suffixes equal by less (differ: !equal). the ranks of the suffixes
+     * become the last position of their group, after all groups are sorted
+     */
+    template<class less_t, class differ_t>
+    void refine(std::vector<range_t>& groups, less_t less, differ_t differ)
+    {
+        ulint total = 0;
+        for (auto const& g: groups) total += g.second - g.first;
+
+        // groups larger than a share are sorted by all threads, one after the other
+        ulint share = (total + threads - 1) / threads;
+
+        std::vector<std::vector<range_t> > parts(threads);
+        {
+            ulint t = 0, load = 0;
+            for (auto const& g: groups)
+            {
+                ulint size = g.second - g.first;
+                if (size > share)
+                {
+                    parallel_sort(sa.begin() + g.first, sa.begin() + g.second, less);
+                    continue;
+                }
+                if (load + size > share && t + 1 < threads)
+                {
+                    t++;
+                    load = 0;
+                }
+                parts[t].push_back(g);
+                load += size;
+            }
+        }
+
+        run([&](ulint t)
+        {
+            for (auto const& g: parts[t])
+                std::sort(sa.begin() + g.first, sa.begin() + g.second, less);
+        });
+
+        // heads of the new groups, while the ranks are still those of the round
+        std::vector<std::vector<range_t> > next(threads);
+        run([&](ulint t)
+        {
+            for (ulint j = t; j < groups.size(); j += threads)
+            {
+                range_t g = groups[j];
+                head[g.first] = 1;
+                ulint b = g.first;
+                for (ulint k = g.first + 1; k <= g.second; ++k)
+                {
+                    if (k == g.second || differ(sa[k-1], sa[k]))
+                    {
+                        if (k < g.second) head[k] = 1;
+                        if (k - b > 1) next[t].push_back({b, k});
+                        b = k;
+                    }
+                }
+            }
+        });
+
+        run([&](ulint t)
+        {
+            for (ulint j = t; j < groups.size(); j += threads)
+            {
+                range_t g = groups[j];
+                ulint e = g.second;
+                for (ulint k = g.second; k > g.first; --k)
+                {
+                    rank[sa[k-1]] = e - 1;
+                    if (head[k-1])
+                    {
+                        head[k-1] = 0;
+                        e = k - 1;
+                    }
+                }
+            }
+        });
+
+        groups.clear();
+        for (auto const& v: next) groups.insert(groups.end(), v.begin(), v.end());
+    }
+
+    /*
+     * sorts [first, last) using all threads: the chunks are sorted
+     * concurrently, then merged pairwise
+     */
+    template<class iter_t, class less_t>
+    void parallel_sort(iter_t first, iter_t last, less_t less)
+    {
+        ulint size = last - first;
+        ulint chunk = (size + threads - 1) / threads;
+
+        run([&](ulint t)
+        {
+            ulint b = std::min(size, t * chunk), e = std::min(size, (t + 1) * chunk);
+            std::sort(first + b, first + e, less);
+        });
+
+        for (; chunk < size; chunk *= 2)
+        {
+            ulint pairs = (size + 2*chunk - 1) / (2*chunk);
+            std::vector<std::thread> pool;
+            for (ulint p = 0; p < pairs; ++p)
+            {
+                ulint b = p * 2 * chunk;
+                ulint m = std::min(size, b + chunk), e = std::min(size, b + 2*chunk);
+                pool.push_back(std::thread([=]() { std::inplace_merge(first + b, first + m, first + e, less); }));
+            }
+            for (auto& th: pool) th.join();
+        }
+    }
+
+    /*
+     * runs f(t) for t = 0, ..., threads-1 concurrently
+     */
+    template<class f_t>
+    void run(f_t f)
+    {
+        std::vector<std::thread> pool;
+        for (ulint t = 1; t < threads; ++t) pool.push_back(std::thread(f, t));
+        f(0);
+        for (auto& th: pool) th.join();
+    }
+
+    ulint n;
+    ulint threads;
+
+    std::vector<index_t> sa;
+    std::vector<index_t> rank;
+
+    // beginnings of the new groups during a round
+    std::vector<uchar> head;
+
+};
+
+/*
+ * SA of text (ending with its unique smallest symbol 0) built by threads threads
+ */
+template<class text_t>
+sdsl::int_vector<> parallel_suffix_array(text_t const& text, ulint threads)
+{
+    if (text.size() < (1ULL << 32))
+        return parallel_sa<uint32_t>(text, threads).get();
+    return parallel_sa<ulint>(text, threads).get();
+}
+
+};
+
+#endif /* INCLUDED_PARALLEL_SA_HPP */
@@ -53,8 +53,8 @@ public:
         S[pos] = true;
 
         u = pos + 1;
-        std::vector<bool> ones_bv(u,false);
-        std::vector<bool> zeros_bv(u,false);
+        std::vector<ulint> ones_pos;
+        std::vector<ulint> zeros_pos;
 
         // generate run length encoding ones&zeros from S
         // S: unary encoding of j + PLCP[j]
@@ -72,7 +72,7 @@ public:
                     } else {
                         bit_1 = true;
                         cont_1++;
-                        zeros_bv[cont_0-1] = true;
+                        zeros_pos.push_back(cont_0-1);
                     }
                 } 
                 else 
@@ -81,27 +81,101 @@ public:
                     {
                         bit_1 = false;
                         cont_0++;
-                        ones_bv[cont_1-1] = true;
+                        ones_pos.push_back(cont_1-1);
                     } else {
                         cont_0++;
                     }
                 }
             }
-            if (bit_1) ones_bv[cont_1-1] = true;
-            else zeros_bv[cont_0-1] = true;
+            if (bit_1) ones_pos.push_back(cont_1-1);
+            else zeros_pos.push_back(cont_0-1);
         }
 
-        ones = sparse_bitvector_t(ones_bv);
-        zeros = sparse_bitvector_t(zeros_bv);
+        ones = sparse_bitvector_t(ones_pos, u);
+        zeros = sparse_bitvector_t(zeros_pos, u);
 
         sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_LCP, cc));
 
     }
 
+    /*
+     * constructor with PLCP values at the irreducible positions.
+     * every other position i satisfies PLCP[i] = PLCP[i-1] - 1.
+     * \param n: length of PLCP
+     * \param irreducible: <i, PLCP[i]> sorted by i, including i = 0
+     */
+    permuted_lcp(ulint n, std::vector<range_t> const& irreducible)
+    {
+        assert(irreducible.size() > 0 && irreducible[0].first == 0);
+
+        this->n = n;
+
+        // PLCP[n-1] determines the length of S
+        range_t const& tail = irreducible.back();
+        assert(tail.first < n && tail.second + tail.first >= n - 1);
+        u = 2*n + tail.second - (n - 1 - tail.first);
+
+        std::vector<ulint> ones_pos;
+        std::vector<ulint> zeros_pos;
+
+        // S: unary encoding of j + PLCP[j], i.e. 1 0^{PLCP[0]} 1 0^{PLCP[1]-PLCP[0]+1} 1 ... 1
+        // consecutive 1s correspond to reducible positions
+        ulint cont_1 = 1, cont_0 = 0;
+        ulint next = 0; // next irreducible value
+        ulint lcp_prev = 0, lcp_now = 0;
+
+        for (ulint i = 0; i < n; ++i)
+        {
+            if (next < irreducible.size() && irreducible[next].first == i)
+            {
+                lcp_now = irreducible[next++].second;
+            }
+            else
+            {
+                assert(lcp_prev > 0);
+                lcp_now = lcp_prev - 1;
+            }
+
+            ulint gap = i == 0 ? lcp_now : lcp_now + 1 - lcp_prev;
+            if (gap > 0)
+            {
+                ones_pos.push_back(cont_1-1);
+                cont_0 += gap;
+                zeros_pos.push_back(cont_0-1);
+            }
+            cont_1++;
+
+            lcp_prev = lcp_now;
+        }
+        ones_pos.push_back(cont_1-1);
+
+        assert(cont_1 + cont_0 == u);
+
+        ones = sparse_bitvector_t(ones_pos, u);
+        zeros = sparse_bitvector_t(zeros_pos, u);
+
+    }
+
+    /*
+     * constructor with the text and the SA samples at BWT run boundaries.
+     * neither ISA nor LCP is needed: PLCP is computed only at the irreducible
+     * positions SA[k] (k the beginning of a run) by comparing the suffixes
+     * SA[k] and SA[k-1] = Phi(SA[k]), whose total length is O(n log r)
+     * \param text: text without terminator (any alphabet)
+     * \param samples_first: SA[k]-1 (mod n) at the beginning k of each run
+     * \param samples_last: SA[k]-1 (mod n) at the end k of each run
+     * \param threads: number of threads comparing the suffixes
+     */
+    template<class text_t, class samples_t>
+    permuted_lcp(text_t const& text, samples_t const& samples_first, samples_t const& samples_last,
+                 ulint threads = 1)
+        : permuted_lcp(text.size() + 1, irreducible_lcp(text, samples_first, samples_last, threads))
+    {}
+
     /*
      * get PLCP[i]
      */
-    ulint operator[](size_t i)
+    ulint operator[](size_t i) const
     {
         assert(i < n);
         ulint rank_0 = ones.rank(i+1);
@@ -113,7 +187,7 @@ public:
         return 0;
     }
 
-    ulint get_value(size_t i)
+    ulint get_value(size_t i) const
     {
         return operator[](i);
     }
@@ -121,7 +195,7 @@ public:
     /*
      * serialize PLCP to the ostream
      */
-    ulint serialize(std::ostream& out)
+    ulint serialize(std::ostream& out) const
     {
         ulint w_bytes = 0;
 
@@ -152,7 +226,7 @@ public:
         zeros.load(in);
     }
 
-    ulint print_space()
+    ulint print_space() const
     {
         ulint tot_bytes = 0;
 
@@ -170,7 +244,7 @@ public:
         return tot_bytes;
     }
 
-    ulint get_space()
+    ulint get_space() const
     {
         ulint tot_bytes = 0;
 
@@ -182,11 +256,66 @@ public:
         return tot_bytes;
     }
 
-    ulint size()
+    ulint size() const
     {
         return n;
     }
 
+private:
+
+    /*
+     * PLCP values at the irreducible positions
+     * returns <text position, PLCP value> sorted by text position.
+     * the runs are split among threads: the comparisons are independent
+     */
+    template<class text_t, class samples_t>
+    static std::vector<range_t> irreducible_lcp(text_t const& text, 
+        samples_t const& samples_first, samples_t const& samples_last, ulint threads = 1)
+    {
+        ulint n = text.size() + 1;
+        ulint r = samples_first.size();
+        std::vector<range_t> res(r);
+
+        // PLCP at the beginnings of runs [b, e)
+        auto compare = [&](ulint b, ulint e)
+        {
+            for (ulint t = b; t < e; ++t)
+            {
+                // SA[k] where k is the beginning of run t
+                ulint i = (samples_first[t] + 1) % n;
+
+                // SA[0] is the terminator
+                if (t == 0) 
+                {
+                    res[t] = {i, 0};
+                    continue;
+                }
+
+                // SA[k-1] where k-1 is the end of run t-1
+                ulint j = (samples_last[t-1] + 1) % n;
+
+                ulint l = 0;
+                while (i + l < n - 1 && j + l < n - 1 && text[i+l] == text[j+l]) ++l;
+
+                res[t] = {i, l};
+            }
+        };
+
+        threads = std::max<ulint>(1, std::min(threads, r));
+        ulint chunk = (r + threads - 1) / threads;
+        {
+            std::vector<std::thread> pool;
+            for (ulint p = 1; p < threads; ++p)
+                pool.push_back(std::thread(compare, std::min(r, p * chunk), std::min(r, (p + 1) * chunk)));
+            compare(0, std::min(r, chunk));
+            for (auto& th: pool) th.join();
+        }
+
+        std::sort(res.begin(), res.end());
+
+        return res;
+    }
+
 private:
 
     // length of LCP
@@ -0,0 +1,373 @@
+/*
+ * prefix_free_parse: prefix-free parsing (PFP) of a text.
+ *
+ *  The text $T is cut at trigger strings (windows of length w whose
+ *  Karp-Rabin fingerprint is 0 modulo p) into overlapping phrases. The BWT
+ *  of T$ and the SA samples at its run boundaries are then computed from the
+ *  sorted dictionary of phrases and the suffix array of the parse, using
+ *  space proportional to the dictionary and the parse.
+ *
+ *  From the paper
+ *
+ *  Christina Boucher, Travis Gagie, Alan Kuhnle, Ben Langmead, Giovanni Manzini
+ *  and Taher Mun. Prefix-free parsing for building big BWTs.
+ *  Algorithms for Molecular Biology 14 (2019)
+ *
+ */
+
+#ifndef INCLUDED_PREFIX_FREE_PARSE_HPP
+#define INCLUDED_PREFIX_FREE_PARSE_HPP
+
+#include "definitions.hpp"
+#include "bwt_runs.hpp"
+#include "utils.hpp"
+
+namespace bri {
+
+struct pfp_config {
+    /*
+     * w: length of trigger strings
+     * p: a window is a trigger string iff its fingerprint is 0 modulo p
+     */
+    ulint w, p;
+
+    explicit pfp_config(ulint w_ = 10, ulint p_ = 100) : w(w_), p(p_) {}
+};
+
+class prefix_free_parse {
+
+public:
+
+    prefix_free_parse() {}
+
+    /*
+     * constructor. parses $T, or $T^R if reversed
+     * \param text: input text (not remapped, without terminator)
+     * \param remap: alphabet remapper. remapped characters must be > 1
+     * \param reversed: parse the reversed text
+     * \param cfg: window size and modulus of trigger strings
+     */
+    template<class text_t>
+    prefix_free_parse(text_t const& text, std::vector<uchar> const& remap, bool reversed, pfp_config const& cfg)
+    {
+        n = text.size() + 1;
+
+        // windows must not wrap around $T
+        w = std::min(cfg.w, n - 1);
+        assert(w > 0);
+
+        // R[x]: x-th character of $T (or $T^R), $ is 0
+        auto R = [&](ulint x) -> uchar
+        {
+            if (x == 0) return 0;
+            return remap[text[reversed ? n - 1 - x : x - 1]];
+        };
+
+        // base^(w-1) modulo prime
+        ulint pw = 1;
+        for (ulint i = 1; i < w; ++i) pw = (pw * BASE) % PRIME;
+
+        std::unordered_map<std::string, ulint> ids;
+        std::vector<std::string> phrases;
+        std::vector<ulint> parse_ids;
+        std::vector<ulint> starts_vec;
+
+        auto add_phrase = [&](std::string const& phrase, ulint start)
+        {
+            auto it = ids.find(phrase);
+            if (it == ids.end())
+            {
+                it = ids.insert({phrase, phrases.size()}).first;
+                phrases.push_back(phrase);
+            }
+            parse_ids.push_back(it->second);
+            starts_vec.push_back(start);
+        };
+
+        // the window starting with $ is the only trigger string containing $
+        std::string phrase;
+        ulint q = 0; // start of the current phrase
+        ulint h = 0; // fingerprint of the last w characters
+
+        for (ulint e = 0; e < n; ++e)
+        {
+            uchar c = R(e);
+            phrase.push_back(c);
+
+            if (e >= w)
+            {
+                uchar old = phrase[phrase.size() - 1 - w];
+                h = (h + PRIME - (old * pw) % PRIME) % PRIME;
+            }
+            h = (h * BASE + c) % PRIME;
+
+            if (e + 1 >= w)
+            {
+                ulint s = e + 1 - w;
+                if (s > 0 && h % cfg.p == 0)
+                {
+                    // phrase $T[q..s+w-1] ends with the trigger string at s
+                    add_phrase(phrase, q);
+                    q = s;
+                    phrase.erase(0, phrase.size() - w);
+                }
+            }
+        }
+
+        // the last phrase ends with the first trigger string
+        for (ulint x = 0; x < w; ++x) phrase.push_back(R(x));
+        add_phrase(phrase, q);
+
+        ids.clear();
+
+        // sort dictionary. the phrase starting with $ is the smallest
+        std::vector<ulint> order(phrases.size());
+        for (ulint i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(),
+            [&](ulint a, ulint b) { return phrases[a] < phrases[b]; });
+
+        std::vector<ulint> rank(phrases.size());
+        dict.resize(phrases.size());
+        for (ulint i = 0; i < order.size(); ++i)
+        {
+            rank[order[i]] = i;
+            dict[i].swap(phrases[order[i]]);
+        }
+        phrases.clear();
+
+        k = parse_ids.size();
+        assert(rank[parse_ids[0]] == 0);
+
+        parse = sdsl::int_vector<>(k, 0, bitsize(dict.size()));
+        for (ulint j = 0; j < k; ++j) parse[j] = rank[parse_ids[j]];
+        std::vector<ulint>().swap(parse_ids);
+
+        starts = sdsl::int_vector<>(k, 0, bitsize(n));
+        for (ulint j = 0; j < k; ++j) starts[j] = starts_vec[j];
+        std::vector<ulint>().swap(starts_vec);
+
+    }
+
+    /*
+     * computes the BWT of T$ (or T^R$) and appends its runs and SA samples to out
+     * \param cc: cache configuration used to sort the parse
+     * \param in_memory: sort the parse in RAM, without cache files
+     */
+    void bwt(bwt_runs& out, sdsl::cache_config cc = sdsl::cache_config(), bool in_memory = false)
+    {
+        // suffix array of the parse rotated by one phrase, so that the
+        // smallest phrase $... becomes the unique terminator 0.
+        // position s of the rotated parse is the phrase rotation starting at s+1
+        sdsl::int_vector<> sa_p;
+        {
+            sdsl::int_vector<> parse_rot(k, 0, parse.width());
+            for (ulint s = 0; s < k; ++s) parse_rot[s] = parse[(s + 1) % k];
+
+            if (in_memory) sa_p = suffix_array(parse_rot);
+            else
+            {
+                sdsl::store_to_cache(parse_rot, sdsl::conf::KEY_TEXT_INT, cc);
+                sdsl::construct_sa<0>(cc);
+                sdsl::load_from_file(sa_p, sdsl::cache_file_name(sdsl::conf::KEY_SA, cc));
+
+                sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_TEXT_INT, cc));
+                sdsl::remove(sdsl::cache_file_name(sdsl::conf::KEY_SA, cc));
+            }
+        }
+        assert(sa_p.size() == k);
+
+        // inverted lists: ranks in sa_p of the occurrences of each phrase,
+        // i.e. the occurrences sorted by the rotation following them
+        std::vector<ulint> occ_start(dict.size() + 1, 0);
+        for (ulint j = 0; j < k; ++j) occ_start[parse[j] + 1]++;
+        for (ulint d = 1; d <= dict.size(); ++d) occ_start[d] += occ_start[d-1];
+
+        sdsl::int_vector<> ilist(k, 0, bitsize(k));
+        {
+            std::vector<ulint> filled(occ_start.begin(), occ_start.end() - 1);
+            for (ulint i = 0; i < k; ++i) ilist[filled[parse[sa_p[i]]]++] = i;
+        }
+
+        // suffixes of phrases longer than w, i.e. <phrase, offset>
+        std::vector<range_t> suffixes;
+        for (ulint d = 0; d < dict.size(); ++d)
+            for (ulint off = 0; off + w < dict[d].size(); ++off)
+                suffixes.push_back({d, off});
+
+        auto compare = [&](range_t const& a, range_t const& b) -> int
+        {
+            return dict[a.first].compare(a.second, std::string::npos,
+                                         dict[b.first], b.second, std::string::npos);
+        };
+
+        std::sort(suffixes.begin(), suffixes.end(),
+            [&](range_t const& a, range_t const& b)
+            {
+                int cmp = compare(a, b);
+                return cmp < 0 || (cmp == 0 && a.first < b.first);
+            });
+
+        // $T position of the suffix starting at offset off of the phrase preceding rank i
+        auto position = [&](ulint i, ulint off) -> ulint
+        {
+            return starts[sa_p[i]] + off;
+        };
+
+        // character preceding the phrase occurrence preceding rank i
+        auto preceding = [&](ulint i) -> uchar
+        {
+            ulint e = parse[(sa_p[i] + k - 1) % k];
+            return dict[e][dict[e].size() - w - 1];
+        };
+
+        // $T position x to SA position of T$
+        auto sa_of = [&](ulint x) -> ulint
+        {
+            return (x + n - 1) % n;
+        };
+
+        // $ is output as the BWT terminator
+        auto emit = [&](uchar c, ulint len, ulint x_first, ulint x_last)
+        {
+            out.push_back(c == 0 ? (uchar)TERMINATOR : c, len, sa_of(x_first), sa_of(x_last));
+        };
+
+        std::vector<std::tuple<ulint, uchar, ulint> > occs;
+
+        // equal suffixes are ordered by the rotation following their phrases
+        for (ulint gs = 0, ge; gs < suffixes.size(); gs = ge)
+        {
+            ge = gs + 1;
+            while (ge < suffixes.size() && compare(suffixes[gs], suffixes[ge]) == 0) ge++;
+
+            // all the suffixes are preceded by the same character
+            bool same_char = true;
+            for (ulint t = gs; t < ge && same_char; ++t)
+            {
+                same_char = suffixes[t].second > 0 &&
+                    dict[suffixes[t].first][suffixes[t].second-1] ==
+                    dict[suffixes[gs].first][suffixes[gs].second-1];
+            }
+
+            if (same_char)
+            {
+                // only the first & last occurrences are sampled
+                ulint len = 0;
+                range_t first = {k, 0}, last = {0, 0};
+
+                for (ulint t = gs; t < ge; ++t)
+                {
+                    ulint d = suffixes[t].first;
+                    ulint off = suffixes[t].second;
+
+                    len += occ_start[d+1] - occ_start[d];
+                    if (ilist[occ_start[d]] < first.first) first = {ilist[occ_start[d]], off};
+                    if (ilist[occ_start[d+1]-1] >= last.first) last = {ilist[occ_start[d+1]-1], off};
+                }
+
+                uchar c = dict[suffixes[gs].first][suffixes[gs].second-1];
+                emit(c, len, position(first.first, first.second), position(last.first, last.second));
+            }
+            else
+            {
+                // merge the occurrences of all the phrases
+                occs.clear();
+                for (ulint t = gs; t < ge; ++t)
+                {
+                    ulint d = suffixes[t].first;
+                    ulint off = suffixes[t].second;
+
+                    for (ulint o = occ_start[d]; o < occ_start[d+1]; ++o)
+                    {
+                        ulint i = ilist[o];
+                        uchar c = off > 0 ? (uchar)dict[d][off-1] : preceding(i);
+                        occs.push_back(std::make_tuple(i, c, position(i, off)));
+                    }
+                }
+                std::sort(occs.begin(), occs.end());
+
+                for (auto const& o : occs)
+                    emit(std::get<1>(o), 1, std::get<2>(o), std::get<2>(o));
+            }
+        }
+
+        assert(out.size == n);
+    }
+
+    // number of distinct phrases
+    ulint dictionary_size() { return dict.size(); }
+
+    // number of phrases in the parse
+    ulint parse_size() { return k; }
+
+private:
+
+    static const uchar TERMINATOR = 1;
+
+    // Karp-Rabin fingerprint
+    static const ulint PRIME = 1999999973;
+    static const ulint BASE = 256;
+
+    /*
+     * SA of an integer text ending with its unique smallest symbol,
+     * by prefix doubling in RAM
+     */
+    static sdsl::int_vector<> suffix_array(sdsl::int_vector<> const& text)
+    {
+        ulint len = text.size();
+
+        std::vector<ulint> sa(len), rank(len), next_rank(len);
+        for (ulint i = 0; i < len; ++i)
+        {
+            sa[i] = i;
+            rank[i] = text[i];
+        }
+
+        for (ulint h = 1; ; h <<= 1)
+        {
+            // suffixes are sorted by their prefixes of length 2h
+            auto less = [&](ulint a, ulint b) -> bool
+            {
+                if (rank[a] != rank[b]) return rank[a] < rank[b];
+                ulint ra = a + h < len ? rank[a + h] + 1 : 0;
+                ulint rb = b + h < len ? rank[b + h] + 1 : 0;
+                return ra < rb;
+            };
+            std::sort(sa.begin(), sa.end(), less);
+
+            next_rank[sa[0]] = 0;
+            for (ulint i = 1; i < len; ++i)
+                next_rank[sa[i]] = next_rank[sa[i-1]] + (less(sa[i-1], sa[i]) ? 1 : 0);
+            rank.swap(next_rank);
+
+            if (rank[sa[len-1]] == len - 1) break;
+        }
+
+        sdsl::int_vector<> res(len, 0, bitsize(len));
+        for (ulint i = 0; i < len; ++i) res[i] = sa[i];
+        return res;
+    }
+
+    // length of $T
+    ulint n = 0;
+
+    // window size
+    ulint w = 0;
+
+    // number of phrases in the parse
+    ulint k = 0;
+
+    // sorted dictionary
+    std::vector<std::string> dict;
+
+    // ranks of the phrases in the parse
+    sdsl::int_vector<> parse;
+
+    // starting positions of the phrases in $T
+    sdsl::int_vector<> starts;
+
+};
+
+};
+
+#endif /* INCLUDED_PREFIX_FREE_PARSE_HPP */
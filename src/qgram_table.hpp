@@ -0,0 +1,235 @@
+/*
+ * qgram_table: the state of the backward search of every q-gram of the text
+ *
+ *  A pattern of length at least q is searched from the entry of its last q
+ *  characters instead of q LF steps from the full range. The q-grams are
+ *  numbered in base sigma (sigma: number of distinct characters of the text)
+ *  by the ranks of their characters, P[q-1] being the most significant digit.
+ *  A sparse bitvector over the sigma^q numbers marks the q-grams occurring in
+ *  the text, so an absent q-gram is rejected by one access, and the rank of a
+ *  present one indexes its SA range, the start of its SA^R range and SA at the
+ *  end of its SA range.
+ */
+
+#ifndef INCLUDED_QGRAM_TABLE_HPP
+#define INCLUDED_QGRAM_TABLE_HPP
+
+#include "definitions.hpp"
+#include "sparse_sd_vector.hpp"
+#include "utils.hpp"
+
+namespace bri {
+
+template<class sparse_bitvector_t = sparse_sd_vector>
+class qgram_table {
+
+public:
+
+    /*
+     * empty table: no q-gram is stored (q = 0)
+     */
+    qgram_table() {}
+
+    /*
+     * enumerates the q-grams by extending the empty pattern to the left
+     * \param q: length of the q-grams
+     * \param alphabet: the characters of the text (original, not remapped)
+     * \param init: sample of the empty pattern
+     * \param extend: extend(c, sample of P) is the sample of cP, where j - d
+     *                is SA at the end of the SA range
+     */
+    template<class sample_t, class extend_t>
+    qgram_table(ulint q, std::vector<uchar> const& alphabet, sample_t const& init, extend_t extend) :
+        q(q), alphabet(alphabet)
+    {
+        build_ranks();
+
+        ulint sigma = alphabet.size();
+
+        ulint u = 1;
+        for (ulint i = 0; i < q; ++i)
+        {
+            if (sigma > 1 && u > MAX_CODES / sigma)
+            {
+                std::cout << "Error: q-gram table of " << sigma << "^" << q << " entries is too large" << std::endl;
+                exit(1);
+            }
+            u *= sigma;
+        }
+
+        std::vector<ulint> codes;
+        std::vector<range_t> ranges;
+        std::vector<ulint> startsR, sas;
+        if (sigma > 0) visit(init, 0, 0, u / sigma, extend, codes, ranges, startsR, sas);
+
+        present = sparse_bitvector_t(codes, u);
+
+        ulint max_value = 0;
+        for (ulint i = 0; i < codes.size(); ++i)
+            max_value = std::max(max_value, std::max(std::max(ranges[i].second, startsR[i]), sas[i]));
+        uchar width = bitsize(max_value);
+
+        first = sdsl::int_vector<>(codes.size(), 0, width);
+        last = sdsl::int_vector<>(codes.size(), 0, width);
+        firstR = sdsl::int_vector<>(codes.size(), 0, width);
+        sa = sdsl::int_vector<>(codes.size(), 0, width);
+        for (ulint i = 0; i < codes.size(); ++i)
+        {
+            first[i] = ranges[i].first;
+            last[i] = ranges[i].second;
+            firstR[i] = startsR[i];
+            sa[i] = sas[i];
+        }
+    }
+
+    /*
+     * returns: length of the q-grams, 0 if the table is empty
+     */
+    ulint qgram_length() const { return q; }
+
+    /*
+     * returns: number of distinct q-grams of the text
+     */
+    ulint number_of_qgrams() const { return first.size(); }
+
+    /*
+     * sample of pattern[left...left+q-1] with j = SA at the end of its SA
+     * range and d = 0. invalid if it does not occur in the text
+     */
+    template<class sample_t>
+    sample_t find(std::string const& pattern, ulint left) const
+    {
+        assert(q > 0 && left + q <= pattern.size());
+
+        sample_t invalid({1,0}, {1,0}, 0, 0, 0);
+
+        ulint code = 0;
+        for (ulint i = left + q; i-- > left; )
+        {
+            ulint k = ranks[(uchar)pattern[i]];
+            if (k == alphabet.size()) return invalid;
+            code = code * alphabet.size() + k;
+        }
+        if (!present[code]) return invalid;
+
+        ulint x = present.rank(code);
+        return sample_t({first[x], last[x]},
+                        {firstR[x], firstR[x] + last[x] - first[x]},
+                        sa[x],
+                        0,
+                        q);
+    }
+
+    /*
+     * argument: ostream
+     * returns: number of bytes written to ostream
+     */
+    ulint serialize(std::ostream& out) const
+    {
+        ulint w_bytes = 0;
+        ulint sigma = alphabet.size();
+
+        out.write((char*)&q, sizeof(q));
+        out.write((char*)&sigma, sizeof(sigma));
+        out.write((char*)alphabet.data(), sigma*sizeof(uchar));
+        w_bytes += sizeof(q) + sizeof(sigma) + sigma*sizeof(uchar);
+
+        w_bytes += present.serialize(out);
+
+        w_bytes += first.serialize(out);
+        w_bytes += last.serialize(out);
+        w_bytes += firstR.serialize(out);
+        w_bytes += sa.serialize(out);
+
+        return w_bytes;
+    }
+
+    /*
+     * load table from istream
+     * argument: istream
+     */
+    void load(std::istream& in)
+    {
+        ulint sigma = 0;
+
+        in.read((char*)&q, sizeof(q));
+        in.read((char*)&sigma, sizeof(sigma));
+        alphabet = std::vector<uchar>(sigma);
+        in.read((char*)alphabet.data(), sigma*sizeof(uchar));
+        build_ranks();
+
+        present.load(in);
+
+        first.load(in);
+        last.load(in);
+        firstR.load(in);
+        sa.load(in);
+    }
+
+    /*
+     * returns: space in bytes
+     */
+    ulint get_space() const
+    {
+        std::ofstream out("/dev/null");
+        return serialize(out);
+    }
+
+private:
+
+    // the q-grams are numbered below 2^62
+    static const ulint MAX_CODES = 1ULL << 62;
+
+    /*
+     * P: the pattern of sample, |P| = depth. each character c extending P
+     * adds its rank times weight to code
+     */
+    template<class sample_t, class extend_t>
+    void visit(sample_t const& sample, ulint depth, ulint code, ulint weight, extend_t& extend,
+               std::vector<ulint>& codes, std::vector<range_t>& ranges,
+               std::vector<ulint>& startsR, std::vector<ulint>& sas)
+    {
+        if (depth == q)
+        {
+            codes.push_back(code);
+            ranges.push_back(sample.range);
+            startsR.push_back(sample.rangeR.first);
+            sas.push_back(sample.j - sample.d);
+            return;
+        }
+
+        // characters in rank order, so that the codes are increasing
+        for (ulint k = 0; k < alphabet.size(); ++k)
+        {
+            sample_t next = extend(alphabet[k], sample);
+            if (next.is_invalid()) continue;
+            visit(next, depth + 1, code + k * weight, weight / alphabet.size(), extend, codes, ranges, startsR, sas);
+        }
+    }
+
+    void build_ranks()
+    {
+        ranks = std::vector<ulint>(256, alphabet.size());
+        for (ulint k = 0; k < alphabet.size(); ++k) ranks[alphabet[k]] = k;
+    }
+
+    ulint q = 0;
+
+    // characters of the text and their ranks (alphabet.size() if absent)
+    std::vector<uchar> alphabet;
+    std::vector<ulint> ranks;
+
+    // numbers of the q-grams occurring in the text
+    sparse_bitvector_t present;
+
+    // SA range, start of SA^R range and SA at the end of SA range of each of them
+    sdsl::int_vector<> first;
+    sdsl::int_vector<> last;
+    sdsl::int_vector<> firstR;
+    sdsl::int_vector<> sa;
+
+};
+
+};
+
+#endif /* INCLUDED_QGRAM_TABLE_HPP */
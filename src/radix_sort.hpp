@@ -0,0 +1,129 @@
+/*
+ * radix_sort: parallel LSD radix sort of integer keys.
+ *
+ *  Each pass sorts by 11 bits: the threads count the digits of their chunks,
+ *  then scatter their chunks to disjoint ranges of a buffer, so the sort is
+ *  stable and its result does not depend on the number of threads.
+ */
+
+#ifndef INCLUDED_RADIX_SORT_HPP
+#define INCLUDED_RADIX_SORT_HPP
+
+#include <functional>
+
+#include "definitions.hpp"
+#include "utils.hpp"
+
+namespace bri {
+
+/*
+ * sorts v by key(v[i]) < 2^bits
+ * \param key: extracts the integer key of an element
+ * \param threads: number of threads
+ */
+template<class T, class key_t>
+void radix_sort(std::vector<T>& v, ulint bits, key_t key, ulint threads = 1)
+{
+    const ulint digit_bits = 11;
+    const ulint radix = 1ULL << digit_bits;
+
+    ulint n = v.size();
+
+    // small chunks are not worth a thread
+    threads = std::max<ulint>(1, std::min(threads, n >> 16));
+    ulint chunk = (n + threads - 1) / threads;
+
+    // runs f(t, b, e) on the chunk [b, e) of each thread t
+    auto run = [&](std::function<void(ulint, ulint, ulint)> f)
+    {
+        std::vector<std::thread> pool;
+        for (ulint t = 1; t < threads; ++t)
+            pool.push_back(std::thread(f, t, std::min(n, t * chunk), std::min(n, (t + 1) * chunk)));
+        f(0, 0, std::min(n, chunk));
+        for (auto& th: pool) th.join();
+    };
+
+    std::vector<T> buffer(n);
+    std::vector<std::vector<ulint> > count(threads, std::vector<ulint>(radix));
+
+    for (ulint shift = 0; shift < bits; shift += digit_bits)
+    {
+        run([&](ulint t, ulint b, ulint e)
+        {
+            std::fill(count[t].begin(), count[t].end(), 0);
+            for (ulint i = b; i < e; ++i) count[t][(key(v[i]) >> shift) & (radix - 1)]++;
+        });
+
+        // the destination of digit d of thread t follows digits < d and
+        // digit d of threads < t
+        ulint sum = 0;
+        for (ulint d = 0; d < radix; ++d)
+        {
+            for (ulint t = 0; t < threads; ++t)
+            {
+                ulint c = count[t][d];
+                count[t][d] = sum;
+                sum += c;
+            }
+        }
+
+        run([&](ulint t, ulint b, ulint e)
+        {
+            for (ulint i = b; i < e; ++i) buffer[count[t][(key(v[i]) >> shift) & (radix - 1)]++] = v[i];
+        });
+
+        v.swap(buffer);
+    }
+}
+
+/*
+ * radix sorts the samples <text position < n, run number> by text position and
+ * writes the predecessor structure pred of the positions and the run numbers
+ * to_run (already sized, of the width of a run number) from the sorted stream.
+ * samples is released
+ */
+template<class sparse_bitvector_t>
+void build_predecessor(std::vector<range_t>& samples, ulint n, sparse_bitvector_t& pred,
+                       sdsl::int_vector<>& to_run, ulint threads = 1)
+{
+    ulint log_n = bitsize(n);
+    ulint log_r = to_run.width();
+
+    std::vector<ulint> ones;
+    if (log_n + log_r <= 64)
+    {
+        // <text position, run number> packed in one key
+        std::vector<ulint> keys(samples.size());
+        for (ulint i = 0; i < samples.size(); ++i)
+            keys[i] = (samples[i].first << log_r) | samples[i].second;
+        std::vector<range_t>().swap(samples);
+
+        radix_sort(keys, log_n + log_r, [](ulint k) { return k; }, threads);
+
+        ulint mask = (1ULL << log_r) - 1;
+        for (ulint i = 0; i < keys.size(); ++i)
+        {
+            to_run[i] = keys[i] & mask;
+            keys[i] >>= log_r;
+        }
+        ones.swap(keys);
+    }
+    else
+    {
+        radix_sort(samples, log_n, [](range_t const& s) { return s.first; }, threads);
+
+        ones.resize(samples.size());
+        for (ulint i = 0; i < samples.size(); ++i)
+        {
+            ones[i] = samples[i].first;
+            to_run[i] = samples[i].second;
+        }
+        std::vector<range_t>().swap(samples);
+    }
+
+    pred = sparse_bitvector_t(ones, n);
+}
+
+};
+
+#endif /* INCLUDED_RADIX_SORT_HPP */
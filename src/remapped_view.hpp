@@ -0,0 +1,56 @@
+/*
+ * remapped_view: the remapped text (or the reversed text) followed by the zero
+ * symbol, computed on access from the input through the alphabet remapper,
+ * so neither the remapped text nor the reversed text is copied
+ */
+
+#ifndef INCLUDED_REMAPPED_VIEW_HPP
+#define INCLUDED_REMAPPED_VIEW_HPP
+
+#include "definitions.hpp"
+
+namespace bri {
+
+template<class text_t>
+class remapped_view {
+
+public:
+
+    /*
+     * \param input: text (std::string, mapped_text, ...), which must outlive the view
+     * \param remap: alphabet remapper, which must outlive the view
+     * \param reversed: view of the reversed text
+     */
+    remapped_view(text_t const& input, std::vector<uchar> const& remap, bool reversed = false) :
+        input(input), remap(remap), n(input.size()), reversed(reversed) {}
+
+    uchar operator[](ulint i) const
+    {
+        assert(i <= n);
+        return i < n ? remap[(uchar)input[reversed ? n-1-i : i]] : 0;
+    }
+
+    // length including the zero symbol
+    ulint size() const { return n + 1; }
+
+private:
+
+    text_t const& input;
+    std::vector<uchar> const& remap;
+    ulint n;
+    bool reversed;
+
+};
+
+/*
+ * view of input (its reverse if reversed) remapped by remap
+ */
+template<class text_t>
+remapped_view<text_t> remap_view(text_t const& input, std::vector<uchar> const& remap, bool reversed = false)
+{
+    return remapped_view<text_t>(input, remap, reversed);
+}
+
+};
+
+#endif /* INCLUDED_REMAPPED_VIEW_HPP */
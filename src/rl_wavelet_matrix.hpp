@@ -0,0 +1,222 @@
+/*
+ * rl_wavelet_matrix: a wavelet matrix on the run heads of a run-length encoded
+ * string. Besides its bitvector, each level stores the cumulative lengths of
+ * the runs in the order of the next level, so the number of characters smaller
+ * than c before a run is computed in O(log sigma) ranks and selects.
+ *
+ *  space: log(sigma) * (R + R * (2 + log(n/R))) (1+o(1)) bits, n being the
+ *  string length and R the number of runs.
+ */
+
+#ifndef INCLUDED_RL_WAVELET_MATRIX_HPP
+#define INCLUDED_RL_WAVELET_MATRIX_HPP
+
+#include "definitions.hpp"
+#include "sparse_sd_vector.hpp"
+#include "utils.hpp"
+
+namespace bri {
+
+template<class sparse_bitvector_t = sparse_sd_vector>
+class rl_wavelet_matrix {
+
+public:
+
+    rl_wavelet_matrix() {}
+
+    /*
+     * constructor
+     * \param heads run heads
+     * \param lengths run lengths
+     */
+    rl_wavelet_matrix(std::string const& heads, std::vector<ulint> const& lengths)
+    {
+        assert(heads.size() == lengths.size());
+
+        r = heads.size();
+
+        uchar max_head = 0;
+        for (uchar c: heads) max_head = std::max(max_head, c);
+        levels = bitsize(max_head);
+
+        ulint n = 0;
+        for (auto l: lengths) n += l;
+
+        bits = std::vector<sdsl::bit_vector>(levels);
+        zeros = std::vector<ulint>(levels);
+        cumulative = std::vector<sparse_bitvector_t>(levels);
+
+        // runs in the order of the current level
+        std::vector<ulint> order(r);
+        for (ulint k = 0; k < r; ++k) order[k] = k;
+
+        for (ulint l = 0; l < levels; ++l)
+        {
+            ulint shift = levels - 1 - l;
+
+            bits[l] = sdsl::bit_vector(r, 0);
+            std::vector<ulint> next_zeros, next_ones;
+            for (ulint k = 0; k < r; ++k)
+            {
+                bool b = ((uchar)heads[order[k]] >> shift) & 1;
+                bits[l][k] = b;
+                if (b) next_ones.push_back(order[k]);
+                else next_zeros.push_back(order[k]);
+            }
+            zeros[l] = next_zeros.size();
+
+            order = next_zeros;
+            order.insert(order.end(), next_ones.begin(), next_ones.end());
+
+            std::vector<ulint> ones(r);
+            for (ulint k = 0, sum = 0; k < r; ++k)
+            {
+                sum += lengths[order[k]];
+                ones[k] = sum - 1;
+            }
+            cumulative[l] = sparse_bitvector_t(ones, n);
+        }
+
+        bind_ranks();
+    }
+
+    /*
+     * copy constructor. rank supports are bound to the copy, not to other
+     */
+    rl_wavelet_matrix(rl_wavelet_matrix const& other)
+    {
+        operator=(other);
+    }
+
+    rl_wavelet_matrix& operator=(rl_wavelet_matrix const& other)
+    {
+        r = other.r;
+        levels = other.levels;
+        bits = other.bits;
+        zeros = other.zeros;
+        cumulative = other.cumulative;
+
+        bind_ranks();
+
+        return *this;
+    }
+
+    /*
+     * true iff every head is smaller than c because c has more bits than any head
+     */
+    bool all_smaller(uchar c) const
+    {
+        return ((ulint)c >> levels) != 0;
+    }
+
+    /*
+     * total length of the runs before the j-th run whose head is smaller than c
+     * (c must not be all_smaller)
+     */
+    ulint less_than(ulint j, uchar c) const
+    {
+        assert(j <= r);
+        assert(!all_smaller(c));
+
+        // runs before the j-th one among those with the head bits of c so far
+        ulint b = 0, e = j;
+        ulint acc = 0;
+
+        for (ulint l = 0; l < levels; ++l)
+        {
+            ulint b1 = ranks[l](b), e1 = ranks[l](e);
+            ulint b0 = b - b1, e0 = e - e1;
+
+            if (((ulint)c >> (levels - 1 - l)) & 1)
+            {
+                // the runs with bit 0 are smaller than c
+                acc += length_before(l, e0) - length_before(l, b0);
+                b = zeros[l] + b1;
+                e = zeros[l] + e1;
+            }
+            else
+            {
+                b = b0;
+                e = e0;
+            }
+        }
+
+        return acc;
+    }
+
+    ulint serialize(std::ostream& out) const
+    {
+        ulint w_bytes = 0;
+
+        out.write((char*)&r, sizeof(r));
+        out.write((char*)&levels, sizeof(levels));
+        w_bytes += sizeof(r) + sizeof(levels);
+
+        for (ulint l = 0; l < levels; ++l)
+        {
+            w_bytes += bits[l].serialize(out);
+            out.write((char*)&zeros[l], sizeof(zeros[l]));
+            w_bytes += sizeof(zeros[l]);
+            w_bytes += cumulative[l].serialize(out);
+        }
+
+        return w_bytes;
+    }
+
+    void load(std::istream& in)
+    {
+        in.read((char*)&r, sizeof(r));
+        in.read((char*)&levels, sizeof(levels));
+
+        bits = std::vector<sdsl::bit_vector>(levels);
+        zeros = std::vector<ulint>(levels);
+        cumulative = std::vector<sparse_bitvector_t>(levels);
+
+        for (ulint l = 0; l < levels; ++l)
+        {
+            bits[l].load(in);
+            in.read((char*)&zeros[l], sizeof(zeros[l]));
+            cumulative[l].load(in);
+        }
+
+        bind_ranks();
+    }
+
+private:
+
+    /*
+     * total length of the k first runs in the order of level l+1
+     */
+    ulint length_before(ulint l, ulint k) const
+    {
+        return k == 0 ? 0 : cumulative[l].select(k-1) + 1;
+    }
+
+    void bind_ranks()
+    {
+        ranks = std::vector<sdsl::rank_support_v5<> >(levels);
+        for (ulint l = 0; l < levels; ++l)
+            ranks[l] = sdsl::rank_support_v5<>(&bits[l]);
+    }
+
+    // number of runs
+    ulint r = 0;
+
+    // bits per head
+    ulint levels = 0;
+
+    // bits of the heads, most significant first, in the order of each level
+    std::vector<sdsl::bit_vector> bits;
+    std::vector<sdsl::rank_support_v5<> > ranks;
+
+    // number of 0s of each level
+    std::vector<ulint> zeros;
+
+    // cumulative run lengths in the order of the level following each level
+    std::vector<sparse_bitvector_t> cumulative;
+
+};
+
+};
+
+#endif /* INCLUDED_RL_WAVELET_MATRIX_HPP */
@@ -11,6 +11,23 @@
  *
  *  Time for all operations: O( B*(log(n/R)+H0) )
  *
+ *  With the template option rank_directory, a directory stores for every block its
+ *  starting position, the lengths and heads of its B runs and the number of each
+ *  character before it, in one entry padded to whole cache lines and aligned on a
+ *  cache line. rank, rank_pair, last_run_of and rank_less_than then take the
+ *  block lookup and a scan of one entry, without the run heads and the per-letter
+ *  bitvectors. space: (R/B) * 512 * ceil((1 + B + B/8 + sigma) / 8) more bits.
+ *
+ *  rank_less_than sums the ranks of the smaller characters at the run of i:
+ *  O( B*(log(n/R)+H0) + sigma*(log(n/R)+H0) ) time. With the template option
+ *  less_than_matrix, it uses a wavelet matrix on the run heads with the cumulative
+ *  run lengths at each level instead: log(sigma) * R * (3 + log(n/R)) more bits,
+ *  O( B*(log(n/R)+H0) + log(sigma)*log(n/R) ) time, worth it for large alphabets.
+ *
+ *  rle_string_dna stores the run heads in a dna_string (at most 8 symbols, e.g.
+ *  terminator and ACGTN) instead of a Huffman-shaped wavelet tree: rank and access
+ *  on the heads become one popcount on 3 bit-planes.
+ *
  *  From the paper
  *
  *  Djamal Belazzougui, Fabio Cunial, Travis Gagie, Nicola Prezza and Mathieu Raffinot.
@@ -23,13 +40,17 @@
 
 #include "definitions.hpp"
 #include "huffman_string.hpp"
+#include "dna_string.hpp"
 #include "sparse_sd_vector.hpp"
+#include "rl_wavelet_matrix.hpp"
 
 namespace bri {
 
 template<
     class sparse_bitvector_t = sparse_sd_vector,
-    class string_t = huffman_string
+    class string_t = huffman_string,
+    bool rank_directory = false,
+    bool less_than_matrix = false
 >
 class rle_string {
 
@@ -45,74 +66,46 @@ public:
     {
         assert(!contains0(input));
 
-        this->B = B;
-        n = input.size();
-        r = 0;
-
-        auto runs_per_letter_bv = std::vector<std::vector<bool> >(256);
-
-        std::vector<bool> runs_bv;
-        std::string run_heads_s;
+        std::string heads;
+        std::vector<ulint> lengths;
 
-        uchar last_c = input[0];
-
-        for (ulint i = 1; i < input.size(); ++i)
+        for (ulint i = 0; i < input.size(); ++i)
         {
-            if (uchar(input[i]) != last_c)
+            if (i == 0 || input[i] != input[i-1])
             {
-                run_heads_s.push_back(last_c);
-                runs_per_letter_bv[last_c].push_back(true);
-
-                last_c = input[i];
-
-                // push back a bit set only at the end of a block
-                runs_bv.push_back(r%B == B-1);
-
-                r++;
-
+                heads.push_back(input[i]);
+                lengths.push_back(1);
             } else {
-
-                runs_bv.push_back(false);
-                runs_per_letter_bv[last_c].push_back(false);
-
+                lengths.back()++;
             }
         }
 
-        run_heads_s.push_back(last_c);
-        runs_per_letter_bv[last_c].push_back(true);
-        runs_bv.push_back(false);
-        r++;
-
-        assert(run_heads_s.size()==r);
-        assert(r==count_runs(input));
-        assert(runs_bv.size()==input.size());
-
-        ulint t = 0;
-        for (ulint i = 0; i < 256; ++i) t += runs_per_letter_bv[i].size();
-        assert(t == input.size());
-
-        runs = sparse_bitvector_t(runs_bv);
+        assert(heads.size()==count_runs(input));
 
-        runs_per_letter = std::vector<sparse_bitvector_t>(256);
-        for (ulint i = 0; i < 256; ++i)
-            runs_per_letter[i] = sparse_bitvector_t(runs_per_letter_bv[i]);
-
-        run_heads = string_t(run_heads_s);
-
-        assert(run_heads.size() == r);
+        build(heads, lengths, B);
+    }
 
+    /*
+     * constructor from the runs of the string
+     * \param heads run heads
+     * \param lengths run lengths
+     * \param B block size
+     */
+    rle_string(std::string const& heads, std::vector<ulint> const& lengths, ulint B = 2)
+    {
+        build(heads, lengths, B);
     }
 
-    uchar operator[](size_t i)
+    uchar operator[](size_t i) const
     {
         assert(i < n);
-        return run_heads[run_of(i).first];
+        return head_of_run(run_of(i).first);
     }
 
     /*
      * index of i-th character c 
      */
-    size_t select(ulint i, uchar c)
+    size_t select(ulint i, uchar c) const
     {
         assert(i<runs_per_letter[c].size());
 
@@ -141,7 +134,7 @@ public:
     /*
      * number of c before position i
      */
-    ulint rank(size_t i, uchar c)
+    ulint rank(size_t i, uchar c) const
     {
 
         assert(i <= n);
@@ -152,12 +145,14 @@ public:
         // number of all c
         if (i == n) return runs_per_letter[c].size();
 
+        if (rank_directory) return rank_by_directory(i, c);
+
         ulint last_block = runs.rank(i);
         ulint current_run = last_block * B;
 
         // current position in the string
         ulint pos = 0;
-        if (last_block > 0) pos = runs.select(last_block-1) + 1;
+        if (last_block > 0) pos = block_start(last_block);
 
         assert(pos <= i);
 
@@ -188,10 +183,137 @@ public:
 
     }
 
+    /*
+     * <number of c before position i, number of c before position j>, i <= j.
+     * the block lookup, the scan of the runs and the rank on the run heads
+     * are shared when i and j fall in the same block or in the same run
+     */
+    std::pair<ulint,ulint> rank_pair(size_t i, size_t j, uchar c) const
+    {
+
+        assert(i <= j && j <= n);
+
+        // c does not exist
+        if (runs_per_letter[c].size() == 0) return {0, 0};
+
+        // number of all c
+        if (j == n) return {rank(i, c), runs_per_letter[c].size()};
+
+        if (rank_directory) return rank_pair_by_directory(i, j, c);
+
+        ulint block = runs.rank(i);
+        ulint current_run = block * B;
+        ulint pos = block_start(block);
+        ulint len = scan_to(i, current_run, pos);
+
+        uchar head = run_heads[current_run];
+        ulint rk = run_heads.rank(current_run, c);
+        ulint before = rk == 0 ? 0 : runs_per_letter[c].select(rk-1) + 1;
+
+        ulint rank_i = before + (head == c) * (i - pos);
+
+        // j in the same run
+        if (j < pos + len) return {rank_i, rank_i + (head == c) * (j - i)};
+
+        // j in the same block: continue the scan, otherwise look up its block
+        ulint block_j = runs.rank(j);
+        if (block_j == block)
+        {
+            pos += len;
+            current_run++;
+        }
+        else
+        {
+            current_run = block_j * B;
+            pos = block_start(block_j);
+        }
+        scan_to(j, current_run, pos);
+
+        rk = run_heads.rank(current_run, c);
+        before = rk == 0 ? 0 : runs_per_letter[c].select(rk-1) + 1;
+
+        return {rank_i, before + (run_heads[current_run] == c) * (j - pos)};
+
+    }
+
+    /*
+     * <run of the last c in S[0..i], true iff S[i] == c>, by one block lookup
+     * and one scan. there must be a c in S[0..i]
+     */
+    std::pair<ulint,bool> last_run_of(size_t i, uchar c) const
+    {
+
+        assert(i < n);
+
+        if (rank_directory) return last_run_of_by_directory(i, c);
+
+        ulint block = runs.rank(i);
+        ulint current_run = block * B;
+        ulint pos = block_start(block);
+        scan_to(i, current_run, pos);
+
+        if (run_heads[current_run] == c) return {current_run, true};
+
+        // the last c-run before the current run
+        ulint rk = run_heads.rank(current_run, c);
+        assert(rk > 0);
+
+        return {run_heads.select(rk-1, c), false};
+
+    }
+
+    /*
+     * number of characters smaller than c before position i
+     */
+    ulint rank_less_than(size_t i, uchar c) const
+    {
+
+        assert(i <= n);
+
+        if (!less_than_matrix && rank_directory) return rank_less_than_by_directory(i, c);
+        if (!less_than_matrix) return rank_less_than_by_runs(i, c);
+
+        // every character is smaller than c
+        if (heads_matrix.all_smaller(c)) return i;
+
+        if (i == n) return heads_matrix.less_than(r, c);
+
+        ulint last_block = runs.rank(i);
+        ulint current_run = last_block * B;
+
+        // current position in the string
+        ulint pos = 0;
+        if (last_block > 0) pos = block_start(last_block);
+
+        assert(pos <= i);
+
+        ulint dist = i - pos;
+
+        // scan at most B runs
+        while (pos < i) 
+        {
+            pos += run_at(current_run);
+            current_run++;
+
+            if (pos <= i) dist = i - pos;
+        }
+
+        if (pos > i) current_run--;
+
+        assert(current_run < r);
+
+        // characters smaller than c in the runs before the current run,
+        // and before i in the current run
+        ulint tail = (run_heads[current_run] < c) * dist;
+
+        return heads_matrix.less_than(current_run, c) + tail;
+
+    }
+
     /*
      * run number of text position i
      */
-    ulint run_of_position(size_t i)
+    ulint run_of_position(size_t i) const
     {
 
         assert(i < n);
@@ -202,7 +324,7 @@ public:
         //current position in the string: the first of a block
         ulint pos = 0;
         if(last_block > 0)
-            pos = runs.select(last_block-1)+1;
+            pos = block_start(last_block);
 
         assert(pos <= i);
 
@@ -226,19 +348,19 @@ public:
 
     }
 
-    ulint size() { return n; }
+    ulint size() const { return n; }
 
     /*
      * inclusive range of j-th run
      */
-    range_t run_range(ulint j)
+    range_t run_range(ulint j) const
     {
 
         assert(j < run_heads.size());
 
         ulint this_block = j/B;
         ulint current_run = this_block * B;
-        ulint pos = (this_block == 0 ? 0 : runs.select(this_block-1)+1);
+        ulint pos = block_start(this_block);
 
         while (current_run < j)
         {
@@ -252,13 +374,13 @@ public:
 
     }
 
-    ulint run_start(ulint j)
+    ulint run_start(ulint j) const
     {
         assert(j < run_heads.size());
 
         ulint this_block = j/B;
         ulint current_run = this_block * B;
-        ulint pos = (this_block == 0 ? 0 : runs.select(this_block-1)+1);
+        ulint pos = block_start(this_block);
 
         while (current_run < j)
         {
@@ -271,13 +393,13 @@ public:
         return pos;
     }
 
-    ulint run_end(ulint j)
+    ulint run_end(ulint j) const
     {
         assert(j < run_heads.size());
 
         ulint this_block = j/B;
         ulint current_run = this_block * B;
-        ulint pos = (this_block == 0 ? 0 : runs.select(this_block-1)+1);
+        ulint pos = block_start(this_block);
 
         while (current_run < j)
         {
@@ -294,19 +416,22 @@ public:
     /*
      * length of i-th run
      */
-    ulint run_at(ulint i)
+    ulint run_at(ulint i) const
     {
 
         assert(i < r);
+
+        if (rank_directory) return entry(i/B)[1 + i%B];
+
         uchar c = run_heads[i];
 
         return runs_per_letter[c].gap_at(run_heads.rank(i,c));
 
     }
 
-    ulint number_of_runs() { return r; }
+    ulint number_of_runs() const { return r; }
 
-    ulint serialize(std::ostream& out)
+    ulint serialize(std::ostream& out) const
     {
 
         ulint w_bytes = 0;
@@ -326,6 +451,10 @@ public:
 
         w_bytes += run_heads.serialize(out);
 
+        if (less_than_matrix) w_bytes += heads_matrix.serialize(out);
+
+        if (rank_directory) w_bytes += serialize_directory(out);
+
         return w_bytes;
 
     }
@@ -348,9 +477,13 @@ public:
         
         run_heads.load(in);
 
+        if (less_than_matrix) heads_matrix.load(in);
+
+        if (rank_directory) load_directory(in);
+
     }
 
-    std::string to_string()
+    std::string to_string() const
     {
         
         std::string s;
@@ -362,7 +495,7 @@ public:
 
     }
 
-    ulint print_space()
+    ulint print_space() const
     {
 
         ulint tot_bytes = 0;
@@ -383,11 +516,25 @@ public:
         tot_bytes += bytesize;
         std::cout << "- run heads: " << bytesize << " bytes" << std::endl;
 
+        if (less_than_matrix)
+        {
+            bytesize = heads_matrix.serialize(out);
+            tot_bytes += bytesize;
+            std::cout << "- run heads wavelet matrix: " << bytesize << " bytes" << std::endl;
+        }
+
+        if (rank_directory)
+        {
+            bytesize = serialize_directory(out);
+            tot_bytes += bytesize;
+            std::cout << "- block rank directory: " << bytesize << " bytes" << std::endl;
+        }
+
         return tot_bytes;
 
     }
 
-    ulint get_space()
+    ulint get_space() const
     {
         ulint tot_bytes = 0;
 
@@ -402,19 +549,23 @@ public:
         bytesize = run_heads.serialize(out);
         tot_bytes += bytesize;
 
+        if (less_than_matrix) tot_bytes += heads_matrix.serialize(out);
+
+        if (rank_directory) tot_bytes += serialize_directory(out);
+
         return tot_bytes;
 
     }
 
     // <j(run number of position i), p(last position of j-th run)>
-    std::pair<ulint,ulint> run_of(ulint i)
+    std::pair<ulint,ulint> run_of(ulint i) const
     {
         ulint last_block = runs.rank(i);
         ulint current_run = last_block * B;
 
         // current position in the string
         ulint pos = 0;
-        if (last_block > 0) pos = runs.select(last_block-1) + 1;
+        if (last_block > 0) pos = block_start(last_block);
 
         assert(pos <= i);
 
@@ -441,6 +592,316 @@ public:
 
 private:
 
+    /*
+     * builds the structures from the runs. the bitvectors are built from
+     * the positions of their 1-bits, so memory is proportional to r
+     */
+    void build(std::string const& heads, std::vector<ulint> const& lengths, ulint B)
+    {
+        assert(heads.size() > 0);
+        assert(heads.size() == lengths.size());
+
+        this->B = B;
+        r = heads.size();
+        n = 0;
+
+        std::vector<ulint> runs_ones;
+        auto runs_per_letter_ones = std::vector<std::vector<ulint> >(256);
+        std::vector<ulint> letter_count(256,0);
+
+        if (rank_directory)
+        {
+            std::vector<bool> present(256, false);
+            for (uchar c: heads) present[c] = true;
+            build_columns(present);
+
+            // whole cache lines of 8 words
+            stride = (counts_offset() + columns.size() + 7) / 8 * 8;
+            directory = directory_t((r + B - 1) / B * stride, 0);
+            assert((ulint)directory.data() % 64 == 0);
+        }
+
+        for (ulint j = 0; j < r; ++j)
+        {
+            uchar c = heads[j];
+
+            if (rank_directory)
+            {
+                ulint* e = &directory[j / B * stride];
+
+                // the block starts at run j
+                if (j % B == 0)
+                {
+                    e[0] = n;
+                    for (ulint k = 0; k < columns.size(); ++k) e[counts_offset() + k] = letter_count[columns[k]];
+                }
+
+                e[1 + j % B] = lengths[j];
+                ((uchar*)(e + 1 + B))[j % B] = c;
+            }
+            assert(c != 0);
+            assert(lengths[j] > 0);
+            assert(j == 0 || c != uchar(heads[j-1]));
+
+            n += lengths[j];
+
+            // a bit set only at the end of a block
+            if (j < r-1 && j%B == B-1) runs_ones.push_back(n-1);
+
+            letter_count[c] += lengths[j];
+            runs_per_letter_ones[c].push_back(letter_count[c]-1);
+        }
+
+        runs = sparse_bitvector_t(runs_ones, n);
+
+        runs_per_letter = std::vector<sparse_bitvector_t>(256);
+        for (ulint i = 0; i < 256; ++i)
+            runs_per_letter[i] = sparse_bitvector_t(runs_per_letter_ones[i], letter_count[i]);
+
+        std::string run_heads_s(heads);
+        run_heads = string_t(run_heads_s);
+
+        if (less_than_matrix) heads_matrix = rl_wavelet_matrix<sparse_bitvector_t>(heads, lengths);
+
+        assert(run_heads.size() == r);
+    }
+
+    /*
+     * rank_less_than without the wavelet matrix: one lookup of the run of i,
+     * then the number of c-runs before it for each character a < c
+     */
+    ulint rank_less_than_by_runs(size_t i, uchar c) const
+    {
+        ulint res = 0;
+
+        if (i == n)
+        {
+            for (ulint a = 1; a < c; ++a) res += runs_per_letter[a].size();
+            return res;
+        }
+
+        ulint block = runs.rank(i);
+        ulint current_run = block * B;
+        ulint pos = block_start(block);
+        scan_to(i, current_run, pos);
+
+        for (ulint a = 1; a < c; ++a)
+        {
+            // a does not exist
+            if (runs_per_letter[a].size() == 0) continue;
+
+            ulint rk = run_heads.rank(current_run, (uchar)a);
+            if (rk > 0) res += runs_per_letter[a].select(rk-1) + 1;
+        }
+
+        return res + (run_heads[current_run] < c) * (i - pos);
+    }
+
+    /*
+     * moves run & pos (its starting position, pos <= i) forward to the run
+     * containing position i < n. returns the length of that run
+     */
+    ulint scan_to(size_t i, ulint& run, ulint& pos) const
+    {
+        assert(pos <= i && i < n);
+
+        ulint len = run_at(run);
+        while (pos + len <= i)
+        {
+            pos += len;
+            run++;
+            len = run_at(run);
+        }
+
+        return len;
+    }
+
+    /*
+     * starting position of the block-th block of B runs
+     */
+    ulint block_start(ulint block) const
+    {
+        if (rank_directory) return entry(block)[0];
+        return block == 0 ? 0 : runs.select(block-1) + 1;
+    }
+
+    uchar head_of_run(ulint j) const
+    {
+        if (rank_directory) return ((uchar const*)(entry(j/B) + 1 + B))[j%B];
+        return run_heads[j];
+    }
+
+    /*
+     * directory entry of a block: [starting position, B run lengths, B run
+     * heads packed in bytes, number of each character of columns before it]
+     */
+    ulint const* entry(ulint block) const { return &directory[block * stride]; }
+
+    ulint counts_offset() const { return 1 + B + (B + 7) / 8; }
+
+    /*
+     * rank by the directory entry of the block of i and a scan of its runs.
+     * c must occur and i < n
+     */
+    ulint rank_by_directory(size_t i, uchar c) const
+    {
+        ulint block = runs.rank(i);
+        ulint const* e = entry(block);
+        uchar const* heads = (uchar const*)(e + 1 + B);
+
+        ulint pos = e[0];
+        ulint rk = e[counts_offset() + dense[c]];
+
+        // scan at most B runs, adding the c-runs before i
+        for (ulint k = 0;; ++k)
+        {
+            assert(k < B && block * B + k < r);
+
+            ulint len = e[1 + k];
+            if (pos + len > i) return rk + (heads[k] == c) * (i - pos);
+
+            if (heads[k] == c) rk += len;
+            pos += len;
+        }
+    }
+
+    /*
+     * rank_pair by the entry of the block of i, continuing its scan to j when
+     * j falls in the same block. c must occur and j < n
+     */
+    std::pair<ulint,ulint> rank_pair_by_directory(size_t i, size_t j, uchar c) const
+    {
+        ulint block = runs.rank(i);
+        ulint const* e = entry(block);
+        uchar const* heads = (uchar const*)(e + 1 + B);
+
+        ulint pos = e[0];
+        ulint rk = e[counts_offset() + dense[c]];
+
+        ulint k = 0;
+        while (pos + e[1 + k] <= i)
+        {
+            if (heads[k] == c) rk += e[1 + k];
+            pos += e[1 + k];
+            k++;
+        }
+        ulint rank_i = rk + (heads[k] == c) * (i - pos);
+
+        // runs past the end of the string have length 0 and are skipped
+        for (; k < B; ++k)
+        {
+            ulint len = e[1 + k];
+            if (pos + len > j) return {rank_i, rk + (heads[k] == c) * (j - pos)};
+
+            if (heads[k] == c) rk += len;
+            pos += len;
+        }
+
+        return {rank_i, rank_by_directory(j, c)};
+    }
+
+    /*
+     * last_run_of by the entry of the block of i. the run heads are accessed
+     * only when no c-run of the block starts at or before i
+     */
+    std::pair<ulint,bool> last_run_of_by_directory(size_t i, uchar c) const
+    {
+        ulint block = runs.rank(i);
+        ulint const* e = entry(block);
+        uchar const* heads = (uchar const*)(e + 1 + B);
+
+        ulint pos = e[0];
+        ulint last = B;
+
+        ulint k = 0;
+        while (pos + e[1 + k] <= i)
+        {
+            if (heads[k] == c) last = k;
+            pos += e[1 + k];
+            k++;
+        }
+
+        if (heads[k] == c) return {block * B + k, true};
+        if (last < B) return {block * B + last, false};
+
+        // the last of the c-runs before the block
+        ulint rk = runs_per_letter[c].rank(e[counts_offset() + dense[c]]);
+        assert(rk > 0);
+
+        return {run_heads.select(rk-1, c), false};
+    }
+
+    /*
+     * rank_less_than by the counts of the characters smaller than c in the
+     * entry of the block of i and a scan of its runs
+     */
+    ulint rank_less_than_by_directory(size_t i, uchar c) const
+    {
+        ulint res = 0;
+
+        if (i == n)
+        {
+            for (ulint a = 1; a < c; ++a) res += runs_per_letter[a].size();
+            return res;
+        }
+
+        ulint block = runs.rank(i);
+        ulint const* e = entry(block);
+        uchar const* heads = (uchar const*)(e + 1 + B);
+
+        for (ulint k = 0; k < columns.size() && columns[k] < c; ++k) res += e[counts_offset() + k];
+
+        ulint pos = e[0];
+        for (ulint k = 0;; ++k)
+        {
+            assert(k < B && block * B + k < r);
+
+            ulint len = e[1 + k];
+            if (pos + len > i) return res + (heads[k] < c) * (i - pos);
+
+            if (heads[k] < c) res += len;
+            pos += len;
+        }
+    }
+
+    /*
+     * columns of the directory: the characters present, in increasing order
+     */
+    void build_columns(std::vector<bool> const& present)
+    {
+        columns.clear();
+        dense = std::vector<uchar>(256, 0);
+        for (ulint c = 0; c < 256; ++c)
+        {
+            if (!present[c]) continue;
+            dense[c] = columns.size();
+            columns.push_back(c);
+        }
+    }
+
+    ulint serialize_directory(std::ostream& out) const
+    {
+        ulint size = directory.size();
+        out.write((char*)&stride, sizeof(stride));
+        out.write((char*)&size, sizeof(size));
+        out.write((char*)directory.data(), size * sizeof(ulint));
+
+        return sizeof(stride) + sizeof(size) + size * sizeof(ulint);
+    }
+
+    void load_directory(std::istream& in)
+    {
+        std::vector<bool> present(256, false);
+        for (ulint c = 0; c < 256; ++c) present[c] = runs_per_letter[c].size() > 0;
+        build_columns(present);
+
+        ulint size = 0;
+        in.read((char*)&stride, sizeof(stride));
+        in.read((char*)&size, sizeof(size));
+        directory = directory_t(size);
+        in.read((char*)directory.data(), size * sizeof(ulint));
+    }
+
     // static member func to count the number of runs in s
     static ulint count_runs(std::string& s)
     {
@@ -470,6 +931,18 @@ private:
     // run heads with rank/select support
     string_t run_heads;
 
+    // less_than_matrix: run heads with the number of smaller characters before each run
+    rl_wavelet_matrix<sparse_bitvector_t> heads_matrix;
+
+    // rank_directory: one entry of stride words (a multiple of 8) per block,
+    // cache-line aligned; the counts are in the order of columns, dense[c]
+    // being the column of c
+    typedef std::vector<ulint, cache_aligned_allocator<ulint> > directory_t;
+    directory_t directory;
+    std::vector<uchar> columns;
+    std::vector<uchar> dense;
+    ulint stride = 0;
+
     // text length
     ulint n = 0;
 
@@ -479,6 +952,21 @@ private:
 };
 
 typedef rle_string<sparse_sd_vector> rle_string_sd;
+typedef rle_string<sparse_sd_vector, huffman_string, true> rle_string_sd_dir;
+typedef rle_string<sparse_sd_vector, huffman_string, false, true> rle_string_sd_wm;
+typedef rle_string<sparse_sd_vector, dna_string> rle_string_dna;
+
+/*
+ * run-length BWT of br_index<> & br_index_nplcp<>, so of the tools. built with
+ * BRI_LESS_THAN_MATRIX defined (cmake -DLESS_THAN_MATRIX=ON), their bidirectional
+ * steps take rank_less_than from the wavelet matrix. the indexes of the two
+ * builds are not readable by each other
+ */
+#ifdef BRI_LESS_THAN_MATRIX
+typedef rle_string_sd_wm rle_string_default;
+#else
+typedef rle_string_sd rle_string_default;
+#endif
 
 };
 
@@ -0,0 +1,266 @@
+/*
+ * sample_cache: concurrent cache of the search samples of pattern substrings
+ *
+ *  Query logs are skewed: a few prefixes & suffixes occur in most searches.
+ *  The cache maps a key (a substring, tagged by how its sample was computed)
+ *  to its sample, so that a search can resume from the longest cached part of
+ *  its pattern instead of recomputing it character by character.
+ *
+ *  Keys are spread over shards by their hash, each under its own mutex. A
+ *  shard keeps its share of the memory cap by the CLOCK policy: its samples
+ *  lie in a circle of slots swept by a hand, and a sample is evicted when the
+ *  hand reaches it unless it has been found since the last sweep. So hot
+ *  samples stay while the workload shifts, and a hit only sets a flag.
+ *  Lookups, hits and evictions are counted.
+ */
+
+#ifndef INCLUDED_SAMPLE_CACHE_HPP
+#define INCLUDED_SAMPLE_CACHE_HPP
+
+#include <atomic>
+#include <memory>
+
+#include "definitions.hpp"
+
+namespace bri {
+
+template<class sample_t>
+class sample_cache {
+
+public:
+
+    /*
+     * \param max_bytes: memory cap, estimated as in entry_bytes
+     * \param shards: number of independently locked parts
+     */
+    sample_cache(ulint max_bytes, ulint shards = 16) :
+        cap(max_bytes), parts(std::max<ulint>(1, shards))
+    {}
+
+    /*
+     * if key is cached, copies its sample to sample and marks it as used
+     * returns: true iff key is cached
+     */
+    bool find(std::string const& key, sample_t& sample)
+    {
+        shard& s = shard_of(key);
+        n_lookups++;
+
+        std::lock_guard<std::mutex> lock(s.mtx);
+
+        auto it = s.index.find(key);
+        if (it == s.index.end()) return false;
+
+        slot& x = s.slots[it->second];
+        x.used = true;
+        sample = x.sample;
+        n_hits++;
+
+        return true;
+    }
+
+    /*
+     * caches sample under key, evicting samples of the shard beyond its share
+     * of the cap
+     */
+    void insert(std::string const& key, sample_t const& sample)
+    {
+        ulint bytes = entry_bytes(key);
+        ulint shard_cap = cap / parts.size();
+        if (bytes > shard_cap) return;
+
+        shard& s = shard_of(key);
+        std::lock_guard<std::mutex> lock(s.mtx);
+
+        auto it = s.index.find(key);
+        if (it != s.index.end())
+        {
+            s.slots[it->second].sample = sample;
+            s.slots[it->second].used = true;
+            return;
+        }
+
+        while (s.bytes + bytes > shard_cap) evict(s);
+
+        s.index[key] = s.slots.size();
+        s.slots.push_back({key, sample, false});
+        s.bytes += bytes;
+    }
+
+    /*
+     * removes every sample. the counters are kept
+     */
+    void clear()
+    {
+        for (auto& s: parts)
+        {
+            std::lock_guard<std::mutex> lock(s.mtx);
+            s.slots.clear();
+            s.index.clear();
+            s.hand = 0;
+            s.bytes = 0;
+        }
+    }
+
+    ulint lookups() const { return n_lookups; }
+    ulint hits() const { return n_hits; }
+    ulint evictions() const { return n_evictions; }
+
+    /*
+     * returns: fraction of the lookups that found their key, 0 without lookups
+     */
+    double hit_rate() const
+    {
+        ulint l = lookups();
+        return l == 0 ? 0 : (double)hits() / l;
+    }
+
+    /*
+     * returns: number of cached samples
+     */
+    ulint size() const
+    {
+        ulint res = 0;
+        for (auto& s: parts)
+        {
+            std::lock_guard<std::mutex> lock(s.mtx);
+            res += s.slots.size();
+        }
+        return res;
+    }
+
+    /*
+     * returns: estimated bytes of the cached samples, at most max_bytes()
+     */
+    ulint bytes() const
+    {
+        ulint res = 0;
+        for (auto& s: parts)
+        {
+            std::lock_guard<std::mutex> lock(s.mtx);
+            res += s.bytes;
+        }
+        return res;
+    }
+
+    ulint max_bytes() const { return cap; }
+
+private:
+
+    struct slot {
+        std::string key;
+        sample_t sample;
+        // found since the hand last passed
+        bool used;
+    };
+
+    struct shard {
+        mutable std::mutex mtx;
+        std::vector<slot> slots;
+        // slot of each key
+        std::unordered_map<std::string, ulint> index;
+        ulint hand = 0;
+        ulint bytes = 0;
+    };
+
+    /*
+     * estimated bytes of an entry: a slot, and a node of the index holding
+     * another copy of the key, the slot number and about 2 pointers
+     */
+    static ulint entry_bytes(std::string const& key)
+    {
+        return 2 * key.size() + sizeof(slot) + sizeof(std::string) + 3 * sizeof(void*);
+    }
+
+    /*
+     * moves the hand to the first slot not used since its last pass, clearing
+     * the flags on the way, and evicts its sample. the last slot fills the hole
+     */
+    void evict(shard& s)
+    {
+        while (true)
+        {
+            if (s.hand >= s.slots.size()) s.hand = 0;
+
+            slot& x = s.slots[s.hand];
+            if (x.used)
+            {
+                x.used = false;
+                s.hand++;
+                continue;
+            }
+
+            s.bytes -= entry_bytes(x.key);
+            s.index.erase(x.key);
+            if (s.hand + 1 < s.slots.size())
+            {
+                x = std::move(s.slots.back());
+                s.index[x.key] = s.hand;
+            }
+            s.slots.pop_back();
+            n_evictions++;
+            return;
+        }
+    }
+
+    shard& shard_of(std::string const& key)
+    {
+        return parts[std::hash<std::string>()(key) % parts.size()];
+    }
+
+    ulint cap;
+    std::vector<shard> parts;
+
+    std::atomic<ulint> n_lookups{0};
+    std::atomic<ulint> n_hits{0};
+    std::atomic<ulint> n_evictions{0};
+
+};
+
+/*
+ * the optional cache of an index. its samples belong to that index, so a copy
+ * gets an empty cache of the same cap instead of sharing them: loading another
+ * index into the copy cannot make the original find stale samples
+ */
+template<class sample_t>
+class sample_cache_ptr {
+
+public:
+
+    sample_cache_ptr() {}
+
+    sample_cache_ptr(sample_cache_ptr const& other)
+    {
+        reset(other ? other->max_bytes() : 0);
+    }
+
+    sample_cache_ptr& operator=(sample_cache_ptr const& other)
+    {
+        if (this != &other) reset(other ? other->max_bytes() : 0);
+        return *this;
+    }
+
+    /*
+     * replaces the cache by an empty one of max_bytes. 0 removes it
+     */
+    void reset(ulint max_bytes = 0)
+    {
+        if (max_bytes == 0) ptr.reset();
+        else ptr.reset(new sample_cache<sample_t>(max_bytes));
+    }
+
+    explicit operator bool() const { return ptr != nullptr; }
+
+    // the cache is locked by itself, so const indexes insert into it
+    sample_cache<sample_t>* operator->() const { return ptr.get(); }
+    sample_cache<sample_t>* get() const { return ptr.get(); }
+
+private:
+
+    std::unique_ptr<sample_cache<sample_t> > ptr;
+
+};
+
+};
+
+#endif /* INCLUDED_SAMPLE_CACHE_HPP */
@@ -63,6 +63,40 @@ public:
         if (select_enabled) select1 = sdsl::sd_vector<>::select_1_type(&sdv);
     }
 
+    /*
+     * constructor. build using positions of 1-bits, without a bitvector of length u
+     * \param ones: strictly increasing positions of 1-bits
+     * \param u: length of the bitvector
+     */
+    sparse_sd_vector(std::vector<ulint> const& ones, ulint u, bool enable_rank=true, bool enable_select=true)
+    {
+        if (u == 0) return;
+
+        rank_enabled = enable_rank;
+        select_enabled = enable_select;
+
+        this->u = u;
+
+        sdsl::sd_vector_builder builder(u, ones.size());
+        for (auto p: ones)
+        {
+            assert(p < u);
+            builder.set(p);
+        }
+
+        sdv = sdsl::sd_vector<>(builder);
+        if (rank_enabled) rank1 = sdsl::sd_vector<>::rank_1_type(&sdv);
+        if (select_enabled) select1 = sdsl::sd_vector<>::select_1_type(&sdv);
+    }
+
+    /*
+     * copy constructor. rank/select are bound to the copy, not to other
+     */
+    sparse_sd_vector(const sparse_sd_vector& other)
+    {
+        operator=(other);
+    }
+
     /*
      * substitution operator.
      */
@@ -79,21 +113,21 @@ public:
         return *this;
     }
 
-    bool rank_supported() { return rank_enabled; }
-    bool select_supported() { return select_enabled; }
+    bool rank_supported() const { return rank_enabled; }
+    bool select_supported() const { return select_enabled; }
 
     /*
      * argument: position i 
      * returns: bit in position i
      * ACCESS ONLY
      */
-    bool operator[](size_t i) 
+    bool operator[](size_t i) const
     {
         assert(i < size());
         return sdv[i];
     }
 
-    bool at(size_t i)
+    bool at(size_t i) const
     {
         return operator[](i);
     }
@@ -102,7 +136,7 @@ public:
      * argument: position i 
      * returns: number of 1-bits in sdv[0...i-1]
      */
-    ulint rank(size_t i)
+    ulint rank(size_t i) const
     {
         assert(rank_enabled);
         assert(i <= size());
@@ -114,7 +148,7 @@ public:
 	 * argument: position 0<=i<=n
 	 * returns: predecessor of i (position i excluded)
 	 */
-    size_t predecessor(size_t i)
+    size_t predecessor(size_t i) const
     {
         assert(rank_enabled);
         assert(select_enabled);
@@ -129,12 +163,12 @@ public:
 	 * bitvector space. If i does not have a predecessor,
 	 * return rank of the last bit set in the bitvector
 	 */
-    ulint predecessor_rank_circular(ulint i)
+    ulint predecessor_rank_circular(ulint i) const
     {
         return rank(i) == 0 ? number_of_1() - 1 : rank(i) - 1;
     }
     
-    ulint gap_at(size_t i)
+    ulint gap_at(size_t i) const
     {
         assert(select_enabled);
         assert(i<number_of_1());
@@ -148,7 +182,7 @@ public:
 	 * argument: ulint i >= 0
 	 * returns: position of the i-th 1-bit
 	 */
-    size_t select(ulint i)
+    size_t select(ulint i) const
     {
         assert(select_enabled);
         assert(i<number_of_1());
@@ -159,12 +193,12 @@ public:
     /*
      * returns: size of the bitvector
      */
-    ulint size() { return u; }
+    ulint size() const { return u; }
 
     /*
      * returns: number of 1s in the bitvector
      */
-    ulint number_of_1() { 
+    ulint number_of_1() const { 
 
         assert(rank_enabled);
         return rank1(u); 
@@ -175,7 +209,7 @@ public:
      * argument: ostream
      * returns: number of bytes written to ostream
      */
-    ulint serialize(std::ostream& out)
+    ulint serialize(std::ostream& out) const
     {
         ulint w_bytes = 0;
 
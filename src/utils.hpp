@@ -5,7 +5,7 @@
 
 namespace bri {
 
-std::string get_time(ulint time){
+inline std::string get_time(ulint time){
 
 	std::stringstream ss;
 
@@ -34,20 +34,29 @@ std::string get_time(ulint time){
 
 }
 
-uchar bitsize(ulint x)
+/*
+ * prints the progress after the i-th of n patterns when its percentage is new
+ */
+inline void print_progress(std::ostream& out, ulint i, ulint n)
+{
+	if (i > 0 && 100 * i / n > 100 * (i - 1) / n)
+		out << 100 * i / n << "% done ..." << std::endl;
+}
+
+inline uchar bitsize(ulint x)
 {
     if (x == 0) return 1;
     return 64 - __builtin_clzll(x);
 }
 
 //parse pizza&chilli patterns header:
-void header_error(){
+inline void header_error(){
 	std::cout << "Error: malformed header in patterns file" << std::endl;
 	std::cout << "Take a look here for more info on the file format: http://pizzachili.dcc.uchile.cl/experiments.html" << std::endl;
 	exit(0);
 }
 
-ulint get_number_of_patterns(std::string header){
+inline ulint get_number_of_patterns(std::string header){
 
 	ulint start_pos = header.find("number=");
 	if (start_pos == std::string::npos or start_pos+7>=header.size())
@@ -65,7 +74,7 @@ ulint get_number_of_patterns(std::string header){
 
 }
 
-ulint get_patterns_length(std::string header){
+inline ulint get_patterns_length(std::string header){
 
 	ulint start_pos = header.find("length=");
 	if (start_pos == std::string::npos or start_pos+7>=header.size())
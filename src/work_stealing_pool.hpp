@@ -0,0 +1,139 @@
+/*
+ * work_stealing_pool: runs the tasks 0..n-1 on a fixed number of threads.
+ *
+ *  Each thread starts with a contiguous range of tasks and takes them from its
+ *  front. A thread whose range is empty steals the last task of the largest
+ *  remaining range, so uneven tasks (patterns with many occurrences) do not
+ *  leave threads idle.
+ *
+ *  ordered_output prints what each task wrote as soon as all the previous tasks
+ *  are done, so the output does not depend on the number of threads.
+ */
+
+#ifndef INCLUDED_WORK_STEALING_POOL_HPP
+#define INCLUDED_WORK_STEALING_POOL_HPP
+
+#include "definitions.hpp"
+
+namespace bri {
+
+class work_stealing_pool {
+
+public:
+
+    work_stealing_pool(ulint threads = 1) : threads(std::max<ulint>(1, threads)) {}
+
+    ulint size() const { return threads; }
+
+    /*
+     * runs f(task, thread) for every task in [0, tasks), thread in [0, size())
+     * being the thread running it. the calling thread is thread 0
+     */
+    template<class F>
+    void run(ulint tasks, F f)
+    {
+        // [begin, end) of the tasks left to each thread
+        std::vector<range_t> left(threads);
+        std::vector<std::mutex> locks(threads);
+        for (ulint t = 0; t < threads; ++t)
+            left[t] = {tasks * t / threads, tasks * (t + 1) / threads};
+
+        auto work = [&](ulint t)
+        {
+            while (true)
+            {
+                ulint task = tasks;
+                {
+                    std::lock_guard<std::mutex> lock(locks[t]);
+                    if (left[t].first < left[t].second) task = left[t].first++;
+                }
+                if (task == tasks) task = steal(tasks, left, locks);
+                if (task == tasks) return;
+
+                f(task, t);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (ulint t = 1; t < threads; ++t) pool.push_back(std::thread(work, t));
+        work(0);
+        for (auto& th: pool) th.join();
+    }
+
+private:
+
+    /*
+     * takes the last task of the largest range, tasks if every range is empty
+     */
+    ulint steal(ulint tasks, std::vector<range_t>& left, std::vector<std::mutex>& locks)
+    {
+        while (true)
+        {
+            ulint victim = threads, largest = 0;
+            for (ulint t = 0; t < threads; ++t)
+            {
+                std::lock_guard<std::mutex> lock(locks[t]);
+                if (left[t].second - left[t].first > largest)
+                {
+                    victim = t;
+                    largest = left[t].second - left[t].first;
+                }
+            }
+            if (victim == threads) return tasks;
+
+            std::lock_guard<std::mutex> lock(locks[victim]);
+            // the range may have shrunk since it was measured
+            if (left[victim].first < left[victim].second) return --left[victim].second;
+        }
+    }
+
+    ulint threads;
+
+};
+
+class ordered_output {
+
+public:
+
+    /*
+     * \param out: stream receiving the outputs
+     * \param tasks: number of tasks
+     */
+    ordered_output(std::ostream& out, ulint tasks) :
+        out(out), outputs(tasks), finished(tasks, false) {}
+
+    /*
+     * the output s of task is complete. prints it and the outputs of the
+     * following finished tasks if every previous task is done
+     */
+    void done(ulint task, std::string const& s)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        outputs[task] = s;
+        finished[task] = true;
+
+        while (next < finished.size() && finished[next])
+        {
+            out << outputs[next] << std::flush;
+            std::string().swap(outputs[next]);
+            next++;
+        }
+    }
+
+private:
+
+    std::ostream& out;
+    std::mutex mtx;
+
+    std::vector<std::string> outputs;
+    std::vector<bool> finished;
+
+    // first task not printed yet
+    ulint next = 0;
+
+};
+
+};
+
+#endif /* INCLUDED_WORK_STEALING_POOL_HPP */
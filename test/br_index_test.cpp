@@ -1,9 +1,15 @@
 #include "iutest.hpp"
 #include <vector>
+#include <cstring>
+#include <chrono>
 #include <fstream>
+#include <random>
+#include <sstream>
 #include <string>
+#include <thread>
 
 #include "../src/br_index.hpp"
+#include "../src/br_index_nplcp.hpp"
 #include "../src/br_index_naive.hpp"
 
 using namespace bri;
@@ -166,6 +172,964 @@ IUTEST(BrIndexTest, DNALikeTextLocate)
  */
 
 
+IUTEST(BrIndexTest, RankDirectory)
+{
+    std::string s;
+    {
+        std::mt19937 engine(19);
+        for (ulint i = 0; i < 2000; ++i) s.push_back("ACGT"[engine()%4]);
+    }
+
+    br_index<> idx(s);
+    br_index<sparse_sd_vector, rle_string_sd_dir> idx_dir(s);
+
+    // LF and LFR on ranges, which rank both ends of the range at once
+    std::mt19937 engine(29);
+    for (ulint t = 0; t < 2000; ++t)
+    {
+        ulint first = engine() % idx.bwt_size();
+        ulint last = std::min<ulint>(idx.bwt_size() - 1, first + (t % 2 ? engine() % 4 : engine() % idx.bwt_size()));
+        for (ulint c = 0; c < 255; ++c)
+        {
+            range_t rn = idx.LF({first, last}, (uchar)c);
+            range_t rn_dir = idx_dir.LF({first, last}, (uchar)c);
+            IUTEST_ASSERT_EQ(rn.first, rn_dir.first);
+            IUTEST_ASSERT_EQ(rn.second, rn_dir.second);
+
+            rn = idx.LFR({first, last}, (uchar)c);
+            rn_dir = idx_dir.LFR({first, last}, (uchar)c);
+            IUTEST_ASSERT_EQ(rn.first, rn_dir.first);
+            IUTEST_ASSERT_EQ(rn.second, rn_dir.second);
+        }
+    }
+
+    for (std::string p: {"A", "CG", "GATT", "TTTTTT"})
+    {
+        IUTEST_ASSERT_EQ(idx.count(p), idx_dir.count(p));
+
+        auto occ = idx.locate(p);
+        auto occ_dir = idx_dir.locate(p);
+        std::sort(occ.begin(), occ.end());
+        std::sort(occ_dir.begin(), occ_dir.end());
+        IUTEST_ASSERT_EQ(occ.size(), occ_dir.size());
+        for (ulint i = 0; i < occ.size(); ++i) IUTEST_ASSERT_EQ(occ[i], occ_dir[i]);
+    }
+}
+
+IUTEST(BrIndexTest, DnaRunHeads)
+{
+    std::string s;
+    {
+        std::mt19937 engine(23);
+        std::string dna;
+        for (ulint i = 0; i < 1000; ++i) dna.push_back("ACGTN"[engine()%5]);
+        for (ulint i = 0; i < 3; ++i)
+        {
+            std::string copy(dna);
+            for (ulint j = 0; j < 5; ++j) copy[engine()%copy.size()] = "ACGT"[engine()%4];
+            s += copy;
+        }
+    }
+
+    br_index<> idx(s);
+    br_index<sparse_sd_vector, rle_string_dna> idx_dna(s);
+
+    std::stringstream ss;
+    idx_dna.serialize(ss);
+    br_index<sparse_sd_vector, rle_string_dna> loaded;
+    loaded.load(ss);
+
+    for (std::string p: {"A", "N", "CGN", "GATT", "ACGTACGT"})
+    {
+        IUTEST_ASSERT_EQ(idx.count(p), idx_dna.count(p));
+        IUTEST_ASSERT_EQ(idx.count(p), loaded.count(p));
+
+        auto occ = idx.locate(p);
+        auto occ_dna = loaded.locate(p);
+        std::sort(occ.begin(), occ.end());
+        std::sort(occ_dna.begin(), occ_dna.end());
+        IUTEST_ASSERT_EQ(occ.size(), occ_dna.size());
+        for (ulint i = 0; i < occ.size(); ++i) IUTEST_ASSERT_EQ(occ[i], occ_dna[i]);
+    }
+}
+
+IUTEST(BrIndexTest, Batch)
+{
+    std::string s;
+    {
+        std::mt19937 engine(29);
+        std::string dna;
+        for (ulint i = 0; i < 1500; ++i) dna.push_back("ACGT"[engine()%4]);
+        for (ulint i = 0; i < 3; ++i)
+        {
+            std::string copy(dna);
+            for (ulint j = 0; j < 5; ++j) copy[engine()%copy.size()] = "ACGT"[engine()%4];
+            s += copy;
+        }
+    }
+
+    br_index<> idx(s);
+
+    // patterns of different lengths and absent ones
+    std::vector<std::string> patterns;
+    {
+        std::mt19937 engine(31);
+        for (ulint i = 0; i < 50; ++i)
+        {
+            ulint len = 1 + engine()%12;
+            patterns.push_back(s.substr(engine()%(s.size()-len), len));
+        }
+    }
+    patterns.push_back("ACGTACGTACGTACGTACGT");
+    patterns.push_back("X");
+
+    auto counts = idx.count_batch(patterns);
+    auto occs = idx.locate_batch(patterns);
+    IUTEST_ASSERT_EQ(patterns.size(), counts.size());
+    IUTEST_ASSERT_EQ(patterns.size(), occs.size());
+
+    for (ulint k = 0; k < patterns.size(); ++k)
+    {
+        IUTEST_ASSERT_EQ(idx.count(patterns[k]), counts[k]);
+
+        auto expected = idx.locate(patterns[k]);
+        IUTEST_ASSERT_EQ(expected.size(), occs[k].size());
+        for (ulint i = 0; i < expected.size(); ++i) IUTEST_ASSERT_EQ(expected[i], occs[k][i]);
+    }
+}
+
+/*
+ * the results of all queries on patterns, computed through a const reference
+ */
+template<class index_t>
+std::vector<std::vector<ulint> > query_all(index_t const& idx, std::vector<std::string> const& patterns)
+{
+    std::vector<std::vector<ulint> > res;
+    auto batch = idx.locate_batch(patterns);
+    auto counts = idx.count_batch(patterns);
+    for (ulint k = 0; k < patterns.size(); ++k)
+    {
+        std::vector<ulint> occ = idx.locate(patterns[k]);
+        std::vector<ulint> mis = idx.locate_samples(idx.search_with_mismatch(patterns[k], 1));
+        std::vector<ulint> seed = idx.locate_samples(idx.seed_and_extend(patterns[k], 2, 4, 1));
+        std::sort(occ.begin(), occ.end());
+        std::sort(mis.begin(), mis.end());
+        std::sort(seed.begin(), seed.end());
+        std::sort(batch[k].begin(), batch[k].end());
+
+        res.push_back(occ);
+        res.push_back(mis);
+        res.push_back(seed);
+        res.push_back(batch[k]);
+        res.push_back(std::vector<ulint>(1, idx.count(patterns[k])));
+        res.push_back(std::vector<ulint>(1, counts[k]));
+    }
+    return res;
+}
+
+/*
+ * threads share one index and must get the results of a single thread
+ */
+template<class index_t>
+void check_concurrent_queries(std::string const& s, std::vector<std::string> const& patterns)
+{
+    index_t idx(s);
+    index_t const& shared = idx;
+
+    auto expected = query_all(shared, patterns);
+
+    ulint threads = 8;
+    std::vector<std::vector<std::vector<ulint> > > results(threads);
+    std::vector<std::thread> pool;
+    for (ulint t = 0; t < threads; ++t)
+    {
+        pool.push_back(std::thread([&shared, &patterns, &results, t]()
+        {
+            for (ulint round = 0; round < 5; ++round) results[t] = query_all(shared, patterns);
+        }));
+    }
+    for (auto& th: pool) th.join();
+
+    for (ulint t = 0; t < threads; ++t)
+    {
+        IUTEST_ASSERT_EQ(expected.size(), results[t].size());
+        for (ulint k = 0; k < expected.size(); ++k)
+        {
+            IUTEST_ASSERT_EQ(expected[k].size(), results[t][k].size());
+            for (ulint i = 0; i < expected[k].size(); ++i) IUTEST_ASSERT_EQ(expected[k][i], results[t][k][i]);
+        }
+    }
+}
+
+/*
+ * the bidirectional steps of the indexes with the wavelet matrix of
+ * rank_less_than find what the default ones find, on a large alphabet
+ */
+IUTEST(BrIndexTest, LessThanMatrix)
+{
+    std::string s;
+    {
+        std::mt19937 engine(71);
+        std::string block;
+        for (ulint i = 0; i < 400; ++i) block.push_back((char)(2 + engine()%200));
+        for (ulint i = 0; i < 4; ++i)
+        {
+            std::string copy(block);
+            for (ulint j = 0; j < 8; ++j) copy[engine()%copy.size()] = (char)(2 + engine()%200);
+            s += copy;
+        }
+    }
+
+    std::vector<std::string> patterns;
+    {
+        std::mt19937 engine(73);
+        for (ulint i = 0; i < 30; ++i)
+        {
+            std::string p = s.substr(engine()%(s.size()-10), 3 + engine()%8);
+            if (i % 3 == 0) p[engine()%p.size()] = (char)(2 + engine()%200);
+            patterns.push_back(p);
+        }
+    }
+
+    br_index<sparse_sd_vector, rle_string_sd> idx(s);
+    br_index_wm idx_wm(s);
+    br_index_nplcp_wm idx_nplcp_wm(s);
+
+    std::stringstream ss;
+    idx_wm.serialize(ss);
+    br_index_wm loaded;
+    loaded.load(ss);
+
+    auto expected = query_all(idx, patterns);
+    for (auto const& res: {query_all(idx_wm, patterns), query_all(idx_nplcp_wm, patterns), query_all(loaded, patterns)})
+    {
+        IUTEST_ASSERT_EQ(expected.size(), res.size());
+        for (ulint k = 0; k < expected.size(); ++k)
+        {
+            IUTEST_ASSERT_EQ(expected[k].size(), res[k].size());
+            for (ulint i = 0; i < expected[k].size(); ++i) IUTEST_ASSERT_EQ(expected[k][i], res[k][i]);
+        }
+    }
+}
+
+IUTEST(BrIndexTest, ConcurrentQueries)
+{
+    std::string s;
+    {
+        std::mt19937 engine(37);
+        std::string dna;
+        for (ulint i = 0; i < 1000; ++i) dna.push_back("ACGT"[engine()%4]);
+        for (ulint i = 0; i < 3; ++i)
+        {
+            std::string copy(dna);
+            for (ulint j = 0; j < 5; ++j) copy[engine()%copy.size()] = "ACGT"[engine()%4];
+            s += copy;
+        }
+    }
+
+    std::vector<std::string> patterns;
+    {
+        std::mt19937 engine(41);
+        for (ulint i = 0; i < 20; ++i) patterns.push_back(s.substr(engine()%(s.size()-8), 8));
+    }
+    patterns.push_back("TTTTTTTT");
+
+    check_concurrent_queries<br_index<> >(s, patterns);
+    check_concurrent_queries<br_index_nplcp<> >(s, patterns);
+}
+
+IUTEST(BrIndexTest, QgramTable)
+{
+    std::string s;
+    {
+        std::mt19937 engine(43);
+        std::string dna;
+        for (ulint i = 0; i < 1000; ++i) dna.push_back("ACGT"[engine()%4]);
+        for (ulint i = 0; i < 3; ++i)
+        {
+            std::string copy(dna);
+            for (ulint j = 0; j < 5; ++j) copy[engine()%copy.size()] = "ACGT"[engine()%4];
+            s += copy;
+        }
+    }
+
+    // patterns shorter & longer than q, absent q-grams and absent characters
+    std::vector<std::string> patterns;
+    {
+        std::mt19937 engine(47);
+        for (ulint i = 0; i < 30; ++i)
+        {
+            ulint len = 4 + engine()%9;
+            patterns.push_back(s.substr(engine()%(s.size()-len), len));
+        }
+        for (ulint i = 0; i < 10; ++i)
+        {
+            std::string p;
+            for (ulint j = 0; j < 10; ++j) p.push_back("ACGT"[engine()%4]);
+            patterns.push_back(p);
+        }
+    }
+    patterns.push_back("ACGTNACGT");
+    patterns.push_back("NNNN");
+
+    br_index<> idx(s);
+    IUTEST_ASSERT_EQ(0, idx.qgram_length());
+    auto expected = query_all(idx, patterns);
+
+    for (ulint q: {1, 3, 6, 12})
+    {
+        build_config bc;
+        bc.qgram = q;
+        br_index<> idx_q(s, true, false, bc);
+        IUTEST_ASSERT_EQ(q, idx_q.qgram_length());
+
+        // the table is saved & loaded as an optional section
+        std::stringstream ss;
+        idx_q.serialize(ss);
+        br_index<> loaded;
+        loaded.load(ss);
+        IUTEST_ASSERT_EQ(q, loaded.qgram_length());
+
+        for (auto const& x: {&idx_q, &loaded})
+        {
+            auto res = query_all(*x, patterns);
+            IUTEST_ASSERT_EQ(expected.size(), res.size());
+            for (ulint k = 0; k < expected.size(); ++k)
+            {
+                IUTEST_ASSERT_EQ(expected[k].size(), res[k].size());
+                for (ulint i = 0; i < expected[k].size(); ++i) IUTEST_ASSERT_EQ(expected[k][i], res[k][i]);
+            }
+        }
+    }
+
+    // indexes with & without a table in one stream, followed by other data
+    build_config bc;
+    bc.qgram = 3;
+    br_index<> idx_q(s, true, false, bc);
+
+    std::stringstream ss;
+    idx.serialize(ss);
+    idx_q.serialize(ss);
+    idx.serialize(ss);
+    ss << "trailing data";
+
+    br_index<> loaded, loaded_q, loaded_last;
+    loaded.load(ss);
+    loaded_q.load(ss);
+    loaded_last.load(ss);
+    IUTEST_ASSERT_EQ(0, loaded.qgram_length());
+    IUTEST_ASSERT_EQ(3, loaded_q.qgram_length());
+    IUTEST_ASSERT_EQ(0, loaded_last.qgram_length());
+    IUTEST_ASSERT_EQ(idx.get_space(), loaded.get_space());
+    IUTEST_ASSERT_EQ(idx_q.get_space(), loaded_q.get_space());
+
+    std::string rest;
+    std::getline(ss, rest);
+    IUTEST_ASSERT_EQ("trailing data", rest);
+
+    // without a table, the index is written in the format from before the
+    // q-gram tables, which starts with sigma; with a table, a tag comes first
+    std::stringstream full, full_q;
+    idx.serialize(full);
+    idx_q.serialize(full_q);
+    std::string bytes = full.str(), bytes_q = full_q.str();
+    ulint first_word = 0;
+    std::memcpy(&first_word, bytes.data(), sizeof(first_word));
+    IUTEST_ASSERT_LT(first_word, 256);
+    IUTEST_ASSERT_EQ("bri-qgr", bytes_q.substr(0, 7));
+
+    // such a file ends after plcp
+    std::stringstream old(bytes);
+    br_index<> loaded_old;
+    loaded_old.load(old);
+    IUTEST_ASSERT_EQ(bytes.size(), (ulint)old.tellg());
+    IUTEST_ASSERT_EQ(0, loaded_old.qgram_length());
+    IUTEST_ASSERT_EQ(idx.count("ACGT"), loaded_old.count("ACGT"));
+}
+
+/*
+ * the samples of backward_search & forward_search of the parts of each pattern
+ */
+template<class index_t>
+std::vector<std::vector<ulint> > search_parts(index_t const& idx, std::vector<std::string> const& patterns)
+{
+    std::vector<std::vector<ulint> > res;
+    for (auto const& p: patterns)
+    {
+        for (ulint left = 0; left < p.size(); left += 3)
+        {
+            for (bool forward: {false, true})
+            {
+                auto s = forward ? idx.forward_search(p, left, p.size()-1, idx.get_initial_sample())
+                                 : idx.backward_search(p, left, p.size()-1, idx.get_initial_sample());
+                if (s.is_invalid()) res.push_back(std::vector<ulint>());
+                else res.push_back({s.range.first, s.range.second, s.rangeR.first, s.rangeR.second, s.j, s.d, s.len});
+            }
+        }
+    }
+    return res;
+}
+
+/*
+ * queries with the cache on return what they return without it, whether the
+ * samples are cached, evicted or shared by threads
+ */
+template<class index_t>
+void check_sample_cache(index_t& idx, std::vector<std::string> const& patterns)
+{
+    idx.set_cache(0);
+    IUTEST_ASSERT_TRUE(idx.get_cache() == nullptr);
+    auto expected = query_all(idx, patterns);
+    auto expected_parts = search_parts(idx, patterns);
+
+    auto check = [&](std::vector<std::vector<ulint> > const& res, std::vector<std::vector<ulint> > const& exp)
+    {
+        IUTEST_ASSERT_EQ(exp.size(), res.size());
+        for (ulint k = 0; k < exp.size(); ++k)
+        {
+            IUTEST_ASSERT_EQ(exp[k].size(), res[k].size());
+            for (ulint i = 0; i < exp[k].size(); ++i) IUTEST_ASSERT_EQ(exp[k][i], res[k][i]);
+        }
+    };
+
+    for (ulint cap: {1 << 20, 3000})
+    {
+        idx.set_cache(cap);
+        index_t const& shared = idx;
+
+        // cold, then warm
+        for (ulint round = 0; round < 2; ++round)
+        {
+            check(query_all(shared, patterns), expected);
+            check(search_parts(shared, patterns), expected_parts);
+        }
+        IUTEST_ASSERT_GT(shared.get_cache()->hits(), 0);
+        IUTEST_ASSERT_LE(shared.get_cache()->bytes(), cap);
+        if (cap < 10000) IUTEST_ASSERT_GT(shared.get_cache()->evictions(), 0);
+
+        std::vector<std::vector<std::vector<ulint> > > results(4);
+        std::vector<std::thread> pool;
+        for (ulint t = 0; t < results.size(); ++t)
+            pool.push_back(std::thread([&shared, &patterns, &results, t]() { results[t] = query_all(shared, patterns); }));
+        for (auto& th: pool) th.join();
+        for (auto const& res: results) check(res, expected);
+    }
+    idx.set_cache(0);
+}
+
+IUTEST(BrIndexTest, SampleCache)
+{
+    std::string s;
+    {
+        std::mt19937 engine(53);
+        std::string dna;
+        for (ulint i = 0; i < 1000; ++i) dna.push_back("ACGT"[engine()%4]);
+        for (ulint i = 0; i < 3; ++i)
+        {
+            std::string copy(dna);
+            for (ulint j = 0; j < 5; ++j) copy[engine()%copy.size()] = "ACGT"[engine()%4];
+            s += copy;
+        }
+    }
+
+    // a skewed workload: patterns sharing suffixes & prefixes, repeated
+    std::vector<std::string> patterns;
+    {
+        std::mt19937 engine(59);
+        std::vector<std::string> hot;
+        for (ulint i = 0; i < 5; ++i) hot.push_back(s.substr(engine()%(s.size()-12), 12));
+        for (ulint i = 0; i < 40; ++i)
+        {
+            std::string const& h = hot[engine()%hot.size()];
+            ulint len = 4 + engine()%9;
+            patterns.push_back(engine()%2 ? h.substr(0, len) : h.substr(h.size()-len));
+        }
+        patterns.push_back("ACGTTGCAACGT");
+        patterns.push_back("ACGN");
+    }
+
+    br_index<> idx(s);
+    check_sample_cache(idx, patterns);
+
+    build_config bc;
+    bc.qgram = 5;
+    br_index<> idx_q(s, true, false, bc);
+    check_sample_cache(idx_q, patterns);
+
+    br_index_nplcp<> idx_nplcp(s);
+    check_sample_cache(idx_nplcp, patterns);
+}
+
+/*
+ * a copy of an index with a cache gets its own empty cache, so loading
+ * another index into the copy leaves the samples of the original alone
+ */
+template<class index_t>
+void check_cache_copy(std::string const& s1, std::string const& s2, std::vector<std::string> const& patterns)
+{
+    index_t idx(s1);
+    index_t other(s2);
+    auto expected = query_all(idx, patterns);
+    auto expected_other = query_all(other, patterns);
+    std::stringstream ss;
+    other.serialize(ss);
+
+    auto check = [&](std::vector<std::vector<ulint> > const& res, std::vector<std::vector<ulint> > const& exp)
+    {
+        IUTEST_ASSERT_EQ(exp.size(), res.size());
+        for (ulint k = 0; k < exp.size(); ++k)
+        {
+            IUTEST_ASSERT_EQ(exp[k].size(), res[k].size());
+            for (ulint i = 0; i < exp[k].size(); ++i) IUTEST_ASSERT_EQ(exp[k][i], res[k][i]);
+        }
+    };
+
+    idx.set_cache(1 << 20);
+    check(query_all(idx, patterns), expected);
+    IUTEST_ASSERT_GT(idx.get_cache()->size(), 0);
+
+    auto check_copy = [&](index_t& copy)
+    {
+        IUTEST_ASSERT_TRUE(copy.get_cache() != nullptr);
+        IUTEST_ASSERT_TRUE(copy.get_cache() != idx.get_cache());
+        IUTEST_ASSERT_EQ(idx.get_cache()->max_bytes(), copy.get_cache()->max_bytes());
+        IUTEST_ASSERT_EQ(0, copy.get_cache()->size());
+
+        ss.clear();
+        ss.seekg(0);
+        copy.load(ss);
+
+        // cold, then warm on the loaded index; the original still finds its own samples
+        ulint lookups = idx.get_cache()->lookups();
+        check(query_all(copy, patterns), expected_other);
+        check(query_all(copy, patterns), expected_other);
+        IUTEST_ASSERT_EQ(lookups, idx.get_cache()->lookups());
+        check(query_all(idx, patterns), expected);
+    };
+
+    index_t constructed(idx);
+    check_copy(constructed);
+
+    index_t assigned;
+    assigned = idx;
+    check_copy(assigned);
+
+    index_t plain;
+    plain.set_cache(0);
+    index_t copy(plain);
+    IUTEST_ASSERT_TRUE(copy.get_cache() == nullptr);
+}
+
+IUTEST(BrIndexTest, SampleCacheCopy)
+{
+    std::string s1, s2;
+    {
+        std::mt19937 engine(61);
+        std::string dna;
+        for (ulint i = 0; i < 500; ++i) dna.push_back("ACGT"[engine()%4]);
+        for (ulint i = 0; i < 3; ++i)
+        {
+            std::string copy(dna);
+            for (ulint j = 0; j < 5; ++j) copy[engine()%copy.size()] = "ACGT"[engine()%4];
+            s1 += copy;
+        }
+        for (ulint i = 0; i < 1200; ++i) s2.push_back("ACGT"[engine()%4]);
+    }
+
+    std::vector<std::string> patterns;
+    {
+        std::mt19937 engine(67);
+        for (ulint i = 0; i < 20; ++i) patterns.push_back(s1.substr(engine()%(s1.size()-8), 4 + engine()%5));
+        for (ulint i = 0; i < 20; ++i) patterns.push_back(s2.substr(engine()%(s2.size()-8), 4 + engine()%5));
+    }
+
+    check_cache_copy<br_index<> >(s1, s2, patterns);
+    check_cache_copy<br_index_nplcp<> >(s1, s2, patterns);
+}
+
+IUTEST(BrIndexTest, DerivedReversedBWT)
+{
+    std::vector<std::string> texts;
+    texts.push_back("a");
+    texts.push_back("ba");
+    texts.push_back("aaaaaaaaaaaaaaaaaaaa");
+    texts.push_back("abcdabcdabcdabcdhello");
+    texts.push_back("mississippi");
+    {
+        std::mt19937 engine(11);
+        std::string dna;
+        for (ulint i = 0; i < 2000; ++i) dna.push_back("ACGT"[engine()%4]);
+        std::string rep;
+        for (ulint i = 0; i < 4; ++i)
+        {
+            std::string copy(dna);
+            for (ulint j = 0; j < 5; ++j) copy[engine()%copy.size()] = "ACGT"[engine()%4];
+            rep += copy;
+        }
+        texts.push_back(dna);
+        texts.push_back(rep);
+    }
+
+    for (auto const& s: texts)
+    {
+        br_index<> idx(s);
+        br_index<> idx_derived(s, true, true);
+
+        std::ostringstream out, out_derived;
+        idx.serialize(out);
+        idx_derived.serialize(out_derived);
+
+        IUTEST_ASSERT_EQ(idx.get_bwt(true), idx_derived.get_bwt(true));
+        IUTEST_ASSERT_EQ(out.str(), out_derived.str());
+    }
+}
+
+IUTEST(BrIndexTest, MemoryBudget)
+{
+    std::mt19937 engine(5);
+    std::string s;
+    for (ulint i = 0; i < 3000; ++i) s.push_back("ACGT"[engine()%4]);
+
+    br_index<> idx(s, false);
+
+    // a budget too small for anything: sequential pipelines and SE-SAIS
+    br_index<> idx_budget(s, false, false, build_config("test-tmp", 1));
+
+    std::ostringstream out, out_budget;
+    idx.serialize(out);
+    idx_budget.serialize(out_budget);
+
+    IUTEST_ASSERT_EQ(out.str(), out_budget.str());
+}
+
+IUTEST(BrIndexTest, InMemory)
+{
+    std::vector<std::string> texts;
+    texts.push_back("a");
+    texts.push_back("mississippi");
+    {
+        std::mt19937 engine(11);
+        std::string dna;
+        for (ulint i = 0; i < 3000; ++i) dna.push_back("ACGT"[engine()%4]);
+        texts.push_back(dna);
+    }
+
+    // no cache file is written, so a missing directory does not matter
+    build_config bc("test-tmp/missing-dir/");
+    bc.in_memory = true;
+
+    for (auto const& s: texts)
+    {
+        br_index<> idx(s);
+        br_index<> idx_mem(s, true, false, bc);
+        br_index<> idx_mem_rev(s, false, true, bc);
+
+        std::ostringstream out, out_mem, out_mem_rev;
+        idx.serialize(out);
+        idx_mem.serialize(out_mem);
+        idx_mem_rev.serialize(out_mem_rev);
+
+        IUTEST_ASSERT_EQ(out.str(), out_mem.str());
+        IUTEST_ASSERT_EQ(out.str(), out_mem_rev.str());
+    }
+}
+
+IUTEST(BrIndexTest, MappedInput)
+{
+    std::string s;
+    {
+        std::mt19937 engine(17);
+        for (ulint i = 0; i < 3000; ++i) s.push_back("ACGT"[engine()%4]);
+    }
+    {
+        std::ofstream fs("test-tmp/mapped.txt");
+        fs << s;
+    }
+    mapped_text text("test-tmp/mapped.txt");
+
+    build_config bc_mem("test-tmp/");
+    bc_mem.in_memory = true;
+    build_config bc_par("test-tmp/");
+    bc_par.threads = 2;
+
+    br_index<> idx(s);
+    br_index<> idx_mapped(text);
+    br_index<> idx_mapped_mem(text, false, false, bc_mem);
+    br_index<> idx_mapped_par(text, true, false, bc_par);
+
+    std::ostringstream out, out_mapped, out_mapped_mem, out_mapped_par;
+    idx.serialize(out);
+    idx_mapped.serialize(out_mapped);
+    idx_mapped_mem.serialize(out_mapped_mem);
+    idx_mapped_par.serialize(out_mapped_par);
+
+    IUTEST_ASSERT_EQ(out.str(), out_mapped.str());
+    IUTEST_ASSERT_EQ(out.str(), out_mapped_mem.str());
+    IUTEST_ASSERT_EQ(out.str(), out_mapped_par.str());
+}
+
+IUTEST(BrIndexTest, BuildProfile)
+{
+    std::string s("abcdabcdabcdabcdhellohellohello");
+
+    build_profile profile;
+    build_config bc;
+    bc.profile = &profile;
+
+    br_index<> idx(s, true, false, bc);
+
+    // remap, forward & reverse SA/sufsort, RLE, predecessor/Phi, PLCP
+    IUTEST_ASSERT_EQ(8, profile.size());
+
+    // the profile does not change the index
+    br_index<> idx_plain(s);
+    std::ostringstream out, out_plain;
+    idx.serialize(out);
+    idx_plain.serialize(out_plain);
+    IUTEST_ASSERT_EQ(out.str(), out_plain.str());
+
+    ulint total = 0;
+    for (auto const& c: idx.space_breakdown()) total += c.second;
+    IUTEST_ASSERT_EQ(idx.get_space(), total);
+
+    profile.set("n", idx.text_size());
+    profile.set_space(idx.space_breakdown());
+
+    std::ostringstream json;
+    profile.to_json(json);
+    std::string js = json.str();
+
+    IUTEST_ASSERT_NE(std::string::npos, js.find("\"name\": \"forward sufsort\""));
+    IUTEST_ASSERT_NE(std::string::npos, js.find("\"name\": \"PLCP\""));
+    for (std::string key: {"thread_cpu_s", "process_peak_rss_bytes", "peak_rss_growth_bytes", "syscall_read_bytes", "syscall_written_bytes"})
+        IUTEST_ASSERT_NE(std::string::npos, js.find("\"" + key + "\": "));
+    IUTEST_ASSERT_NE(std::string::npos, js.find("\"process_cpu_s\": "));
+    IUTEST_ASSERT_NE(std::string::npos, js.find("\"n\": " + std::to_string(s.size())));
+    IUTEST_ASSERT_NE(std::string::npos, js.find("\"total\": " + std::to_string(total)));
+}
+
+/*
+ * the CPU time of a phase is that of its own thread, not of phases running
+ * concurrently in other threads
+ */
+IUTEST(BrIndexTest, BuildProfileThreads)
+{
+    build_profile profile;
+
+    std::thread busy([&profile]()
+    {
+        build_profile::phase ph(&profile, "busy");
+        volatile ulint x = 0;
+        auto begin = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(300)) x = x + 1;
+    });
+    {
+        build_profile::phase ph(&profile, "idle");
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    }
+    busy.join();
+
+    std::ostringstream json;
+    profile.to_json(json);
+    std::string js = json.str();
+
+    auto cpu_of = [&js](std::string const& name)
+    {
+        ulint pos = js.find("\"thread_cpu_s\": ", js.find("\"name\": \"" + name + "\""));
+        return std::stod(js.substr(pos + std::string("\"thread_cpu_s\": ").size()));
+    };
+    IUTEST_ASSERT_LT(cpu_of("idle"), 0.1);
+    IUTEST_ASSERT_GT(cpu_of("busy"), 0.15);
+}
+
+/*
+ * writes the BWT of s$ and its SA samples to basename.bwt/.ssa/.esa as Big-BWT
+ * does: a sample at the start (.ssa) and at the end (.esa) of every run, each
+ * SA value stored as (SA + 1) mod n
+ */
+void write_external_bwt(std::string const& s, std::string const& basename)
+{
+    std::string t = s + '\0';
+    ulint n = t.size();
+    std::vector<ulint> sa(n);
+    for (ulint i = 0; i < n; ++i) sa[i] = i;
+    std::sort(sa.begin(), sa.end(), [&](ulint a, ulint b)
+    {
+        return t.compare(a, std::string::npos, t, b, std::string::npos) < 0;
+    });
+
+    std::ofstream bwt(basename + ".bwt", std::ios::binary);
+    std::ofstream ssa(basename + ".ssa", std::ios::binary);
+    std::ofstream esa(basename + ".esa", std::ios::binary);
+
+    auto write = [](std::ofstream& out, ulint x) { out.write((char*)&x, 5); };
+    auto bwt_at = [&](ulint i) { return t[(sa[i] + n - 1) % n]; };
+
+    for (ulint i = 0; i < n; ++i)
+    {
+        bwt.put(bwt_at(i));
+        if (i == 0 || bwt_at(i) != bwt_at(i - 1))
+        {
+            write(ssa, i);
+            write(ssa, (sa[i] + 1) % n);
+        }
+        if (i == n - 1 || bwt_at(i) != bwt_at(i + 1))
+        {
+            write(esa, i);
+            write(esa, (sa[i] + 1) % n);
+        }
+    }
+}
+
+IUTEST(BrIndexTest, FromExternalBwt)
+{
+    std::vector<std::string> texts;
+    texts.push_back("a");
+    texts.push_back("mississippi");
+    texts.push_back("abcdabcdabcdabcdhello");
+    {
+        std::mt19937 engine(13);
+        std::string dna;
+        for (ulint i = 0; i < 3000; ++i) dna.push_back("ACGT"[engine()%4]);
+        texts.push_back(dna);
+    }
+
+    for (auto const& s: texts)
+    {
+        std::string r(s.rbegin(), s.rend());
+        write_external_bwt(s, "test-tmp/external");
+        write_external_bwt(r, "test-tmp/external.rev");
+
+        br_index<> idx(s);
+        br_index<> idx_ext(external_bwt("test-tmp/external", "test-tmp/external.rev"));
+        br_index<> idx_ext_derived(external_bwt("test-tmp/external"));
+
+        std::ostringstream out, out_ext, out_ext_derived;
+        idx.serialize(out);
+        idx_ext.serialize(out_ext);
+        idx_ext_derived.serialize(out_ext_derived);
+
+        IUTEST_ASSERT_EQ(out.str(), out_ext.str());
+        IUTEST_ASSERT_EQ(out.str(), out_ext_derived.str());
+    }
+}
+
+IUTEST(BrIndexTest, MergedIndex)
+{
+    std::vector<std::string> texts;
+    texts.push_back("a");
+    texts.push_back("mississippi");
+    texts.push_back("abcdabcdabcdabcdhello");
+    {
+        std::mt19937 engine(13);
+        std::string dna;
+        for (ulint i = 0; i < 1500; ++i) dna.push_back("ACGT"[engine()%4]);
+        for (ulint i = 0; i < 3; ++i)
+        {
+            std::string copy(dna);
+            for (ulint j = 0; j < 5; ++j) copy[engine()%copy.size()] = "ACGT"[engine()%4];
+            texts.push_back(copy);
+        }
+    }
+
+    // the separator is the smallest character, as in the index of the concatenation
+    for (ulint i = 0; i < texts.size(); ++i)
+    {
+        for (ulint j = 0; j < texts.size(); ++j)
+        {
+            br_index<> idx1(texts[i]), idx2(texts[j]);
+            uchar sep = br_index<>::merge_separator(idx1, idx2);
+            IUTEST_ASSERT_EQ(2, sep);
+
+            br_index<> merged(idx1, idx2, sep);
+            br_index<> idx(texts[i] + (char)sep + texts[j]);
+
+            std::ostringstream out, out_merged;
+            idx.serialize(out);
+            merged.serialize(out_merged);
+
+            IUTEST_ASSERT_EQ(idx.get_bwt(), merged.get_bwt());
+            IUTEST_ASSERT_EQ(idx.get_bwt(true), merged.get_bwt(true));
+            IUTEST_ASSERT_EQ(out.str(), out_merged.str());
+        }
+    }
+
+    // locate on a merged index finds the occurrences in the merged text
+    auto check_locate = [](br_index<> const& merged, std::string const& text, ulint seed)
+    {
+        IUTEST_ASSERT_EQ(text.size(), merged.text_size());
+
+        std::mt19937 engine(seed);
+        for (ulint t = 0; t < 50; ++t)
+        {
+            ulint m = 1 + engine()%20;
+            ulint pos = engine()%(text.size()-m);
+            std::string pattern = text.substr(pos, m);
+
+            std::vector<ulint> expected;
+            for (ulint p = text.find(pattern); p != std::string::npos; p = text.find(pattern, p+1))
+                expected.push_back(p);
+
+            auto res = merged.locate(pattern);
+            std::sort(res.begin(), res.end());
+            IUTEST_ASSERT_EQ(expected.size(), res.size());
+            for (ulint k = 0; k < res.size(); ++k) IUTEST_ASSERT_EQ(expected[k], res[k]);
+
+            res = merged.locate(pattern, true);
+            std::sort(res.begin(), res.end());
+            IUTEST_ASSERT_EQ(expected.size(), res.size());
+            for (ulint k = 0; k < res.size(); ++k) IUTEST_ASSERT_EQ(expected[k], res[k]);
+        }
+    };
+
+    // incremental merges into an already merged index: each takes a new
+    // separator, smaller than the previous ones
+    {
+        br_index<> merged(texts[3]);
+        std::string text(texts[3]);
+        for (ulint i = 0; i < 12; ++i)
+        {
+            std::string piece = texts[3 + i%3].substr(100 * i, 200);
+            br_index<> idx2(piece);
+            uchar sep = br_index<>::merge_separator(merged, idx2);
+            IUTEST_ASSERT_EQ(2 + i, sep);
+
+            br_index<> next(merged, idx2, sep);
+            merged = next;
+            text += (char)sep + piece;
+        }
+        check_locate(merged, text, 17);
+    }
+
+    // pairwise merges: indexes of the same level share their separator
+    {
+        std::vector<br_index<> > level;
+        std::vector<std::string> level_text;
+        for (ulint i = 0; i < 8; ++i)
+        {
+            level_text.push_back(texts[3 + i%3].substr(150 * i, 300));
+            level.push_back(br_index<>(level_text.back()));
+        }
+
+        for (uchar expected_sep = 2; level.size() > 1; ++expected_sep)
+        {
+            std::vector<br_index<> > next;
+            std::vector<std::string> next_text;
+            for (ulint i = 0; i < level.size(); i += 2)
+            {
+                uchar sep = br_index<>::merge_separator(level[i], level[i+1]);
+                IUTEST_ASSERT_EQ(expected_sep, sep);
+
+                next.push_back(br_index<>(level[i], level[i+1], sep));
+                next_text.push_back(level_text[i] + (char)sep + level_text[i+1]);
+            }
+            level.swap(next);
+            level_text.swap(next_text);
+        }
+        check_locate(level[0], level_text[0], 19);
+    }
+}
+
 IUTEST(BrIndexNaiveTest, BasicLocate)
 {
     std::string s("aaaaaaaaaaaaaaaaaaaa");
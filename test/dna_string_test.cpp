@@ -0,0 +1,92 @@
+#include "iutest.hpp"
+
+#include <vector>
+#include <fstream>
+#include <random>
+#include "../src/dna_string.hpp"
+
+using namespace bri;
+
+IUTEST(DnaStringTest,AllAText) {
+    std::string s;
+    for (int i = 0; i < 1000; ++i) s += 'A';
+    dna_string ds(s);
+
+    IUTEST_ASSERT_EQ(ds.size(),1000);
+    for (int i = 0; i < 1000; ++i)
+    {
+        IUTEST_ASSERT_EQ(ds[i],'A');
+        IUTEST_ASSERT_EQ(ds.rank(i,'A'),i);
+        IUTEST_ASSERT_EQ(ds.rank(i,'C'),0);
+        IUTEST_ASSERT_EQ(ds.select(i,'A'),i);
+    }
+    IUTEST_ASSERT_EQ(ds.rank(1000,'A'),1000);
+}
+
+IUTEST(DnaStringTest,RandomText) {
+    std::string s;
+    {
+        std::mt19937 engine(7);
+        std::string alphabet = std::string(1,(char)1) + "ACGTN";
+        for (int i = 0; i < 5000; ++i) s.push_back(alphabet[engine()%alphabet.size()]);
+    }
+    dna_string ds(s);
+
+    for (uchar c: std::string("\1ACGTNX"))
+    {
+        ulint count = 0;
+        for (ulint i = 0; i < s.size(); ++i)
+        {
+            IUTEST_ASSERT_EQ(ds.rank(i,c),count);
+            if ((uchar)s[i] == c)
+            {
+                IUTEST_ASSERT_EQ(ds.select(count,c),i);
+                count++;
+            }
+        }
+        IUTEST_ASSERT_EQ(ds.rank(s.size(),c),count);
+    }
+    for (ulint i = 0; i < s.size(); ++i) IUTEST_ASSERT_EQ(ds[i],(uchar)s[i]);
+}
+
+IUTEST(DnaStringTest,EightSymbols) {
+    std::string s;
+    for (unsigned long i = 0; i < 8 * 100; ++i)
+        s.push_back("ACGTNRYK"[i%8]);
+    dna_string ds(s);
+
+    for (uchar c: std::string("ACGTNRYK"))
+    {
+        IUTEST_ASSERT_EQ(100,ds.rank(800,c));
+        IUTEST_ASSERT_EQ(s.find(c),ds.select(0,c));
+        IUTEST_ASSERT_EQ(s.rfind(c),ds.select(99,c));
+    }
+}
+
+IUTEST(DnaStringTest,SaveLoad) {
+    std::string s;
+    {
+        std::mt19937 engine(3);
+        for (int i = 0; i < 1000; ++i) s.push_back("ACGT"[engine()%4]);
+    }
+    auto ds = dna_string(s);
+
+    std::ofstream ofs("test-tmp/dna_string_test.tmp");
+    unsigned long w_bytes = ds.serialize(ofs);
+    std::cout << w_bytes << " bytes" << std::endl;
+    ofs.close();
+
+    dna_string loaded;
+    std::ifstream ifs("test-tmp/dna_string_test.tmp");
+    loaded.load(ifs);
+    ifs.close();
+
+    IUTEST_ASSERT_EQ(loaded.size(),ds.size());
+    for (int i = 0; i < 1000; ++i)
+    {
+        IUTEST_ASSERT_EQ(loaded[i],ds[i]);
+        IUTEST_ASSERT_EQ(loaded.rank(i,'G'),ds.rank(i,'G'));
+    }
+    for (ulint i = 0; i < ds.rank(1000,'T'); ++i)
+        IUTEST_ASSERT_EQ(loaded.select(i,'T'),ds.select(i,'T'));
+}
@@ -0,0 +1,92 @@
+#include "iutest.hpp"
+#include <vector>
+#include <fstream>
+#include <string>
+
+#include "../src/br_index.hpp"
+#include "../src/documents.hpp"
+
+using namespace bri;
+
+IUTEST(DocumentsTest, Boundaries)
+{
+    std::vector<std::string> docs, names;
+    docs.push_back("abcab");
+    docs.push_back("b");
+    docs.push_back("cab");
+    names.push_back("x");
+    names.push_back("y");
+    names.push_back("z");
+
+    std::string text;
+    documents<> d(docs, names, text);
+
+    IUTEST_ASSERT_EQ(3, d.size());
+    IUTEST_ASSERT_EQ(2, d.separator());
+    IUTEST_ASSERT_EQ(11, text.size());
+    IUTEST_ASSERT_EQ(11, d.text_size());
+    IUTEST_ASSERT_EQ(std::string("abcab\2b\2cab"), text);
+
+    IUTEST_ASSERT_TRUE(range_t(0,0) == d.document_of(0));
+    IUTEST_ASSERT_TRUE(range_t(0,4) == d.document_of(4));
+    IUTEST_ASSERT_TRUE(range_t(1,0) == d.document_of(6));
+    IUTEST_ASSERT_TRUE(range_t(2,0) == d.document_of(8));
+    IUTEST_ASSERT_TRUE(range_t(2,2) == d.document_of(10));
+
+    IUTEST_ASSERT_TRUE(d.inside(0,5));
+    IUTEST_ASSERT_FALSE(d.inside(3,4));
+    IUTEST_ASSERT_TRUE(d.inside(8,3));
+
+    std::ofstream ofs("test-tmp/documents_test.tmp");
+    d.serialize(ofs);
+    ofs.close();
+
+    documents<> d2;
+    std::ifstream ifs("test-tmp/documents_test.tmp");
+    d2.load(ifs);
+    ifs.close();
+
+    IUTEST_ASSERT_EQ(3, d2.size());
+    IUTEST_ASSERT_EQ(d.separator(), d2.separator());
+    IUTEST_ASSERT_EQ(std::string("z"), d2.name(2));
+    for (ulint i = 0; i < text.size(); ++i)
+        IUTEST_ASSERT_TRUE(d.document_of(i) == d2.document_of(i));
+}
+
+IUTEST(DocumentsTest, Locate)
+{
+    std::vector<std::string> docs, names;
+    docs.push_back("ACGTACGTAC");
+    docs.push_back("GTTTACG");
+    docs.push_back("TACGT");
+    for (ulint i = 0; i < docs.size(); ++i) names.push_back(std::to_string(i));
+
+    std::string text;
+    documents<> d(docs, names, text);
+    br_index<> idx(text);
+
+    // "ACGT" also occurs across documents 0 & 1 in the plain concatenation "...ACGTTTACG..."
+    auto occs = d.locate(idx, "ACGT");
+    std::sort(occs.begin(), occs.end());
+    IUTEST_ASSERT_EQ(3, occs.size());
+    IUTEST_ASSERT_TRUE(range_t(0,0) == occs[0]);
+    IUTEST_ASSERT_TRUE(range_t(0,4) == occs[1]);
+    IUTEST_ASSERT_TRUE(range_t(2,1) == occs[2]);
+
+    // matches never cross a boundary
+    IUTEST_ASSERT_EQ(0, d.locate(idx, "ACGTT").size());
+    std::string crossing("C");
+    crossing.push_back(d.separator());
+    crossing.push_back('G');
+    IUTEST_ASSERT_EQ(0, d.locate(idx, crossing).size());
+
+    // occurrences with mismatches may cover a separator
+    auto samples = idx.search_with_mismatch("ACGTT", 1);
+    auto raw = idx.locate_samples(samples);
+    auto resolved = d.resolve(raw, 5);
+    for (auto o: resolved)
+    {
+        IUTEST_ASSERT_LE(o.second + 5, docs[o.first].size());
+    }
+    IUTEST_ASSERT_LT(resolved.size(), raw.size());
+}
@@ -0,0 +1,79 @@
+#include "iutest.hpp"
+#include <vector>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "../src/br_index.hpp"
+#include "../src/parallel_sa.hpp"
+
+using namespace bri;
+
+// suffix array by comparing the suffixes
+std::vector<ulint> naive_sa(std::string const& text)
+{
+    std::vector<ulint> sa(text.size());
+    for (ulint i = 0; i < sa.size(); ++i) sa[i] = i;
+    std::sort(sa.begin(), sa.end(), [&](ulint a, ulint b)
+    {
+        return text.compare(a, std::string::npos, text, b, std::string::npos) < 0;
+    });
+    return sa;
+}
+
+IUTEST(ParallelSaTest, SuffixArray)
+{
+    std::vector<std::string> texts;
+    texts.push_back("");
+    texts.push_back("a");
+    texts.push_back("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa");
+    texts.push_back("abcdabcdabcdabcdhello");
+    texts.push_back("mississippi");
+    {
+        std::mt19937 engine(17);
+        std::string dna;
+        for (ulint i = 0; i < 2000; ++i) dna.push_back("ACGT"[engine()%4]);
+        std::string rep;
+        for (ulint i = 0; i < 4; ++i)
+        {
+            std::string copy(dna);
+            for (ulint j = 0; j < 3; ++j) copy[engine()%copy.size()] = "ACGT"[engine()%4];
+            rep += copy;
+        }
+        texts.push_back(dna);
+        texts.push_back(rep);
+    }
+
+    for (auto s: texts)
+    {
+        s.push_back(0);
+        std::vector<ulint> expected = naive_sa(s);
+
+        for (ulint threads = 1; threads <= 4; ++threads)
+        {
+            sdsl::int_vector<> sa = parallel_suffix_array(s, threads);
+            IUTEST_ASSERT_EQ(expected.size(), sa.size());
+            for (ulint i = 0; i < sa.size(); ++i) IUTEST_ASSERT_EQ(expected[i], sa[i]);
+        }
+    }
+}
+
+IUTEST(ParallelSaTest, SameIndex)
+{
+    std::mt19937 engine(19);
+    std::string s;
+    for (ulint i = 0; i < 3000; ++i) s.push_back("ACGT"[engine()%4]);
+    s += s.substr(100, 1500);
+
+    build_config bc;
+    bc.threads = 3;
+
+    br_index<> idx(s);
+    br_index<> idx_parallel(s, true, false, bc);
+
+    std::ostringstream out, out_parallel;
+    idx.serialize(out);
+    idx_parallel.serialize(out_parallel);
+
+    IUTEST_ASSERT_EQ(out.str(), out_parallel.str());
+}
@@ -224,6 +224,98 @@ IUTEST(PermutedLcpTest, A1000000TextOperations)
 
 
 
+IUTEST(PermutedLcpTest, IrreducibleConstruction)
+{
+    std::string s("abcdabcdabcdabcdhelloabcdhello");
+
+    cache_config cc;
+    int_vector<8> text(s.size());
+    for (ulint i = 0; i < s.size(); ++i)
+        text[i] = (uchar)s[i];
+    append_zero_symbol(text);
+
+    store_to_cache(text, conf::KEY_TEXT, cc);
+    construct_config::byte_algo_sa = SE_SAIS;
+
+    construct_sa<8>(cc);
+    construct_isa(cc);
+
+    permuted_lcp<> plcp(cc);
+
+    int_vector<> sa;
+    load_from_file(sa, cache_file_name(conf::KEY_SA, cc));
+
+    // PLCP at SA values of BWT run beginnings
+    std::vector<range_t> irreducible;
+    for (ulint k = 0; k < sa.size(); ++k)
+    {
+        ulint prev = k == 0 ? 0 : text[(sa[k-1]+sa.size()-1)%sa.size()];
+        if (k == 0 || text[(sa[k]+sa.size()-1)%sa.size()] != prev)
+            irreducible.push_back({sa[k], plcp[sa[k]]});
+    }
+    std::sort(irreducible.begin(), irreducible.end());
+
+    permuted_lcp<> plcp_ir(sa.size(), irreducible);
+    IUTEST_ASSERT_EQ(plcp.size(),plcp_ir.size());
+    for (ulint i = 0; i < plcp.size(); ++i)
+        IUTEST_ASSERT_EQ(plcp[i],plcp_ir[i]);
+    IUTEST_ASSERT_EQ(plcp.get_space(),plcp_ir.get_space());
+
+    remove(cache_file_name(conf::KEY_TEXT, cc));
+    remove(cache_file_name(conf::KEY_SA, cc));
+    remove(cache_file_name(conf::KEY_ISA, cc));
+}
+
+
+IUTEST(PermutedLcpTest, SampleConstruction)
+{
+    std::vector<std::string> texts;
+    texts.push_back("a");
+    texts.push_back("aaaaabbbbbaaaaa");
+    texts.push_back("abcdabcdabcdabcdhelloabcdhello");
+    texts.push_back("mississippi$mississippi");
+
+    for (auto const& s: texts)
+    {
+        cache_config cc;
+        int_vector<8> text(s.size());
+        for (ulint i = 0; i < s.size(); ++i)
+            text[i] = (uchar)s[i];
+        append_zero_symbol(text);
+
+        store_to_cache(text, conf::KEY_TEXT, cc);
+        construct_config::byte_algo_sa = SE_SAIS;
+
+        construct_sa<8>(cc);
+        construct_isa(cc);
+
+        permuted_lcp<> plcp(cc);
+
+        int_vector<> sa;
+        load_from_file(sa, cache_file_name(conf::KEY_SA, cc));
+        ulint n = sa.size();
+
+        // SA[k]-1 at beginnings & ends of BWT runs
+        std::vector<ulint> samples_first, samples_last;
+        for (ulint k = 0; k < n; ++k)
+        {
+            auto bwt = [&](ulint x) { return text[(sa[x]+n-1)%n]; };
+            if (k == 0 || bwt(k) != bwt(k-1)) samples_first.push_back((sa[k]+n-1)%n);
+            if (k == n-1 || bwt(k) != bwt(k+1)) samples_last.push_back((sa[k]+n-1)%n);
+        }
+
+        permuted_lcp<> plcp_s(s, samples_first, samples_last);
+        IUTEST_ASSERT_EQ(plcp.size(),plcp_s.size());
+        for (ulint i = 0; i < plcp.size(); ++i)
+            IUTEST_ASSERT_EQ(plcp[i],plcp_s[i]);
+
+        remove(cache_file_name(conf::KEY_TEXT, cc));
+        remove(cache_file_name(conf::KEY_SA, cc));
+        remove(cache_file_name(conf::KEY_ISA, cc));
+    }
+}
+
+
 /* test using external textfile
 IUTEST(PermutedLcpTest, BigText)
 {
@@ -0,0 +1,149 @@
+#include "iutest.hpp"
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <random>
+
+#include "../src/br_index.hpp"
+#include "../src/prefix_free_parse.hpp"
+
+using namespace bri;
+
+// build br-index with PFP from s through a temporary file
+void build_pfp(br_index<>& idx, std::string const& s, pfp_config const& cfg)
+{
+    std::string path("test-tmp/prefix_free_parse_test.txt");
+    std::ofstream ofs(path);
+    ofs << s;
+    ofs.close();
+
+    idx = br_index<>(path, cfg);
+}
+
+std::string serialized(br_index<>& idx)
+{
+    std::ostringstream oss;
+    idx.serialize(oss);
+    return oss.str();
+}
+
+IUTEST(PrefixFreeParseTest, BwtAndSamples)
+{
+    std::string s("abcdabcdabcdabcdhello");
+    std::vector<uchar> remap(256,0);
+    for (ulint c = 'a'; c <= 'z'; ++c) remap[c] = c - 'a' + 2;
+
+    prefix_free_parse pfp(s, remap, false, pfp_config(2,3));
+    bwt_runs runs(s.size()+1);
+    pfp.bwt(runs);
+
+    IUTEST_ASSERT_EQ(s.size()+1,runs.size);
+    IUTEST_ASSERT_EQ(runs.heads.size(),runs.number_of_runs());
+    IUTEST_ASSERT_EQ(runs.heads.size(),runs.samples_first.size());
+    IUTEST_ASSERT_EQ(runs.heads.size(),runs.samples_last.size());
+
+    br_index<> idx(s);
+    std::string bwt_s;
+    for (ulint i = 0; i < runs.heads.size(); ++i)
+        bwt_s.append(runs.lengths[i], (uchar)runs.heads[i] == 1 ? '\1' : runs.heads[i] - 2 + 'a');
+
+    std::string expected = idx.get_bwt();
+    for (auto& c: expected) if (c == 0) c = '\1';
+    IUTEST_ASSERT_EQ(expected,bwt_s);
+}
+
+IUTEST(PrefixFreeParseTest, InMemoryParseSort)
+{
+    std::mt19937 engine(3);
+    std::string s;
+    for (ulint i = 0; i < 2000; ++i) s.push_back("ACGT"[engine()%4]);
+
+    std::vector<uchar> remap(256,0);
+    remap['A'] = 2; remap['C'] = 3; remap['G'] = 4; remap['T'] = 5;
+
+    prefix_free_parse pfp(s, remap, false, pfp_config(4,7));
+    bwt_runs runs(s.size()+1);
+    bwt_runs runs_mem(s.size()+1);
+    pfp.bwt(runs, sdsl::cache_config(true, "test-tmp"));
+    pfp.bwt(runs_mem, sdsl::cache_config(true, "test-tmp/missing-dir"), true);
+
+    IUTEST_ASSERT_EQ(runs.heads, runs_mem.heads);
+    IUTEST_ASSERT_TRUE(runs.lengths == runs_mem.lengths);
+    IUTEST_ASSERT_TRUE(runs.samples_first == runs_mem.samples_first);
+    IUTEST_ASSERT_TRUE(runs.samples_last == runs_mem.samples_last);
+}
+
+IUTEST(PrefixFreeParseTest, SameIndexAsSuffixSorting)
+{
+    std::vector<std::string> texts;
+    texts.push_back("a");
+    texts.push_back("ab");
+    texts.push_back("aaaaaaaaaaaaaaaaaaaa");
+    texts.push_back("abcdabcdabcdabcdhello");
+    texts.push_back("mississippi");
+    {
+        std::mt19937 engine(7);
+        std::string dna;
+        for (ulint i = 0; i < 3000; ++i) dna.push_back("ACGT"[engine()%4]);
+        // repetitive collection
+        std::string rep;
+        for (ulint i = 0; i < 5; ++i)
+        {
+            std::string copy(dna);
+            for (ulint j = 0; j < 10; ++j) copy[engine()%copy.size()] = "ACGT"[engine()%4];
+            rep += copy;
+        }
+        texts.push_back(dna);
+        texts.push_back(rep);
+    }
+
+    std::vector<pfp_config> cfgs;
+    cfgs.push_back(pfp_config());
+    cfgs.push_back(pfp_config(1,2));
+    cfgs.push_back(pfp_config(4,7));
+    cfgs.push_back(pfp_config(30,1000000));
+
+    for (auto const& s: texts)
+    {
+        br_index<> idx(s);
+        std::string expected = serialized(idx);
+
+        for (auto const& cfg: cfgs)
+        {
+            br_index<> idx_pfp;
+            build_pfp(idx_pfp, s, cfg);
+
+            IUTEST_ASSERT_EQ(idx.get_bwt(),idx_pfp.get_bwt());
+            IUTEST_ASSERT_EQ(idx.get_bwt(true),idx_pfp.get_bwt(true));
+            IUTEST_ASSERT_EQ(expected,serialized(idx_pfp));
+        }
+    }
+}
+
+IUTEST(PrefixFreeParseTest, Locate)
+{
+    std::string s("abcdabcdabcdabcdhello");
+    br_index<> idx;
+    build_pfp(idx, s, pfp_config(2,3));
+
+    auto vec = idx.locate("abcd");
+    std::sort(vec.begin(),vec.end());
+    IUTEST_ASSERT_EQ(4,vec.size());
+    IUTEST_ASSERT_EQ(0,vec[0]);
+    IUTEST_ASSERT_EQ(4,vec[1]);
+    IUTEST_ASSERT_EQ(8,vec[2]);
+    IUTEST_ASSERT_EQ(12,vec[3]);
+    vec = idx.locate("abcd",false);
+    std::sort(vec.begin(),vec.end());
+    IUTEST_ASSERT_EQ(4,vec.size());
+    IUTEST_ASSERT_EQ(0,vec[0]);
+    IUTEST_ASSERT_EQ(4,vec[1]);
+    IUTEST_ASSERT_EQ(8,vec[2]);
+    IUTEST_ASSERT_EQ(12,vec[3]);
+
+    IUTEST_EXPECT_EQ(21,idx.Phi(0));
+    IUTEST_EXPECT_EQ(0,idx.Phi(4));
+    IUTEST_EXPECT_EQ(0,idx.PhiI(21));
+    IUTEST_EXPECT_EQ(4,idx.PhiI(0));
+}
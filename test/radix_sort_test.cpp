@@ -0,0 +1,82 @@
+#include "iutest.hpp"
+#include <vector>
+#include <random>
+
+#include "../src/radix_sort.hpp"
+#include "../src/sparse_sd_vector.hpp"
+
+using namespace bri;
+
+IUTEST(RadixSortTest, Keys)
+{
+    std::mt19937_64 engine(23);
+
+    for (ulint bits: {1, 11, 30, 64})
+    {
+        std::vector<ulint> keys(300000);
+        for (auto& k: keys) k = bits == 64 ? engine() : engine() % (1ULL << bits);
+
+        std::vector<ulint> expected(keys);
+        std::sort(expected.begin(), expected.end());
+
+        for (ulint threads = 1; threads <= 4; ++threads)
+        {
+            std::vector<ulint> v(keys);
+            radix_sort(v, bits, [](ulint k) { return k; }, threads);
+            IUTEST_ASSERT_TRUE(expected == v);
+        }
+    }
+}
+
+IUTEST(RadixSortTest, StablePairs)
+{
+    std::mt19937_64 engine(29);
+
+    std::vector<range_t> pairs(200000);
+    for (ulint i = 0; i < pairs.size(); ++i) pairs[i] = {engine() % 1000, i};
+
+    std::vector<range_t> expected(pairs);
+    std::stable_sort(expected.begin(), expected.end(),
+        [](range_t const& a, range_t const& b) { return a.first < b.first; });
+
+    for (ulint threads = 1; threads <= 3; ++threads)
+    {
+        std::vector<range_t> v(pairs);
+        radix_sort(v, 10, [](range_t const& p) { return p.first; }, threads);
+        IUTEST_ASSERT_TRUE(expected == v);
+    }
+}
+
+IUTEST(RadixSortTest, Predecessor)
+{
+    std::mt19937_64 engine(31);
+
+    // distinct text positions in [0, n) of the samples of r runs
+    ulint n = 1000000, r = 50000;
+    std::vector<ulint> positions;
+    for (ulint i = 0; i < n; ++i) if (engine() % (n / r) == 0) positions.push_back(i);
+    std::shuffle(positions.begin(), positions.end(), engine);
+
+    std::vector<range_t> samples;
+    for (ulint j = 0; j < positions.size(); ++j) samples.push_back({positions[j], j});
+
+    for (ulint threads: {1, 3})
+    {
+        std::vector<range_t> v(samples);
+        sparse_sd_vector pred;
+        sdsl::int_vector<> to_run(v.size(), 0, bitsize(v.size()));
+        build_predecessor(v, n, pred, to_run, threads);
+
+        IUTEST_ASSERT_EQ(0, v.size());
+        IUTEST_ASSERT_EQ(n, pred.size());
+        IUTEST_ASSERT_EQ(samples.size(), pred.rank(n));
+
+        std::vector<range_t> expected(samples);
+        std::sort(expected.begin(), expected.end());
+        for (ulint k = 0; k < expected.size(); ++k)
+        {
+            IUTEST_ASSERT_EQ(expected[k].first, pred.select(k));
+            IUTEST_ASSERT_EQ(expected[k].second, to_run[k]);
+        }
+    }
+}
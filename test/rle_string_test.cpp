@@ -1,6 +1,7 @@
 #include "iutest.hpp"
 #include <vector>
 #include <fstream>
+#include <random>
 #include <string>
 
 #include "../src/rle_string.hpp"
@@ -266,4 +267,194 @@ IUTEST(RleStringTest, TwoCharTextOperations)
 
     }
 
-}
\ No newline at end of file
+}
+
+IUTEST(RleStringTest, RankLessThan)
+{
+    std::mt19937 engine(5);
+
+    for (ulint sigma: {1, 5, 200, 255})
+    {
+        // runs of random lengths over the characters 1..sigma
+        std::string s;
+        for (ulint k = 0; k < 300; ++k)
+        {
+            uchar c = 1 + engine() % sigma;
+            ulint len = 1 + engine() % 5;
+            for (ulint j = 0; j < len; ++j) s.push_back(c);
+        }
+        rle_string<> rltmp(s);
+
+        std::ofstream ofs("test-tmp/rle_string_test.tmp");
+        rltmp.serialize(ofs);
+        ofs.close();
+
+        rle_string<> rl;
+        std::ifstream ifs("test-tmp/rle_string_test.tmp");
+        rl.load(ifs);
+        ifs.close();
+
+        rle_string<> rlcopy;
+        rlcopy = rltmp;
+
+        // with the wavelet matrix on the run heads
+        rle_string_sd_wm wmtmp(s);
+
+        std::ofstream ofs_wm("test-tmp/rle_string_test.tmp");
+        wmtmp.serialize(ofs_wm);
+        ofs_wm.close();
+
+        rle_string_sd_wm wm;
+        std::ifstream ifs_wm("test-tmp/rle_string_test.tmp");
+        wm.load(ifs_wm);
+        ifs_wm.close();
+
+        IUTEST_ASSERT_EQ(wmtmp.get_space(), wmtmp.print_space());
+        IUTEST_ASSERT_GT(wmtmp.get_space(), rltmp.get_space());
+
+        for (ulint c = 1; c < 256; c += (sigma < 10 ? 1 : 7))
+        {
+            ulint naive = 0;
+            for (ulint i = 0; i <= s.size(); ++i)
+            {
+                IUTEST_ASSERT_EQ(naive, rltmp.rank_less_than(i,(uchar)c));
+                IUTEST_ASSERT_EQ(naive, rl.rank_less_than(i,(uchar)c));
+                IUTEST_ASSERT_EQ(naive, rlcopy.rank_less_than(i,(uchar)c));
+                IUTEST_ASSERT_EQ(naive, wm.rank_less_than(i,(uchar)c));
+                if (i < s.size() && (uchar)s[i] < c) naive++;
+            }
+        }
+    }
+}
+
+IUTEST(RleStringTest, RankPair)
+{
+    std::mt19937 engine(7);
+
+    for (ulint B: {1, 2, 8})
+    {
+        std::string s;
+        for (ulint k = 0; k < 500; ++k)
+        {
+            uchar c = 'a' + engine() % 4;
+            ulint len = 1 + engine() % 6;
+            for (ulint j = 0; j < len; ++j) s.push_back(c);
+        }
+        rle_string<> rl(s, B);
+
+        for (ulint t = 0; t < 3000; ++t)
+        {
+            ulint i = engine() % (s.size() + 1);
+            // mostly narrow ranges, like deep in a search
+            ulint j = t % 2 ? std::min<ulint>(s.size(), i + engine() % 8) : i + engine() % (s.size() + 1 - i);
+            uchar c = 'a' + engine() % 5;
+
+            auto rk = rl.rank_pair(i, j, c);
+            IUTEST_ASSERT_EQ(rl.rank(i, c), rk.first);
+            IUTEST_ASSERT_EQ(rl.rank(j, c), rk.second);
+        }
+    }
+}
+
+IUTEST(RleStringTest, LastRunOf)
+{
+    std::mt19937 engine(9);
+
+    for (ulint B: {1, 2, 8})
+    {
+        std::string s;
+        for (ulint k = 0; k < 400; ++k)
+        {
+            uchar c = 'a' + engine() % 4;
+            ulint len = 1 + engine() % 6;
+            for (ulint j = 0; j < len; ++j) s.push_back(c);
+        }
+        rle_string<> rl(s, B);
+
+        // run number of each position
+        std::vector<ulint> run_of(s.size());
+        for (ulint i = 0, j = 0; i < s.size(); ++i)
+        {
+            if (i > 0 && s[i] != s[i-1]) j++;
+            run_of[i] = j;
+        }
+
+        for (ulint i = 0; i < s.size(); ++i)
+        {
+            for (uchar c = 'a'; c <= 'd'; ++c)
+            {
+                // the last c in s[0..i]
+                ulint p = i + 1;
+                while (p > 0 && (uchar)s[p-1] != c) --p;
+                if (p == 0) continue;
+
+                auto last = rl.last_run_of(i, c);
+                IUTEST_ASSERT_EQ(run_of[p-1], last.first);
+                IUTEST_ASSERT_EQ((uchar)s[i] == c, last.second);
+            }
+        }
+    }
+}
+
+IUTEST(RleStringTest, RankDirectory)
+{
+    std::mt19937 engine(11);
+
+    for (ulint B: {1, 2, 8})
+    {
+        std::string s;
+        for (ulint k = 0; k < 500; ++k)
+        {
+            uchar c = 'a' + engine() % 6;
+            ulint len = 1 + engine() % 6;
+            for (ulint j = 0; j < len; ++j) s.push_back(c);
+        }
+        rle_string<> rl(s, B);
+        rle_string_sd_dir rltmp(s, B);
+
+        std::ofstream ofs("test-tmp/rle_string_test.tmp");
+        rltmp.serialize(ofs);
+        ofs.close();
+
+        rle_string_sd_dir rldir;
+        std::ifstream ifs("test-tmp/rle_string_test.tmp");
+        rldir.load(ifs);
+        ifs.close();
+
+        IUTEST_ASSERT_EQ(rltmp.get_space(), rltmp.print_space());
+        IUTEST_ASSERT_GT(rltmp.get_space(), rl.get_space());
+
+        for (ulint i = 0; i <= s.size(); ++i)
+        {
+            for (uchar c = 'a'; c <= 'g'; ++c)
+            {
+                IUTEST_ASSERT_EQ(rl.rank(i, c), rltmp.rank(i, c));
+                IUTEST_ASSERT_EQ(rl.rank(i, c), rldir.rank(i, c));
+                IUTEST_ASSERT_EQ(rl.rank_less_than(i, c), rldir.rank_less_than(i, c));
+
+                // j in the same run, the same block or further
+                for (ulint j: {i, i + 1, i + 3, i + 40, s.size()})
+                {
+                    if (j > s.size()) continue;
+                    auto rk = rldir.rank_pair(i, j, c);
+                    IUTEST_ASSERT_EQ(rl.rank(i, c), rk.first);
+                    IUTEST_ASSERT_EQ(rl.rank(j, c), rk.second);
+                }
+
+                if (i < s.size() && rl.rank(i + 1, c) > 0)
+                {
+                    auto last = rl.last_run_of(i, c);
+                    auto last_dir = rldir.last_run_of(i, c);
+                    IUTEST_ASSERT_EQ(last.first, last_dir.first);
+                    IUTEST_ASSERT_EQ(last.second, last_dir.second);
+                }
+            }
+            if (i < s.size())
+            {
+                IUTEST_ASSERT_EQ(rl.run_of_position(i), rldir.run_of_position(i));
+                IUTEST_ASSERT_EQ(rl[i], rldir[i]);
+            }
+        }
+        for (ulint j = 0; j < rl.number_of_runs(); ++j) IUTEST_ASSERT_EQ(rl.run_at(j), rldir.run_at(j));
+    }
+}
@@ -0,0 +1,127 @@
+#include "iutest.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/sample_cache.hpp"
+
+using namespace bri;
+
+IUTEST(SampleCacheTest, FindInsert)
+{
+    sample_cache<ulint> cache(1 << 20);
+
+    ulint x = 0;
+    IUTEST_ASSERT_FALSE(cache.find("abc", x));
+    cache.insert("abc", 3);
+    cache.insert("de", 2);
+    IUTEST_ASSERT_TRUE(cache.find("abc", x));
+    IUTEST_ASSERT_EQ(3, x);
+    IUTEST_ASSERT_TRUE(cache.find("de", x));
+    IUTEST_ASSERT_EQ(2, x);
+
+    // a key is cached once, with its last sample
+    cache.insert("abc", 4);
+    IUTEST_ASSERT_TRUE(cache.find("abc", x));
+    IUTEST_ASSERT_EQ(4, x);
+    IUTEST_ASSERT_EQ(2, cache.size());
+
+    IUTEST_ASSERT_EQ(4, cache.lookups());
+    IUTEST_ASSERT_EQ(3, cache.hits());
+    IUTEST_ASSERT_EQ(0.75, cache.hit_rate());
+
+    cache.clear();
+    IUTEST_ASSERT_EQ(0, cache.size());
+    IUTEST_ASSERT_EQ(0, cache.bytes());
+    IUTEST_ASSERT_FALSE(cache.find("abc", x));
+}
+
+IUTEST(SampleCacheTest, MemoryCap)
+{
+    // one shard, so that every key is swept by the same hand
+    ulint cap = 2000;
+    sample_cache<ulint> cache(cap, 1);
+
+    for (ulint i = 0; i < 1000; ++i)
+    {
+        cache.insert(std::to_string(i), i);
+        IUTEST_ASSERT_LE(cache.bytes(), cap);
+
+        // key 0 is kept by being used
+        ulint x = 0;
+        IUTEST_ASSERT_TRUE(cache.find("0", x));
+        IUTEST_ASSERT_EQ(0, x);
+    }
+    IUTEST_ASSERT_GT(cache.evictions(), 0);
+    IUTEST_ASSERT_LT(cache.size(), 1000);
+
+    ulint x = 0;
+    IUTEST_ASSERT_FALSE(cache.find("1", x));
+    IUTEST_ASSERT_TRUE(cache.find("999", x));
+    IUTEST_ASSERT_EQ(999, x);
+
+    // no entry fits in a cap of 0
+    sample_cache<ulint> empty(0);
+    empty.insert("a", 1);
+    IUTEST_ASSERT_EQ(0, empty.size());
+}
+
+IUTEST(SampleCacheTest, Concurrent)
+{
+    ulint cap = 1 << 16;
+    sample_cache<ulint> cache(cap);
+
+    ulint threads = 8;
+    std::vector<ulint> wrong(threads, 0);
+    std::vector<std::thread> pool;
+    for (ulint t = 0; t < threads; ++t)
+    {
+        pool.push_back(std::thread([&cache, &wrong, t]()
+        {
+            for (ulint i = 0; i < 5000; ++i)
+            {
+                // the value of a key is a function of the key
+                ulint k = (i * 7 + t) % 300;
+                ulint x = 0;
+                if (cache.find(std::to_string(k), x)) wrong[t] += x != k;
+                else cache.insert(std::to_string(k), k);
+            }
+        }));
+    }
+    for (auto& th: pool) th.join();
+
+    for (ulint t = 0; t < threads; ++t) IUTEST_ASSERT_EQ(0, wrong[t]);
+    IUTEST_ASSERT_EQ(threads * 5000, cache.lookups());
+    IUTEST_ASSERT_GT(cache.hits(), 0);
+    IUTEST_ASSERT_LE(cache.bytes(), cap);
+}
+
+IUTEST(SampleCacheTest, CopyStartsEmpty)
+{
+    sample_cache_ptr<ulint> none;
+    IUTEST_ASSERT_FALSE(bool(none));
+
+    sample_cache_ptr<ulint> cache;
+    cache.reset(1 << 16);
+    cache->insert("a", 1);
+
+    // copies never share the samples, only the cap
+    sample_cache_ptr<ulint> copy(cache);
+    sample_cache_ptr<ulint> assigned;
+    assigned = cache;
+    for (auto c: {&copy, &assigned})
+    {
+        IUTEST_ASSERT_TRUE(c->get() != cache.get());
+        IUTEST_ASSERT_EQ(cache->max_bytes(), (*c)->max_bytes());
+        IUTEST_ASSERT_EQ(0, (*c)->size());
+    }
+    copy->insert("b", 2);
+    ulint x = 0;
+    IUTEST_ASSERT_FALSE(cache->find("b", x));
+    IUTEST_ASSERT_TRUE(cache->find("a", x));
+
+    sample_cache_ptr<ulint> copy_of_none(none);
+    IUTEST_ASSERT_TRUE(copy_of_none.get() == nullptr);
+    cache.reset(0);
+    IUTEST_ASSERT_TRUE(cache.get() == nullptr);
+}
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <fstream>
+#include <sstream>
 #include "../src/sparse_sd_vector.hpp"
 
 IUTEST(SparseSdVectorTest, AllZeroBasic) {
@@ -171,4 +172,34 @@ IUTEST(SparseSdVectorTest, NumberOfOne)
         bri::sparse_sd_vector bv(vec);
         IUTEST_ASSERT_EQ(bv.number_of_1(),3);
     }
-}
\ No newline at end of file
+}
+IUTEST(SparseSdVectorTest, FromPositions) {
+    std::vector<bool> vec(10000,false);
+    std::vector<ulint> ones;
+    for (ulint i = 3; i < 10000; i += 7)
+    {
+        vec[i] = true;
+        ones.push_back(i);
+    }
+    bri::sparse_sd_vector expected(vec);
+    bri::sparse_sd_vector bv(ones, 10000);
+
+    IUTEST_ASSERT_EQ(expected.size(), bv.size());
+    IUTEST_ASSERT_EQ(expected.number_of_1(), bv.number_of_1());
+    for (size_t i = 0; i < bv.size(); ++i)
+    {
+        IUTEST_ASSERT_EQ(expected[i],bv[i]);
+        IUTEST_ASSERT_EQ(expected.rank(i),bv.rank(i));
+    }
+    for (size_t i = 0; i < bv.number_of_1(); ++i)
+        IUTEST_ASSERT_EQ(ones[i],bv.select(i));
+
+    std::ostringstream expected_out, out;
+    expected.serialize(expected_out);
+    bv.serialize(out);
+    IUTEST_ASSERT_EQ(expected_out.str(), out.str());
+
+    bri::sparse_sd_vector empty(std::vector<ulint>(), 100);
+    IUTEST_ASSERT_EQ(100, empty.size());
+    IUTEST_ASSERT_EQ(0, empty.number_of_1());
+}
@@ -0,0 +1,75 @@
+#include "iutest.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <vector>
+#include "../src/work_stealing_pool.hpp"
+
+using namespace bri;
+
+IUTEST(WorkStealingPoolTest, EveryTaskOnce)
+{
+    for (ulint threads: {1, 2, 3, 8})
+    {
+        for (ulint tasks: {0, 1, 5, 1000})
+        {
+            work_stealing_pool pool(threads);
+            IUTEST_ASSERT_EQ(threads, pool.size());
+
+            std::vector<std::atomic<ulint> > runs(tasks);
+            for (auto& r: runs) r = 0;
+            std::atomic<ulint> bad_thread(0);
+
+            pool.run(tasks, [&](ulint task, ulint t)
+            {
+                runs[task]++;
+                if (t >= threads) bad_thread++;
+            });
+
+            for (auto& r: runs) IUTEST_ASSERT_EQ(1, r.load());
+            IUTEST_ASSERT_EQ(0, bad_thread.load());
+        }
+    }
+}
+
+IUTEST(WorkStealingPoolTest, UnevenTasks)
+{
+    // the tasks of thread 0 are slow, so the other threads must steal them
+    ulint tasks = 64;
+    work_stealing_pool pool(4);
+
+    std::vector<ulint> ran_by(tasks);
+    pool.run(tasks, [&](ulint task, ulint t)
+    {
+        if (task < tasks / 4) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        ran_by[task] = t;
+    });
+
+    ulint stolen = 0;
+    for (ulint task = 0; task < tasks / 4; ++task) stolen += ran_by[task] != 0;
+    IUTEST_ASSERT_GT(stolen, 0);
+}
+
+IUTEST(WorkStealingPoolTest, OrderedOutput)
+{
+    ulint tasks = 200;
+    for (ulint threads: {1, 4})
+    {
+        std::ostringstream out;
+        {
+            work_stealing_pool pool(threads);
+            ordered_output output(out, tasks);
+            pool.run(tasks, [&](ulint task, ulint)
+            {
+                std::ostringstream s;
+                s << task << "\n";
+                output.done(task, s.str());
+            });
+        }
+
+        std::ostringstream expected;
+        for (ulint task = 0; task < tasks; ++task) expected << task << "\n";
+        IUTEST_ASSERT_EQ(expected.str(), out.str());
+    }
+}